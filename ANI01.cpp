@@ -13,7 +13,7 @@
 #include "manimation_ext.h"
 #include "resource.h"
 
-// StarBorderElement: simulates the JS/CSS StarBorder effect using generated radial gradient bitmaps
+// StarBorderElement: simulates the JS/CSS StarBorder effect using cached radial gradient bitmaps
 class StarBorderElement : public MUI::UIElement {
 public:
     MUI::Color color = MUI::Color(255, 255, 255, 200);
@@ -26,6 +26,10 @@ public:
 
     manim::Animator animator;
 
+    // one cached glow picture per glow, reused every frame (only its transform changes)
+    MUI::TextureCache::Instance bottomGlow;
+    MUI::TextureCache::Instance topGlow;
+
     StarBorderElement() {
         rect = { 0,0,200,64 };
         // prepare timeline and transitions
@@ -48,44 +52,35 @@ public:
     void setSpeed(float s) { speed = s; animator.getTimeline().setDuration(speed); }
     void setThickness(float t) { thickness = t; }
 
-    // generate a simple radial gradient RGBA buffer (center->transparent)
-    static std::vector<unsigned char> makeRadialRGBA(int w, int h, const MUI::Color& c) {
-        std::vector<unsigned char> buf(w * h * 4);
-        float cx = w * 0.5f;
-        float cy = h * 0.5f;
-        float maxr = std::sqrt(cx*cx + cy*cy);
-        for (int y = 0; y < h; ++y) {
-            for (int x = 0; x < w; ++x) {
-                float dx = x - cx;
-                float dy = y - cy;
-                float d = std::sqrt(dx*dx + dy*dy);
-                float t = std::clamp(1.0f - d / maxr, 0.0f, 1.0f);
-                // apply ease to alpha for smoother falloff
-                float alpha = t * t; // quadratic falloff
-                unsigned char a = static_cast<unsigned char>(alpha * c.a);
-                int idx = (y * w + x) * 4;
-                // store as RGBA like stb_image produces
-                buf[idx + 0] = c.r; // R
-                buf[idx + 1] = c.g; // G
-                buf[idx + 2] = c.b; // B
-                buf[idx + 3] = a;   // A
-            }
-        }
-        return buf;
-    }
-
     void update(float dt) override {
         animator.update(dt);
     }
 
+    // push a cached radial glow centered at (cx, cy); only size/position change per frame
+    void pushGlow(tvg::Scene* parent, MUI::TextureCache::Instance& glow, int texW, int texH,
+        float cx, float cy, float diameter, uint8_t fallbackAlpha) {
+        auto pic = MUI::TextureCache::getDefault().radialGlow(glow, texW, texH, color);
+        if (pic) {
+            pic->size(diameter, diameter * texH / (float)texW);
+            pic->translate(cx - diameter * 0.5f, cy - diameter * texH / (float)texW * 0.5f);
+            parent->push(pic);
+        }
+        else {
+            // fallback: draw simple circle
+            auto sh = tvg::Shape::gen();
+            sh->appendCircle(cx, cy, diameter * 0.5f, diameter * 0.5f);
+            sh->fill(color.r, color.g, color.b, fallbackAlpha);
+            parent->push(sh);
+        }
+    }
+
     void render(tvg::Scene* parent) override {
         if (!visible) return;
 
         float w = rect.w, h = rect.h;
-        // generate gradient textures (small size, will be scaled)
+        // glow texture is generated once per color by the texture cache (small size, will be scaled)
         const int TEX_W = 256;
         const int TEX_H = 256;
-        auto buf = makeRadialRGBA(TEX_W, TEX_H, color);
 
         // bottom: move right -> left (offset 0..1)
         float bigW = std::max(w, h) * 1.8f;
@@ -100,42 +95,8 @@ public:
         float cxT = startXt + (endXt - startXt) * topOffset;
         float cyT = rect.y + h * 0.15f;
 
-        // create picture for bottom glow (copy data into tvg)
-        {
-            auto picB = tvg::Picture::gen();
-            auto result = picB->load(reinterpret_cast<const uint32_t*>(buf.data()), TEX_W, TEX_H, tvg::ColorSpace::ABGR8888, true);
-            if (result == tvg::Result::Success) {
-                float scale = bigW / (float)TEX_W;
-                picB->size(TEX_W * scale, TEX_H * scale);
-                picB->translate(cxB - (TEX_W * scale) * 0.5f, cyB - (TEX_H * scale) * 0.5f);
-                parent->push(picB);
-            }
-            else {
-                // fallback: draw simple circle
-                auto shB = tvg::Shape::gen();
-                shB->appendCircle(cxB, cyB, bigW * 0.5f, bigW * 0.5f);
-                shB->fill(color.r, color.g, color.b, 120);
-                parent->push(std::move(shB));
-            }
-        }
-
-        // top glow
-        {
-            auto picT = tvg::Picture::gen();
-            auto result = picT->load(reinterpret_cast<const uint32_t*>(buf.data()), TEX_W, TEX_H, tvg::ColorSpace::ABGR8888, true);
-            if (result == tvg::Result::Success) {
-                float scale = bigW / (float)TEX_W;
-                picT->size(TEX_W * scale, TEX_H * scale);
-                picT->translate(cxT - (TEX_W * scale) * 0.5f, cyT - (TEX_H * scale) * 0.5f);
-                parent->push(picT);
-            }
-            else {
-                auto shT = tvg::Shape::gen();
-                shT->appendCircle(cxT, cyT, bigW * 0.5f, bigW * 0.5f);
-                shT->fill(color.r, color.g, color.b, 100);
-                parent->push(std::move(shT));
-            }
-        }
+        pushGlow(parent, bottomGlow, TEX_W, TEX_H, cxB, cyB, bigW, 120);   // bottom glow
+        pushGlow(parent, topGlow, TEX_W, TEX_H, cxT, cyT, bigW, 100);      // top glow
 
         // inner rounded rect (content area)
         float corner = std::min(16.0f, h * 0.5f);
@@ -39,6 +39,7 @@
 #include <mutex>
 #include <thread>
 #include <condition_variable>
+#include <chrono>
 
 #define NOMINMAX
 #include <windows.h>
@@ -64,10 +65,12 @@ enum class VideoFormat : std::uint32_t {
 //---------------------------------------------------------------------------
 // Żݽṹ
 // - ʹ<stdint.h>/<cstdint>еĹ̶
-// - ȷȨ`pixels``samples`ʹöѷ䣬߸ͷţͨͷ
+// - ȷȨ`pixels``samples`֡ͷһ`MediaPool`ͨ黹
 // - `dataBytes`/`stride`Ⱦ
 // - ӿԼ
 //---------------------------------------------------------------------------
+class MediaPool;
+
 typedef struct VideoFrame
 {
     std::uint32_t seek_generation;  // Σڶ֡
@@ -79,6 +82,8 @@ typedef struct VideoFrame
     std::uint32_t stride;           // ÿֽ(ARGB32: width*4)
     std::uint32_t dataBytes;        // ֽ
     std::uint8_t* pixels;           // ԭʼػ(ѷ)
+    std::uint32_t capacity;         // pixels ʵ(ֽڣ>= dataBytes)
+    MediaPool*    pool;             // ճأΪձʾͨѷ
     VideoFrame*   next;             // һ
 } VideoFrame;
 
@@ -91,37 +96,318 @@ typedef struct AudioPacket
     std::int32_t  frames;           // ֡(ÿ֡=channels)
     std::uint32_t dataFloats;       // =frames*channels
     float*        samples;          // PCM(f32)ΪdataFloats
+    std::uint32_t capacity;         // samples ʵ(>= dataFloats)
+    MediaPool*    pool;             // ճأΪձʾͨѷ
     AudioPacket*  next;             // һ
 } AudioPacket;
 
-// 򵥵ĸͷźȷ
+//---------------------------------------------------------------------------
+// MediaPool: VideoFrame/AudioPacket ճ
+// - ֡ͷݻΪһ建棬Ѻ黹(freeVideoFrameChain/freeAudioPacketChain)
+//    free̬벻ٴѷ
+// - ּÿ 2 ٷ 4 ˷Ѳ 25%(1080p ARGB Լ 1%)
+// - ÿ(̶)ֱͷţֱлռڴ
+// - üһݣÿ֡һݣʱ֡Կɰȫ黹
+//---------------------------------------------------------------------------
+class MediaPool {
+public:
+    struct Stats {
+        std::uint64_t heapAllocs = 0;   // ·֡/(ݻ)
+        std::uint64_t reused = 0;       // ӿõĴ
+        std::uint64_t dropped = 0;      // 黹ʱ򳬳޶ͷŵĴ
+        std::uint32_t idleVideo = 0;    // ǰеƵ֡
+        std::uint32_t idleAudio = 0;    // ǰеƵ
+    };
+
+    MediaPool() = default;
+    MediaPool(const MediaPool&) = delete;
+    MediaPool& operator=(const MediaPool&) = delete;
+
+    // ÿ໺ĿƵ֡Ĭ֡
+    void setLimits(std::uint32_t maxIdleVideo, std::uint32_t maxIdleAudio) {
+        std::lock_guard<std::mutex> lock(mtx);
+        videoLimit = maxIdleVideo;
+        audioLimit = maxIdleAudio;
+    }
+
+    // ȡһػΪ bytes Ƶ֡pixels/dataBytes/pool ãֶɵ
+    VideoFrame* acquireVideo(std::uint32_t bytes) {
+        const int cls = classOf(bytes);
+        VideoFrame* vf = nullptr;
+        if (cls >= 0) {
+            std::lock_guard<std::mutex> lock(mtx);
+            vf = idleVideo[cls];
+            if (vf) { idleVideo[cls] = vf->next; --idleVideoCount[cls]; ++stats.reused; }
+        }
+        if (!vf) {
+            const std::uint32_t cap = cls >= 0 ? capacityOf(cls) : bytes;
+            vf = (VideoFrame*)std::malloc(sizeof(VideoFrame));
+            std::uint8_t* px = vf ? (std::uint8_t*)std::malloc(cap) : nullptr;
+            if (!px) { std::free(vf); return nullptr; }
+            vf->pixels = px;
+            vf->capacity = cap;
+            std::lock_guard<std::mutex> lock(mtx);
+            ++stats.heapAllocs;
+        }
+        vf->dataBytes = bytes;
+        vf->pool = this;
+        vf->next = nullptr;
+        refs.fetch_add(1, std::memory_order_relaxed);
+        return vf;
+    }
+
+    // ȡһΪ floats Ƶ
+    AudioPacket* acquireAudio(std::uint32_t floats) {
+        const int cls = classOf(floats);
+        AudioPacket* ap = nullptr;
+        if (cls >= 0) {
+            std::lock_guard<std::mutex> lock(mtx);
+            ap = idleAudio[cls];
+            if (ap) { idleAudio[cls] = ap->next; --idleAudioCount[cls]; ++stats.reused; }
+        }
+        if (!ap) {
+            const std::uint32_t cap = cls >= 0 ? capacityOf(cls) : floats;
+            ap = (AudioPacket*)std::malloc(sizeof(AudioPacket));
+            float* buf = ap ? (float*)std::malloc(sizeof(float) * (std::size_t)cap) : nullptr;
+            if (!buf) { std::free(ap); return nullptr; }
+            ap->samples = buf;
+            ap->capacity = cap;
+            std::lock_guard<std::mutex> lock(mtx);
+            ++stats.heapAllocs;
+        }
+        ap->dataFloats = floats;
+        ap->pool = this;
+        ap->next = nullptr;
+        refs.fetch_add(1, std::memory_order_relaxed);
+        return ap;
+    }
+
+    // 黹֡/(next ֶλᱻ)
+    void recycle(VideoFrame* vf) {
+        const int cls = classOf(vf->capacity);
+        bool kept = false;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (!closed && cls >= 0 && capacityOf(cls) == vf->capacity && idleVideoCount[cls] < videoLimit) {
+                vf->next = idleVideo[cls]; idleVideo[cls] = vf; ++idleVideoCount[cls];
+                kept = true;
+            }
+            else ++stats.dropped;
+        }
+        if (!kept) { std::free(vf->pixels); std::free(vf); }
+        release();
+    }
+    void recycle(AudioPacket* ap) {
+        const int cls = classOf(ap->capacity);
+        bool kept = false;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (!closed && cls >= 0 && capacityOf(cls) == ap->capacity && idleAudioCount[cls] < audioLimit) {
+                ap->next = idleAudio[cls]; idleAudio[cls] = ap; ++idleAudioCount[cls];
+                kept = true;
+            }
+            else ++stats.dropped;
+        }
+        if (!kept) { std::free(ap->samples); std::free(ap); }
+        release();
+    }
+
+    // ͷпл(ֱʱ仯ֹͣź)
+    void trim() {
+        VideoFrame* vHead = nullptr;
+        AudioPacket* aHead = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            for (int c = 0; c < ClassCount; ++c) {
+                while (VideoFrame* vf = idleVideo[c]) { idleVideo[c] = vf->next; vf->next = vHead; vHead = vf; }
+                while (AudioPacket* ap = idleAudio[c]) { idleAudio[c] = ap->next; ap->next = aHead; aHead = ap; }
+                idleVideoCount[c] = idleAudioCount[c] = 0;
+            }
+        }
+        while (vHead) { VideoFrame* nxt = vHead->next; std::free(vHead->pixels); std::free(vHead); vHead = nxt; }
+        while (aHead) { AudioPacket* nxt = aHead->next; std::free(aHead->samples); std::free(aHead); aHead = nxt; }
+    }
+
+    // ߷Уտ֮黹ֱ֡ͷţһ֡黹ʱ
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            closed = true;
+        }
+        trim();
+        release();
+    }
+
+    Stats getStats() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        Stats s = stats;
+        for (int c = 0; c < ClassCount; ++c) { s.idleVideo += idleVideoCount[c]; s.idleAudio += idleAudioCount[c]; }
+        return s;
+    }
+
+private:
+    // ּ256 𲽣ÿ 2  4  2^31 
+    static constexpr int ClassCount = 4 * (31 - 8) + 1;
+
+    static std::uint32_t capacityOf(int cls) {
+        const int e = 8 + cls / 4;
+        return (1u << e) + (std::uint32_t)(cls % 4) * (1u << (e - 2));
+    }
+    static int classOf(std::uint32_t n) {
+        if (n <= 256u) return 0;
+        const std::uint32_t v = n - 1;
+        int e = 0;
+        while ((v >> (e + 1)) != 0) ++e;                    // floor(log2(n - 1))
+        int m = (int)((v - (1u << e)) >> (e - 2)) + 1;      // ڵĵڼ
+        if (m == 4) { ++e; m = 0; }
+        const int cls = (e - 8) * 4 + m;
+        return cls < ClassCount ? cls : -1;
+    }
+
+    void release() {
+        if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this;
+    }
+
+    mutable std::mutex mtx;
+    std::atomic<std::uint32_t> refs{ 1 };
+    bool closed = false;
+    std::uint32_t videoLimit = 8;
+    std::uint32_t audioLimit = 64;
+    VideoFrame* idleVideo[ClassCount] = {};
+    AudioPacket* idleAudio[ClassCount] = {};
+    std::uint32_t idleVideoCount[ClassCount] = {};
+    std::uint32_t idleAudioCount[ClassCount] = {};
+    Stats stats;
+};
+
+// ͷ/黹ط֡ص MediaPoolఴԭʽ free
 static inline void freeVideoFrameChain(VideoFrame* head) {
     while (head) {
         VideoFrame* nxt = head->next;
-        if (head->pixels) { free(head->pixels); head->pixels = nullptr; }
-        free(head);
+        if (head->pool) head->pool->recycle(head);
+        else {
+            if (head->pixels) { free(head->pixels); head->pixels = nullptr; }
+            free(head);
+        }
         head = nxt;
     }
 }
 static inline void freeAudioPacketChain(AudioPacket* head) {
     while (head) {
         AudioPacket* nxt = head->next;
-        if (head->samples) { free(head->samples); head->samples = nullptr; }
-        free(head);
+        if (head->pool) head->pool->recycle(head);
+        else {
+            if (head->samples) { free(head->samples); head->samples = nullptr; }
+            free(head);
+        }
         head = nxt;
     }
 }
 
+//---------------------------------------------------------------------------
+// SpscRing: /н绷ζ()
+// - ߳ push߳ pop/peek˸ֻдԼ±꣬
+// - Ϊ 2 ݣ߼ depth ԸСʱ push  falseɵ߾ȴ
+// - ˻Զ±ֻ꣬п/ʱ¶ȡٻ
+//---------------------------------------------------------------------------
+template <typename T>
+class SpscRing {
+public:
+    // ˶ʱ(start ֮ǰ / stop ֮)
+    void reset(std::uint32_t depth) {
+        if (depth < 1) depth = 1;
+        std::uint32_t cap = 1;
+        while (cap < depth) cap <<= 1;
+        slots.assign(cap, nullptr);
+        mask = cap - 1;
+        limit = depth;
+        head.store(0, std::memory_order_relaxed);
+        tail.store(0, std::memory_order_relaxed);
+        headCache = tailCache = 0;
+    }
+
+    // 
+    bool push(T* item) {
+        const std::uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t - headCache >= limit) {
+            headCache = head.load(std::memory_order_acquire);
+            if (t - headCache >= limit) return false;
+        }
+        slots[t & mask] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+    bool full() {
+        const std::uint32_t t = tail.load(std::memory_order_relaxed);
+        headCache = head.load(std::memory_order_acquire);
+        return t - headCache >= limit;
+    }
+
+    // 
+    T* peek() {
+        const std::uint32_t h = head.load(std::memory_order_relaxed);
+        if (h == tailCache) {
+            tailCache = tail.load(std::memory_order_acquire);
+            if (h == tailCache) return nullptr;
+        }
+        return slots[h & mask];
+    }
+    T* pop() {
+        T* item = peek();
+        if (item) head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        return item;
+    }
+
+    // һ˾ɵãΪֵ
+    std::uint32_t size() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+    std::uint32_t depth() const { return limit; }
+
+private:
+    alignas(64) std::atomic<std::uint32_t> head{ 0 };  // д
+    std::uint32_t tailCache = 0;                        // ˽
+    alignas(64) std::atomic<std::uint32_t> tail{ 0 };  // д
+    std::uint32_t headCache = 0;                        // ˽
+    alignas(64) std::vector<T*> slots;
+    std::uint32_t mask = 0;
+    std::uint32_t limit = 1;
+};
+
+// ãȰƵ֡ƵƵʱ(ms)
+enum class QueueMode {
+    Blocking,   // ʱ߳ߣֱѶȡ(Ĭ)
+    WaitFree    // ̴߳Ӳȴʱ½֡/
+};
+
+struct QueueConfig {
+    std::uint32_t videoFrames = 8;      // Ƶ໺֡
+    std::uint32_t audioPackets = 128;   // Ƶ໺İ
+    std::uint32_t audioMs = 500;        // Ƶ໺ʱ()
+    QueueMode     mode = QueueMode::Blocking;
+};
+
+struct QueueStats {
+    std::uint32_t videoQueued = 0;      // ǰŶӵƵ֡
+    std::uint32_t audioQueued = 0;      // ǰŶӵƵ
+    std::uint32_t audioQueuedMs = 0;    // ǰŶӵƵʱ
+    std::uint64_t producerWaits = 0;    // ߳ߵĴ
+    std::uint64_t droppedVideo = 0;     // WaitFree ģʽ¶Ƶ֡
+    std::uint64_t droppedAudio = 0;     // WaitFree ģʽ¶Ƶ
+    std::uint64_t staleFlushed = 0;     //  seek ιڶ֡/
+};
+
 //---------------------------------------------------------------------------
 // MDecoder: ߳Ogg (Theora + Vorbis)
-// - ȡOggļں̨߳̽ΪVideoFrame/AudioPacket
-// - ṩȡӿpopVideo/popAudioڻȡѽ
+// - ȡOggļں̨߳̽ΪVideoFrame/AudioPacket
+// - нSPSCн̣߳peek/pop ȡpopVideo/popAudio һȡ
+// - ʱ߳(ѹ)ڴռ QueueConfig ޶
 // - ֹ֧ͣαʶ
 //---------------------------------------------------------------------------
 class MDecoder {
 public:
     MDecoder() = default;
-    ~MDecoder() { stop(); }
+    ~MDecoder() { stop(); pool->close(); }
 
     bool start(const std::wstring& path) {
         stop();
@@ -132,6 +418,10 @@ public:
             return false;
         }
         infile = f;
+        activeQueue = queueConfig;
+        videoQueue.reset(activeQueue.videoFrames);
+        audioQueue.reset(activeQueue.audioPackets);
+        queuedAudioFrames.store(0);
         seekGeneration.store(seekGeneration.load() + 1); // 
         quit.store(false);
         eof.store(false);
@@ -142,28 +432,97 @@ public:
 
     void stop() {
         quit.store(true);
+        {
+            std::lock_guard<std::mutex> lock(mtxWait);   // ߵĽ߳
+            cvSpace.notify_all();
+        }
         if (worker.joinable()) worker.join();
         cleanup();
     }
 
-    // ȡһ֡ƵͷѺͷţ
+    // в( start() ֮ǰã´ start Ч)
+    void setQueueConfig(const QueueConfig& config) { queueConfig = config; }
+
+    // 鿴Ƶ֡ȡ(̵߳)ڴε֡ڴ˶
+    const VideoFrame* peekVideo() {
+        for (;;) {
+            VideoFrame* vf = videoQueue.peek();
+            if (!vf || vf->seek_generation == seekGeneration.load(std::memory_order_acquire)) return vf;
+            videoQueue.pop();
+            staleFlushed.fetch_add(1, std::memory_order_relaxed);
+            freeVideoFrameChain(vf);
+            notifyProducer();
+        }
+    }
+
+    // ȡһ֡Ƶͨ freeVideoFrameChain 黹
+    VideoFrame* popVideoFrame() {
+        if (!peekVideo()) return nullptr;
+        VideoFrame* vf = videoQueue.pop();
+        notifyProducer();
+        return vf;
+    }
+
+    // ȡǰȫƵ֡ͷѺͷţ
     VideoFrame* popVideo() {
-        std::lock_guard<std::mutex> lock(mtxVideo);
-        VideoFrame* head = videoHead;
-        videoHead = nullptr;
-        videoTail = nullptr;
+        VideoFrame* head = nullptr;
+        VideoFrame* tail = nullptr;
+        while (VideoFrame* vf = popVideoFrame()) {
+            if (!head) head = vf; else tail->next = vf;
+            tail = vf;
+        }
         return head;
     }
 
-    // ȡһƵͷѺͷţ
+    const AudioPacket* peekAudio() {
+        for (;;) {
+            AudioPacket* ap = audioQueue.peek();
+            if (!ap || ap->seek_generation == seekGeneration.load(std::memory_order_acquire)) return ap;
+            audioQueue.pop();
+            queuedAudioFrames.fetch_sub(ap->frames, std::memory_order_release);
+            staleFlushed.fetch_add(1, std::memory_order_relaxed);
+            freeAudioPacketChain(ap);
+            notifyProducer();
+        }
+    }
+
+    AudioPacket* popAudioPacket() {
+        if (!peekAudio()) return nullptr;
+        AudioPacket* ap = audioQueue.pop();
+        queuedAudioFrames.fetch_sub(ap->frames, std::memory_order_release);
+        notifyProducer();
+        return ap;
+    }
+
+    // ȡǰȫƵͷѺͷţ
     AudioPacket* popAudio() {
-        std::lock_guard<std::mutex> lock(mtxAudio);
-        AudioPacket* head = audioHead;
-        audioHead = nullptr;
-        audioTail = nullptr;
+        AudioPacket* head = nullptr;
+        AudioPacket* tail = nullptr;
+        while (AudioPacket* ap = popAudioPacket()) {
+            if (!head) head = ap; else tail->next = ap;
+            tail = ap;
+        }
         return head;
     }
 
+    QueueStats getQueueStats() const {
+        QueueStats s;
+        s.videoQueued = videoQueue.size();
+        s.audioQueued = audioQueue.size();
+        const std::int64_t frames = queuedAudioFrames.load(std::memory_order_relaxed);
+        const std::int32_t freq = queueFreq.load(std::memory_order_relaxed);
+        s.audioQueuedMs = (freq > 0 && frames > 0) ? (std::uint32_t)(frames * 1000 / freq) : 0;
+        s.producerWaits = producerWaits.load(std::memory_order_relaxed);
+        s.droppedVideo = droppedVideo.load(std::memory_order_relaxed);
+        s.droppedAudio = droppedAudio.load(std::memory_order_relaxed);
+        s.staleFlushed = staleFlushed.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    // ֡/ճأɵ޻ѯͳ
+    MediaPool& getPool() { return *pool; }
+    MediaPool::Stats getPoolStats() const { return pool->getStats(); }
+
 private:
     // ̹̣߳οSDLPlayer5.cppḶ̌
     void decodeThreadProc() {
@@ -259,6 +618,8 @@ private:
             if (vorbis_block_init(&vd, &vb) != 0) return false;
             aFreq = vi.rate;
             aChannels = (vi.channels > 2) ? 2 : (vi.channels < 1 ? 1 : vi.channels);
+            audioFrameLimit = (std::int64_t)activeQueue.audioMs * aFreq / 1000;
+            queueFreq.store(aFreq);
         }
         startTicks = timeGetTime();
         return true;
@@ -298,15 +659,65 @@ private:
         }
     }
 
+    // ʱıѹBlocking ģʽߵѶȡݣ
+    //  false ʾӦǰ֡/(WaitFree ģʽ˳ seek ʹ)
+    template <typename Full>
+    bool waitForSpace(Full isFull, std::uint32_t gen) {
+        if (activeQueue.mode == QueueMode::WaitFree) return false;
+        producerWaits.fetch_add(1, std::memory_order_relaxed);
+        std::unique_lock<std::mutex> lock(mtxWait);
+        producerWaiting.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool ok = true;
+        while (isFull()) {
+            if (quit.load() || gen != seekGeneration.load()) { ok = false; break; }
+            // ѶȡݺỽѣʱֻǶ
+            cvSpace.wait_for(lock, std::chrono::milliseconds(20));
+        }
+        producerWaiting.store(false, std::memory_order_relaxed);
+        return ok;
+    }
+
+    // Ѷȡݺãڽ߳ȷʵڵȴʱż֪ͨ
+    void notifyProducer() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (producerWaiting.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(mtxWait);
+            cvSpace.notify_one();
+        }
+    }
+
     void pushVideoFrame(VideoFrame* vf) {
-        std::lock_guard<std::mutex> lock(mtxVideo);
-        if (!videoHead) { videoHead = vf; videoTail = vf; }
-        else { videoTail->next = vf; videoTail = vf; }
+        while (!videoQueue.push(vf)) {
+            if (!waitForSpace([this] { return videoQueue.full(); }, vf->seek_generation)) {
+                if (activeQueue.mode == QueueMode::WaitFree) droppedVideo.fetch_add(1, std::memory_order_relaxed);
+                freeVideoFrameChain(vf);
+                return;
+            }
+        }
     }
+
+    bool audioFull() {
+        return audioQueue.full() ||
+            (audioFrameLimit > 0 && queuedAudioFrames.load(std::memory_order_acquire) >= audioFrameLimit);
+    }
+
     void pushAudioPacket(AudioPacket* ap) {
-        std::lock_guard<std::mutex> lock(mtxAudio);
-        if (!audioHead) { audioHead = ap; audioTail = ap; }
-        else { audioTail->next = ap; audioTail = ap; }
+        if (audioFull() && !waitForSpace([this] { return audioFull(); }, ap->seek_generation)) {
+            if (activeQueue.mode == QueueMode::WaitFree) droppedAudio.fetch_add(1, std::memory_order_relaxed);
+            freeAudioPacketChain(ap);
+            return;
+        }
+        // ȼʱٷѶ˼ȥʱֵָ
+        queuedAudioFrames.fetch_add(ap->frames, std::memory_order_relaxed);
+        audioQueue.push(ap);
+    }
+
+    // (ڽ߳δʱ)
+    void drainQueues() {
+        while (VideoFrame* vf = videoQueue.pop()) freeVideoFrameChain(vf);
+        while (AudioPacket* ap = audioQueue.pop()) freeAudioPacketChain(ap);
+        queuedAudioFrames.store(0);
     }
 
     void decodeLoop() {
@@ -343,9 +754,9 @@ private:
                     // Ϊf32 interleaved
                     int outCh = aChannels;
                     std::size_t floats = (std::size_t)samples * (std::size_t)outCh;
-                    float* buf = (float*)std::malloc(sizeof(float) * floats);
-                    if (!buf) { vorbis_synthesis_read(&vd, samples); break; }
-                    float* dst = buf;
+                    AudioPacket* ap = pool->acquireAudio((std::uint32_t)floats);
+                    if (!ap) { vorbis_synthesis_read(&vd, samples); break; }
+                    float* dst = ap->samples;
                     for (int i = 0; i < samples; ++i) {
                         float L = 0.f, R = 0.f;
                         if (vi.channels == 1) { L = R = pcm[0][i]; }
@@ -363,16 +774,11 @@ private:
                     }
                     // 㲥ʱ(ms)
                     std::uint32_t nowms = (std::uint32_t)(timeGetTime() - startTicks);
-                    AudioPacket* ap = (AudioPacket*)std::malloc(sizeof(AudioPacket));
-                    if (!ap) { std::free(buf); vorbis_synthesis_read(&vd, samples); break; }
                     ap->seek_generation = gen;
                     ap->playms = nowms;
                     ap->channels = outCh;
                     ap->freq = aFreq;
                     ap->frames = samples;
-                    ap->dataFloats = (std::uint32_t)floats;
-                    ap->samples = buf;
-                    ap->next = nullptr;
                     pushAudioPacket(ap);
                     vorbis_synthesis_read(&vd, samples);
                 }
@@ -383,18 +789,15 @@ private:
                 if (th_decode_packetin(td, &op, &gran) == 0) {
                     double vtime = th_granule_time(td, gran);
                     if (vtime < 0.0) vtime = (double)(timeGetTime() - startTicks) / 1000.0;
-                    // زת
+                    // ӻճȡػ岢ת
                     std::uint32_t stride = (std::uint32_t)vWidth * 4u;
                     std::uint32_t bytes = stride * (std::uint32_t)vHeight;
-                    std::uint8_t* px = (std::uint8_t*)std::malloc(bytes);
-                    if (!px) { /* OOM */ }
-                    th_decode_ycbcr_out(td, yuv);
-                    yuv420ToARGB(yuv, px, stride);
-                    // 㲥ʱ(ms)
-                    std::uint32_t playms = (std::uint32_t)std::llround(vtime * 1000.0);
-                    VideoFrame* vf = (VideoFrame*)std::malloc(sizeof(VideoFrame));
-                    if (!vf) { std::free(px); }
-                    else {
+                    VideoFrame* vf = pool->acquireVideo(bytes);
+                    if (vf) {
+                        th_decode_ycbcr_out(td, yuv);
+                        yuv420ToARGB(yuv, vf->pixels, stride);
+                        // 㲥ʱ(ms)
+                        std::uint32_t playms = (std::uint32_t)std::llround(vtime * 1000.0);
                         vf->seek_generation = gen;
                         vf->playms = playms;
                         vf->fps = vFps;
@@ -402,9 +805,6 @@ private:
                         vf->height = (std::uint32_t)vHeight;
                         vf->format = VideoFormat::ARGB32;
                         vf->stride = stride;
-                        vf->dataBytes = bytes;
-                        vf->pixels = px;
-                        vf->next = nullptr;
                         pushVideoFrame(vf);
                     }
                 }
@@ -415,14 +815,7 @@ private:
     void cleanup() {
         if (infile) { std::fclose(infile); infile = nullptr; }
         // ն
-        {
-            std::lock_guard<std::mutex> lock(mtxVideo);
-            freeVideoFrameChain(videoHead); videoHead = nullptr; videoTail = nullptr;
-        }
-        {
-            std::lock_guard<std::mutex> lock(mtxAudio);
-            freeAudioPacketChain(audioHead); audioHead = nullptr; audioTail = nullptr;
-        }
+        drainQueues();
     }
 
 private:
@@ -433,13 +826,21 @@ private:
     std::atomic<bool> eof{ false };
     std::atomic<std::uint32_t> seekGeneration{ 0 };
 
-    // Уͷβ
-    VideoFrame* videoHead = nullptr;
-    VideoFrame* videoTail = nullptr;
-    AudioPacket* audioHead = nullptr;
-    AudioPacket* audioTail = nullptr;
-    std::mutex mtxVideo;
-    std::mutex mtxAudio;
+    // (SPSC ζУ߳д̶߳)
+    SpscRing<VideoFrame> videoQueue;
+    SpscRing<AudioPacket> audioQueue;
+    QueueConfig queueConfig;                        // setQueueConfig д룬start ʱЧ
+    QueueConfig activeQueue;                        // νʹõ
+    std::atomic<std::int64_t> queuedAudioFrames{ 0 };
+    std::int64_t audioFrameLimit = 0;               //  audioMs ʻ㣬0 ʾʱ
+    std::atomic<std::int32_t> queueFreq{ 0 };
+    std::mutex mtxWait;                             // ڽ߳/ѣ
+    std::condition_variable cvSpace;
+    std::atomic<bool> producerWaiting{ false };
+    std::atomic<std::uint64_t> producerWaits{ 0 };
+    std::atomic<std::uint64_t> droppedVideo{ 0 };
+    std::atomic<std::uint64_t> droppedAudio{ 0 };
+    std::atomic<std::uint64_t> staleFlushed{ 0 };
 
     // Ogg/Theora/Vorbis״̬
     ogg_sync_state   oy{};
@@ -467,6 +868,9 @@ private:
     double vFps = 0.0;
     int aFreq = 0, aChannels = 0;
     DWORD startTicks = 0;
+
+    // ֡/ճ(üʱ close)
+    MediaPool* pool = new MediaPool();
 };
 
 
@@ -542,7 +946,6 @@ int main(int argc, char** argv) {
 
 #include <gdiplus.h>
 #include <mmsystem.h>
-#include <deque>
 #include <algorithm>
 
 #pragma comment(lib, "Gdiplus.lib")
@@ -600,8 +1003,9 @@ static void drawFrameToWindow(HWND hwnd, const VideoFrame* vf)
 static void freeVideoFrame(VideoFrame*& vf)
 {
     if (!vf) return;
-    if (vf->pixels) { free(vf->pixels); vf->pixels = nullptr; }
-    free(vf); vf = nullptr;
+    vf->next = nullptr;
+    freeVideoFrameChain(vf);   // 黹Ļճ
+    vf = nullptr;
 }
 
 } // namespace DemoPlayer
@@ -650,20 +1054,16 @@ int main(int argc, char** argv)
     // Իȡһ֡ȷڴС
     int wndW = 800, wndH = 480;
     {
-        VideoFrame* vfFirst = nullptr;
+        // ֻ鿴ȡһ֡ڶаʱʾ
+        const VideoFrame* vfFirst = nullptr;
         for (int i = 0; i < 50 && !vfFirst; ++i) {
             Sleep(50);
-            vfFirst = dec.popVideo();
+            vfFirst = dec.peekVideo();
         }
         if (vfFirst) {
             wndW = (int)vfFirst->width;
             wndH = (int)vfFirst->height;
         }
-        // ǻ֮vfFirstͷƻضУ
-        if (vfFirst) {
-            // ֱһ֡ʾ
-            // ʱ£Ϊcurrent
-        }
     }
 
     HWND hwnd = CreateWindowExW(0, kCls, L"MDecoder GDI+ + WaveOut Player",
@@ -689,7 +1089,6 @@ int main(int argc, char** argv)
     DWORD audioSampleRate = 0;
     DWORD audioClockMs = 0;
 
-    std::deque<VideoFrame*> vQueue;
     SharedVideo shared;
 
     // ѭ
@@ -721,12 +1120,7 @@ int main(int argc, char** argv)
             }
         }
 
-        // ӽȡ
-        if (VideoFrame* vfList = dec.popVideo()) {
-            for (VideoFrame* p = vfList; p; ) {
-                VideoFrame* nxt = p->next; p->next = nullptr; vQueue.push_back(p); p = nxt;
-            }
-        }
+        // ӽȡƵ(Ƶ֡ڽнУʱȡ)
         if (AudioPacket* apList = dec.popAudio()) {
             for (AudioPacket* p = apList; p; ) {
                 AudioPacket* nxt = p->next; p->next = nullptr;
@@ -782,9 +1176,8 @@ int main(int argc, char** argv)
                     }
                 }
 
-                // ͷAudioPacket
-                if (p->samples) free(p->samples);
-                free(p);
+                // 黹AudioPacket
+                freeAudioPacketChain(p);
                 p = nxt;
             }
         }
@@ -808,8 +1201,7 @@ int main(int argc, char** argv)
         // ƵʱʾƵ
         const DWORD nowTick = timeGetTime();
         bool needPaint = false;
-        while (!vQueue.empty()) {
-            VideoFrame* vf = vQueue.front();
+        while (const VideoFrame* vf = dec.peekVideo()) {
             // δƵϵͳʱƶ
             DWORD refClock = (hwo ? audioClockMs : (nowTick));
             DWORD vms = vf->playms;
@@ -825,12 +1217,9 @@ int main(int argc, char** argv)
 
             if (needPaint) {
                 // ǰ֡
-                {
-                    std::lock_guard<std::mutex> lk(shared.mtx);
-                    if (shared.current) freeVideoFrame(shared.current);
-                    shared.current = vf;
-                }
-                vQueue.pop_front();
+                std::lock_guard<std::mutex> lk(shared.mtx);
+                if (shared.current) freeVideoFrame(shared.current);
+                shared.current = dec.popVideoFrame();
             }
         }
 
@@ -856,8 +1245,6 @@ int main(int argc, char** argv)
         std::lock_guard<std::mutex> lk(shared.mtx);
         if (shared.current) { freeVideoFrame(shared.current); }
     }
-    for (VideoFrame* vf : vQueue) { freeVideoFrame(vf); }
-    vQueue.clear();
 
     if (hwo) {
         waveOutReset(hwo);
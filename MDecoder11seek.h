@@ -1,9 +1,16 @@
+#include <algorithm>
+#include <memory>
+#include <sys/types.h>
+#include <sys/stat.h>
+
 enum class VideoFormat : std::uint32_t {
     Unknown = 0,
     ARGB32 = 1,    // 8:8:8:8
     YUV420P = 2
 };
 
+class MediaPool;
+
 typedef struct VideoFrame
 {
     std::uint32_t seek_generation;  // Σڶ֡
@@ -15,6 +22,8 @@ typedef struct VideoFrame
     std::uint32_t stride;           // ÿֽ(ARGB32: width*4)
     std::uint32_t dataBytes;        // ֽ
     std::uint8_t* pixels;           // ԭʼػ(ѷ)
+    std::uint32_t capacity;         // pixels ʵ(ֽڣ>= dataBytes)
+    MediaPool* pool;              // ճأΪձʾͨѷ
     VideoFrame* next;             // һ
 } VideoFrame;
 
@@ -27,32 +36,311 @@ typedef struct AudioPacket
     std::int32_t  frames;           // ֡(ÿ֡=channels)
     std::uint32_t dataFloats;       // =frames*channels
     float* samples;          // PCM(f32)ΪdataFloats
+    std::uint32_t capacity;         // samples ʵ(>= dataFloats)
+    MediaPool* pool;              // ճأΪձʾͨѷ
     AudioPacket* next;             // һ
 } AudioPacket;
 
-// 򵥵ĸͷźȷ
+//---------------------------------------------------------------------------
+// MediaPool: VideoFrame/AudioPacket ճ
+// - ֡ͷݻΪһ建棬Ѻ黹(freeVideoFrameChain/freeAudioPacketChain)
+//    free̬벻ٴѷ
+// - ּÿ 2 ٷ 4 ˷Ѳ 25%(1080p ARGB Լ 1%)
+// - ÿ(̶)ֱͷţֱлռڴ
+// - üһݣÿ֡һݣʱ֡Կɰȫ黹
+//---------------------------------------------------------------------------
+class MediaPool {
+public:
+    struct Stats {
+        std::uint64_t heapAllocs = 0;   // ·֡/(ݻ)
+        std::uint64_t reused = 0;       // ӿõĴ
+        std::uint64_t dropped = 0;      // 黹ʱ򳬳޶ͷŵĴ
+        std::uint32_t idleVideo = 0;    // ǰеƵ֡
+        std::uint32_t idleAudio = 0;    // ǰеƵ
+    };
+
+    MediaPool() = default;
+    MediaPool(const MediaPool&) = delete;
+    MediaPool& operator=(const MediaPool&) = delete;
+
+    // ÿ໺ĿƵ֡Ĭ֡
+    void setLimits(std::uint32_t maxIdleVideo, std::uint32_t maxIdleAudio) {
+        std::lock_guard<std::mutex> lock(mtx);
+        videoLimit = maxIdleVideo;
+        audioLimit = maxIdleAudio;
+    }
+
+    // ȡһػΪ bytes Ƶ֡pixels/dataBytes/pool ãֶɵ
+    VideoFrame* acquireVideo(std::uint32_t bytes) {
+        const int cls = classOf(bytes);
+        VideoFrame* vf = nullptr;
+        if (cls >= 0) {
+            std::lock_guard<std::mutex> lock(mtx);
+            vf = idleVideo[cls];
+            if (vf) { idleVideo[cls] = vf->next; --idleVideoCount[cls]; ++stats.reused; }
+        }
+        if (!vf) {
+            const std::uint32_t cap = cls >= 0 ? capacityOf(cls) : bytes;
+            vf = (VideoFrame*)std::malloc(sizeof(VideoFrame));
+            std::uint8_t* px = vf ? (std::uint8_t*)std::malloc(cap) : nullptr;
+            if (!px) { std::free(vf); return nullptr; }
+            vf->pixels = px;
+            vf->capacity = cap;
+            std::lock_guard<std::mutex> lock(mtx);
+            ++stats.heapAllocs;
+        }
+        vf->dataBytes = bytes;
+        vf->pool = this;
+        vf->next = nullptr;
+        refs.fetch_add(1, std::memory_order_relaxed);
+        return vf;
+    }
+
+    // ȡһΪ floats Ƶ
+    AudioPacket* acquireAudio(std::uint32_t floats) {
+        const int cls = classOf(floats);
+        AudioPacket* ap = nullptr;
+        if (cls >= 0) {
+            std::lock_guard<std::mutex> lock(mtx);
+            ap = idleAudio[cls];
+            if (ap) { idleAudio[cls] = ap->next; --idleAudioCount[cls]; ++stats.reused; }
+        }
+        if (!ap) {
+            const std::uint32_t cap = cls >= 0 ? capacityOf(cls) : floats;
+            ap = (AudioPacket*)std::malloc(sizeof(AudioPacket));
+            float* buf = ap ? (float*)std::malloc(sizeof(float) * (std::size_t)cap) : nullptr;
+            if (!buf) { std::free(ap); return nullptr; }
+            ap->samples = buf;
+            ap->capacity = cap;
+            std::lock_guard<std::mutex> lock(mtx);
+            ++stats.heapAllocs;
+        }
+        ap->dataFloats = floats;
+        ap->pool = this;
+        ap->next = nullptr;
+        refs.fetch_add(1, std::memory_order_relaxed);
+        return ap;
+    }
+
+    // 黹֡/(next ֶλᱻ)
+    void recycle(VideoFrame* vf) {
+        const int cls = classOf(vf->capacity);
+        bool kept = false;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (!closed && cls >= 0 && capacityOf(cls) == vf->capacity && idleVideoCount[cls] < videoLimit) {
+                vf->next = idleVideo[cls]; idleVideo[cls] = vf; ++idleVideoCount[cls];
+                kept = true;
+            }
+            else ++stats.dropped;
+        }
+        if (!kept) { std::free(vf->pixels); std::free(vf); }
+        release();
+    }
+    void recycle(AudioPacket* ap) {
+        const int cls = classOf(ap->capacity);
+        bool kept = false;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (!closed && cls >= 0 && capacityOf(cls) == ap->capacity && idleAudioCount[cls] < audioLimit) {
+                ap->next = idleAudio[cls]; idleAudio[cls] = ap; ++idleAudioCount[cls];
+                kept = true;
+            }
+            else ++stats.dropped;
+        }
+        if (!kept) { std::free(ap->samples); std::free(ap); }
+        release();
+    }
+
+    // ͷпл(ֱʱ仯ֹͣź)
+    void trim() {
+        VideoFrame* vHead = nullptr;
+        AudioPacket* aHead = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            for (int c = 0; c < ClassCount; ++c) {
+                while (VideoFrame* vf = idleVideo[c]) { idleVideo[c] = vf->next; vf->next = vHead; vHead = vf; }
+                while (AudioPacket* ap = idleAudio[c]) { idleAudio[c] = ap->next; ap->next = aHead; aHead = ap; }
+                idleVideoCount[c] = idleAudioCount[c] = 0;
+            }
+        }
+        while (vHead) { VideoFrame* nxt = vHead->next; std::free(vHead->pixels); std::free(vHead); vHead = nxt; }
+        while (aHead) { AudioPacket* nxt = aHead->next; std::free(aHead->samples); std::free(aHead); aHead = nxt; }
+    }
+
+    // ߷Уտ֮黹ֱ֡ͷţһ֡黹ʱ
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            closed = true;
+        }
+        trim();
+        release();
+    }
+
+    Stats getStats() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        Stats s = stats;
+        for (int c = 0; c < ClassCount; ++c) { s.idleVideo += idleVideoCount[c]; s.idleAudio += idleAudioCount[c]; }
+        return s;
+    }
+
+private:
+    // ּ256 𲽣ÿ 2  4  2^31 
+    static constexpr int ClassCount = 4 * (31 - 8) + 1;
+
+    static std::uint32_t capacityOf(int cls) {
+        const int e = 8 + cls / 4;
+        return (1u << e) + (std::uint32_t)(cls % 4) * (1u << (e - 2));
+    }
+    static int classOf(std::uint32_t n) {
+        if (n <= 256u) return 0;
+        const std::uint32_t v = n - 1;
+        int e = 0;
+        while ((v >> (e + 1)) != 0) ++e;                    // floor(log2(n - 1))
+        int m = (int)((v - (1u << e)) >> (e - 2)) + 1;      // ڵĵڼ
+        if (m == 4) { ++e; m = 0; }
+        const int cls = (e - 8) * 4 + m;
+        return cls < ClassCount ? cls : -1;
+    }
+
+    void release() {
+        if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this;
+    }
+
+    mutable std::mutex mtx;
+    std::atomic<std::uint32_t> refs{ 1 };
+    bool closed = false;
+    std::uint32_t videoLimit = 8;
+    std::uint32_t audioLimit = 64;
+    VideoFrame* idleVideo[ClassCount] = {};
+    AudioPacket* idleAudio[ClassCount] = {};
+    std::uint32_t idleVideoCount[ClassCount] = {};
+    std::uint32_t idleAudioCount[ClassCount] = {};
+    Stats stats;
+};
+
+// ͷ/黹ط֡ص MediaPoolఴԭʽ free
 static inline void freeVideoFrameChain(VideoFrame* head) {
     while (head) {
         VideoFrame* nxt = head->next;
-        if (head->pixels) { free(head->pixels); head->pixels = nullptr; }
-        free(head);
+        if (head->pool) head->pool->recycle(head);
+        else {
+            if (head->pixels) { free(head->pixels); head->pixels = nullptr; }
+            free(head);
+        }
         head = nxt;
     }
 }
-
 static inline void freeAudioPacketChain(AudioPacket* head) {
     while (head) {
         AudioPacket* nxt = head->next;
-        if (head->samples) { free(head->samples); head->samples = nullptr; }
-        free(head);
+        if (head->pool) head->pool->recycle(head);
+        else {
+            if (head->samples) { free(head->samples); head->samples = nullptr; }
+            free(head);
+        }
         head = nxt;
     }
 }
 
+//---------------------------------------------------------------------------
+// SpscRing: /н绷ζ()
+// - ߳ push߳ pop/peek˸ֻдԼ±꣬
+// - Ϊ 2 ݣ߼ depth ԸСʱ push  falseɵ߾ȴ
+// - ˻Զ±ֻ꣬п/ʱ¶ȡٻ
+//---------------------------------------------------------------------------
+template <typename T>
+class SpscRing {
+public:
+    // ˶ʱ(start ֮ǰ / stop ֮)
+    void reset(std::uint32_t depth) {
+        if (depth < 1) depth = 1;
+        std::uint32_t cap = 1;
+        while (cap < depth) cap <<= 1;
+        slots.assign(cap, nullptr);
+        mask = cap - 1;
+        limit = depth;
+        head.store(0, std::memory_order_relaxed);
+        tail.store(0, std::memory_order_relaxed);
+        headCache = tailCache = 0;
+    }
+
+    // 
+    bool push(T* item) {
+        const std::uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t - headCache >= limit) {
+            headCache = head.load(std::memory_order_acquire);
+            if (t - headCache >= limit) return false;
+        }
+        slots[t & mask] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+    bool full() {
+        const std::uint32_t t = tail.load(std::memory_order_relaxed);
+        headCache = head.load(std::memory_order_acquire);
+        return t - headCache >= limit;
+    }
+
+    // 
+    T* peek() {
+        const std::uint32_t h = head.load(std::memory_order_relaxed);
+        if (h == tailCache) {
+            tailCache = tail.load(std::memory_order_acquire);
+            if (h == tailCache) return nullptr;
+        }
+        return slots[h & mask];
+    }
+    T* pop() {
+        T* item = peek();
+        if (item) head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        return item;
+    }
+
+    // һ˾ɵãΪֵ
+    std::uint32_t size() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+    std::uint32_t depth() const { return limit; }
+
+private:
+    alignas(64) std::atomic<std::uint32_t> head{ 0 };  // д
+    std::uint32_t tailCache = 0;                        // ˽
+    alignas(64) std::atomic<std::uint32_t> tail{ 0 };  // д
+    std::uint32_t headCache = 0;                        // ˽
+    alignas(64) std::vector<T*> slots;
+    std::uint32_t mask = 0;
+    std::uint32_t limit = 1;
+};
+
+// ãȰƵ֡ƵƵʱ(ms)
+enum class QueueMode {
+    Blocking,   // ʱ߳ߣֱѶȡ(Ĭ)
+    WaitFree    // ̴߳Ӳȴʱ½֡/
+};
+
+struct QueueConfig {
+    std::uint32_t videoFrames = 8;      // Ƶ໺֡
+    std::uint32_t audioPackets = 128;   // Ƶ໺İ
+    std::uint32_t audioMs = 500;        // Ƶ໺ʱ()
+    QueueMode     mode = QueueMode::Blocking;
+};
+
+struct QueueStats {
+    std::uint32_t videoQueued = 0;      // ǰŶӵƵ֡
+    std::uint32_t audioQueued = 0;      // ǰŶӵƵ
+    std::uint32_t audioQueuedMs = 0;    // ǰŶӵƵʱ
+    std::uint64_t producerWaits = 0;    // ߳ߵĴ
+    std::uint64_t droppedVideo = 0;     // WaitFree ģʽ¶Ƶ֡
+    std::uint64_t droppedAudio = 0;     // WaitFree ģʽ¶Ƶ
+    std::uint64_t staleFlushed = 0;     //  seek ιڶ֡/
+};
+
 class MDecoder {
 public:
     MDecoder() = default;
-    ~MDecoder() { stop(); }
+    ~MDecoder() { stop(); pool->close(); }
 
     bool start(const std::wstring& path) {
         stop();
@@ -63,6 +351,16 @@ public:
             return false;
         }
         infile = f;
+        mediaPath = path;
+        {
+            std::lock_guard<std::mutex> lock(mtxIndex);
+            seekIndex = loadIndex(path);                 // Ч .mdx ֱڶλ
+        }
+        indexQuit.store(false);
+        activeQueue = queueConfig;
+        videoQueue.reset(activeQueue.videoFrames);
+        audioQueue.reset(activeQueue.audioPackets);
+        queuedAudioFrames.store(0);
         seekGeneration.store(seekGeneration.load() + 1); // 
         quit.store(false);
         eof.store(false);
@@ -73,32 +371,104 @@ public:
 
     void stop() {
         quit.store(true);
+        {
+            std::lock_guard<std::mutex> lock(mtxWait);   // ߵĽ߳
+            cvSpace.notify_all();
+        }
         if (worker.joinable()) worker.join();
+        indexQuit.store(true);
+        if (indexer.joinable()) indexer.join();
         cleanup();
     }
 
-    // ȡһ֡ƵͷѺͷţ
+    // в( start() ֮ǰã´ start Ч)
+    void setQueueConfig(const QueueConfig& config) { queueConfig = config; }
+
+    // 鿴Ƶ֡ȡ(̵߳)ڴε֡ڴ˶
+    const VideoFrame* peekVideo() {
+        for (;;) {
+            VideoFrame* vf = videoQueue.peek();
+            if (!vf || vf->seek_generation == seekGeneration.load(std::memory_order_acquire)) return vf;
+            videoQueue.pop();
+            staleFlushed.fetch_add(1, std::memory_order_relaxed);
+            freeVideoFrameChain(vf);
+            notifyProducer();
+        }
+    }
+
+    // ȡһ֡Ƶͨ freeVideoFrameChain 黹
+    VideoFrame* popVideoFrame() {
+        if (!peekVideo()) return nullptr;
+        VideoFrame* vf = videoQueue.pop();
+        notifyProducer();
+        return vf;
+    }
+
+    // ȡǰȫƵ֡ͷѺͷţ
     VideoFrame* popVideo() {
-        std::lock_guard<std::mutex> lock(mtxVideo);
-        VideoFrame* head = videoHead;
-        videoHead = nullptr;
-        videoTail = nullptr;
+        VideoFrame* head = nullptr;
+        VideoFrame* tail = nullptr;
+        while (VideoFrame* vf = popVideoFrame()) {
+            if (!head) head = vf; else tail->next = vf;
+            tail = vf;
+        }
         return head;
     }
 
-    // ȡһƵͷѺͷţ
+    const AudioPacket* peekAudio() {
+        for (;;) {
+            AudioPacket* ap = audioQueue.peek();
+            if (!ap || ap->seek_generation == seekGeneration.load(std::memory_order_acquire)) return ap;
+            audioQueue.pop();
+            queuedAudioFrames.fetch_sub(ap->frames, std::memory_order_release);
+            staleFlushed.fetch_add(1, std::memory_order_relaxed);
+            freeAudioPacketChain(ap);
+            notifyProducer();
+        }
+    }
+
+    AudioPacket* popAudioPacket() {
+        if (!peekAudio()) return nullptr;
+        AudioPacket* ap = audioQueue.pop();
+        queuedAudioFrames.fetch_sub(ap->frames, std::memory_order_release);
+        notifyProducer();
+        return ap;
+    }
+
+    // ȡǰȫƵͷѺͷţ
     AudioPacket* popAudio() {
-        std::lock_guard<std::mutex> lock(mtxAudio);
-        AudioPacket* head = audioHead;
-        audioHead = nullptr;
-        audioTail = nullptr;
+        AudioPacket* head = nullptr;
+        AudioPacket* tail = nullptr;
+        while (AudioPacket* ap = popAudioPacket()) {
+            if (!head) head = ap; else tail->next = ap;
+            tail = ap;
+        }
         return head;
     }
 
+    QueueStats getQueueStats() const {
+        QueueStats s;
+        s.videoQueued = videoQueue.size();
+        s.audioQueued = audioQueue.size();
+        const std::int64_t frames = queuedAudioFrames.load(std::memory_order_relaxed);
+        const std::int32_t freq = queueFreq.load(std::memory_order_relaxed);
+        s.audioQueuedMs = (freq > 0 && frames > 0) ? (std::uint32_t)(frames * 1000 / freq) : 0;
+        s.producerWaits = producerWaits.load(std::memory_order_relaxed);
+        s.droppedVideo = droppedVideo.load(std::memory_order_relaxed);
+        s.droppedAudio = droppedAudio.load(std::memory_order_relaxed);
+        s.staleFlushed = staleFlushed.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    // ֡/ճأɵ޻ѯͳ
+    MediaPool& getPool() { return *pool; }
+    MediaPool::Stats getPoolStats() const { return pool->getStats(); }
+
     void requestSeek(double seconds) {
         seekTargetSeconds.store(seconds);
         seekRequested.store(true);
         seekGeneration.store(seekGeneration.load() + 1);
+        notifyProducer();   // оɴε֡ peek/pop ̲߳صȴǱ
     }
 
     // ٲѯƵʱľ̬  
@@ -112,11 +482,173 @@ public:
         int audioChannels = 0;
     };
 
+    // Ogg λTheora ÿؼ֡һVorbis Լÿ 250ms һýԵ .mdx ļУ
+    // ļС޸ʱ仯ʧЧʱ seek ֻһζλʱѯضȡýļ
+    struct SeekIndex {
+        struct Entry {
+            ogg_int64_t position;   // Theora: ؼ֡ţVorbis: ҳĩβλ
+            ogg_int64_t offset;     // Theora: ؼ֮֡ǰһҳƫƣVorbis: ҳƫ
+        };
+        ogg_int64_t fileSize = 0;
+        ogg_int64_t mtime = 0;
+        bool hasVideo = false, hasAudio = false;
+        std::int32_t videoSerial = 0, audioSerial = 0;
+        DurationInfo info;
+        std::vector<Entry> keyframes;
+        std::vector<Entry> audio;
+
+        //  frame һؼ֡ӷصƫƿʼɽ뵽
+        ogg_int64_t videoOffset(ogg_int64_t frame) const {
+            auto it = std::upper_bound(keyframes.begin(), keyframes.end(), frame,
+                [](ogg_int64_t v, const Entry& e) { return v < e.position; });
+            return it == keyframes.begin() ? 0 : (it - 1)->offset;
+        }
+        // ĩβ sample һҳ
+        ogg_int64_t audioOffset(ogg_int64_t sample) const {
+            auto it = std::lower_bound(audio.begin(), audio.end(), sample,
+                [](const Entry& e, ogg_int64_t v) { return e.position < v; });
+            return it == audio.begin() ? 0 : (it - 1)->offset;
+        }
+    };
+
+    // λ״δʱں̨ɨȫļ .mdx(ĬϹرգýĿ¼дļ)
+    // ѴڵЧܻᱻȡ
+    void setSeekIndexEnabled(bool enabled) { indexEnabled = enabled; }
+    bool hasSeekIndex() {
+        std::lock_guard<std::mutex> lock(mtxIndex);
+        return seekIndex != nullptr;
+    }
+
+    static std::wstring indexPathFor(const std::wstring& path) { return path + L".mdx"; }
+
+    // ȡУ .mdxýļС/޸ʱ䲻ʽʱؿ
+    static std::shared_ptr<const SeekIndex> loadIndex(const std::wstring& path) {
+        struct _stat64 st {};
+        if (_wstat64(path.c_str(), &st) != 0) return nullptr;
+        FILE* f = _wfopen(indexPathFor(path).c_str(), L"rb");
+        if (!f) return nullptr;
+        IndexHeader h{};
+        auto idx = std::make_shared<SeekIndex>();
+        bool ok = std::fread(&h, sizeof(h), 1, f) == 1 &&
+            std::memcmp(h.magic, "MDX1", 4) == 0 && h.version == IndexVersion &&
+            h.fileSize == (std::int64_t)st.st_size && h.mtime == (std::int64_t)st.st_mtime &&
+            h.keyframeCount <= (1u << 26) && h.audioCount <= (1u << 26);
+        if (ok) {
+            idx->keyframes.resize(h.keyframeCount);
+            idx->audio.resize(h.audioCount);
+            ok = std::fread(idx->keyframes.data(), sizeof(SeekIndex::Entry), h.keyframeCount, f) == h.keyframeCount &&
+                std::fread(idx->audio.data(), sizeof(SeekIndex::Entry), h.audioCount, f) == h.audioCount;
+        }
+        std::fclose(f);
+        if (!ok) return nullptr;
+        idx->fileSize = h.fileSize;
+        idx->mtime = h.mtime;
+        idx->hasVideo = h.hasVideo != 0;
+        idx->hasAudio = h.hasAudio != 0;
+        idx->videoSerial = h.videoSerial;
+        idx->audioSerial = h.audioSerial;
+        idx->info.videoDuration = h.videoDuration;
+        idx->info.audioDuration = h.audioDuration;
+        idx->info.videoFps = h.videoFps;
+        idx->info.videoWidth = h.videoWidth;
+        idx->info.videoHeight = h.videoHeight;
+        idx->info.audioFreq = h.audioFreq;
+        idx->info.audioChannels = h.audioChannels;
+        return idx;
+    }
+
+    // д .mdxдʱļ滻;ʧܲ°
+    static bool saveIndex(const std::wstring& path, const SeekIndex& idx) {
+        IndexHeader h{};
+        std::memcpy(h.magic, "MDX1", 4);
+        h.version = IndexVersion;
+        h.fileSize = idx.fileSize;
+        h.mtime = idx.mtime;
+        h.hasVideo = idx.hasVideo;
+        h.hasAudio = idx.hasAudio;
+        h.videoSerial = idx.videoSerial;
+        h.audioSerial = idx.audioSerial;
+        h.videoDuration = idx.info.videoDuration;
+        h.audioDuration = idx.info.audioDuration;
+        h.videoFps = idx.info.videoFps;
+        h.videoWidth = idx.info.videoWidth;
+        h.videoHeight = idx.info.videoHeight;
+        h.audioFreq = idx.info.audioFreq;
+        h.audioChannels = idx.info.audioChannels;
+        h.keyframeCount = (std::uint32_t)idx.keyframes.size();
+        h.audioCount = (std::uint32_t)idx.audio.size();
+
+        const std::wstring target = indexPathFor(path);
+        const std::wstring temp = target + L".tmp";
+        FILE* f = _wfopen(temp.c_str(), L"wb");
+        if (!f) return false;
+        bool ok = std::fwrite(&h, sizeof(h), 1, f) == 1 &&
+            std::fwrite(idx.keyframes.data(), sizeof(SeekIndex::Entry), idx.keyframes.size(), f) == idx.keyframes.size() &&
+            std::fwrite(idx.audio.data(), sizeof(SeekIndex::Entry), idx.audio.size(), f) == idx.audio.size();
+        ok = (std::fclose(f) == 0) && ok;
+        if (ok) ok = MoveFileExW(temp.c_str(), target.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+        if (!ok) _wremove(temp.c_str());
+        return ok;
+    }
+
+    // ·ѯʱЧ .mdx ֱӸýļļ̽
+    static bool queryDuration(const std::wstring& path, DurationInfo& info) {
+        if (auto idx = loadIndex(path)) { info = idx->info; return true; }
+        FILE* f = _wfopen(path.c_str(), L"rb");
+        if (!f) return false;
+        const bool ok = queryDuration(f, info);
+        std::fclose(f);
+        return ok;
+    }
+
+    // ļβǰֿɨ裬ҵһ granulepos ҳڴ 64KB 
+    // ĳǰҳܴʱҲ©ֻͨһ
+    static void scanTailGranules(FILE* infile, ogg_int64_t fileSize,
+                                 bool hasVideo, int videoSerial, ogg_int64_t& videoGp,
+                                 bool hasAudio, int audioSerial, ogg_int64_t& audioGp) {
+        ogg_sync_state sy{};
+        ogg_page pg{};
+        ogg_sync_init(&sy);
+        videoGp = audioGp = -1;
+        ogg_int64_t end = fileSize, chunk = 64 * 1024;
+        while (end > 0 && ((hasVideo && videoGp < 0) || (hasAudio && audioGp < 0))) {
+            const ogg_int64_t begin = std::max<ogg_int64_t>(0, end - chunk);
+            _fseeki64(infile, begin, SEEK_SET);
+            ogg_sync_reset(&sy);
+            ogg_int64_t pos = begin, v = -1, a = -1;
+            for (;;) {
+                const long ret = ogg_sync_pageseek(&sy, &pg);
+                if (ret < 0) { pos -= ret; continue; }
+                if (ret == 0) {
+                    if (pos >= end) break;
+                    char* buffer = ogg_sync_buffer(&sy, 4096);
+                    const int bytes = (int)std::fread(buffer, 1, 4096, infile);
+                    if (bytes == 0) break;
+                    ogg_sync_wrote(&sy, bytes);
+                    continue;
+                }
+                if (pos >= end) break;              // ʼ end ֮ҳһп
+                const ogg_int64_t gp = ogg_page_granulepos(&pg);
+                if (gp >= 0) {
+                    const int serial = ogg_page_serialno(&pg);
+                    if (hasVideo && serial == videoSerial) v = gp;
+                    if (hasAudio && serial == audioSerial) a = gp;
+                }
+                pos += ret;
+            }
+            if (videoGp < 0) videoGp = v;
+            if (audioGp < 0) audioGp = a;
+            end = begin;
+            chunk *= 2;
+        }
+        ogg_sync_clear(&sy);
+    }
+
     static bool queryDuration(FILE* infile, DurationInfo& info) {
         if (!infile) return false;
 
         // 浱ǰλ  
-        long originalPos = ftell(infile);
+        ogg_int64_t originalPos = _ftelli64(infile);
 
         // ʱ״̬  
         ogg_sync_state oy{};
@@ -130,6 +662,7 @@ public:
         vorbis_comment vc{};
 
         bool hasTheora = false, hasVorbis = false;
+        bool bosDone = false;               // BOS ҳļͷͨҳʶ
         int theoraHeaders = 0, vorbisHeaders = 0;
 
         // ʼ  
@@ -140,9 +673,9 @@ public:
         vorbis_comment_init(&vc);
 
         // 1. ɨͷϢ  
-        fseek(infile, 0, SEEK_SET);
+        _fseeki64(infile, 0, SEEK_SET);
 
-        while (!hasTheora || !hasVorbis) {
+        while (!bosDone && (!hasTheora || !hasVorbis)) {
             char* buffer = ogg_sync_buffer(&oy, 4096);
             int bytes = (int)fread(buffer, 1, 4096, infile);
             if (bytes == 0) break;
@@ -172,6 +705,7 @@ public:
                 else {
                     if (hasTheora) ogg_stream_pagein(&to, &og);
                     if (hasVorbis) ogg_stream_pagein(&vo, &og);
+                    bosDone = true;
                 }
             }
         }
@@ -208,41 +742,13 @@ public:
             info.audioChannels = vi.channels;
         }
 
-        // 4. ɨļĩβȡ granulepos  
+        // 4. ļĩβǰɨȡ granulepos  
         ogg_int64_t lastVideoGranule = -1;
         ogg_int64_t lastAudioGranule = -1;
-
-        // תļĩβǰ  
-        fseek(infile, 0, SEEK_END);
-        long fileSize = ftell(infile);
-        long searchPos = fileSize - 65536; // 64KBʼ  
-        if (searchPos < 0) searchPos = 0;
-
-        fseek(infile, searchPos, SEEK_SET);
-        ogg_sync_reset(&oy);
-
-        // ȡʣ  
-        while (!feof(infile)) {
-            char* buffer = ogg_sync_buffer(&oy, 4096);
-            int bytes = (int)fread(buffer, 1, 4096, infile);
-            if (bytes == 0) break;
-            ogg_sync_wrote(&oy, bytes);
-
-            while (ogg_sync_pageout(&oy, &og) > 0) {
-                if (hasTheora && ogg_page_serialno(&og) == to.serialno) {
-                    ogg_int64_t granule = ogg_page_granulepos(&og);
-                    if (granule > lastVideoGranule) {
-                        lastVideoGranule = granule;
-                    }
-                }
-                if (hasVorbis && ogg_page_serialno(&og) == vo.serialno) {
-                    ogg_int64_t granule = ogg_page_granulepos(&og);
-                    if (granule > lastAudioGranule) {
-                        lastAudioGranule = granule;
-                    }
-                }
-            }
-        }
+        _fseeki64(infile, 0, SEEK_END);
+        const ogg_int64_t fileSize = _ftelli64(infile);
+        scanTailGranules(infile, fileSize, hasTheora, to.serialno, lastVideoGranule,
+                         hasVorbis, vo.serialno, lastAudioGranule);
 
         // 5. ʱ  
         if (hasTheora && lastVideoGranule >= 0) {
@@ -273,17 +779,53 @@ public:
         }
         ogg_sync_clear(&oy);
 
-        fseek(infile, originalPos, SEEK_SET);
+        _fseeki64(infile, originalPos, SEEK_SET);
 
         return (hasTheora || hasVorbis);
     }
 
 private:
+    // .mdx ļͷΪؼ֡Ƶ( 16 ֽ)
+    static constexpr std::uint32_t IndexVersion = 1;
+    static constexpr std::size_t IndexReadBytes = 256 * 1024;
+    struct IndexHeader {
+        char          magic[4];
+        std::uint32_t version;
+        std::int64_t  fileSize;
+        std::int64_t  mtime;
+        double        videoDuration;
+        double        audioDuration;
+        double        videoFps;
+        std::int32_t  videoSerial;
+        std::int32_t  audioSerial;
+        std::int32_t  videoWidth;
+        std::int32_t  videoHeight;
+        std::int32_t  audioFreq;
+        std::int32_t  audioChannels;
+        std::uint32_t keyframeCount;
+        std::uint32_t audioCount;
+        std::uint8_t  hasVideo;
+        std::uint8_t  hasAudio;
+        std::uint8_t  reserved[6];
+    };
+    static_assert(sizeof(IndexHeader) == 88, "IndexHeader layout");
+
+    // ߳(ڽ߳иƣʱʽ״̬)
+    struct IndexParams {
+        std::wstring path;
+        bool hasVideo = false, hasAudio = false;
+        int videoSerial = 0, audioSerial = 0;
+        int shift = 0;
+        ogg_int64_t bias = 0;
+        DurationInfo info;
+    };
+
     // ̹̣߳οSDLPlayer5.cppḶ̌
     void decodeThreadProc() {
         initCodecStates();
         if (!probeHeaders()) { cleanup(); return; }
         if (!initDecoders()) { cleanup(); return; }
+        if (indexEnabled && !hasSeekIndex()) startIndexer();
         decodeLoop();
         cleanupCodecStates();
         eof.store(true);
@@ -360,6 +902,8 @@ private:
                 int ret = bufferData(); if (ret == 0) { std::fprintf(stderr, "[MDecoder] EOF while reading headers.\n"); return false; }
             }
         }
+        // ͷҳͬδȡĵһҳ׸ҳseek ڴ˴ضͷҳ
+        dataOffset = _ftelli64(infile) - (oy.fill - oy.returned);
         return true;
     }
 
@@ -376,8 +920,11 @@ private:
             if (vorbis_block_init(&vd, &vb) != 0) return false;
             aFreq = vi.rate;
             aChannels = (vi.channels > 2) ? 2 : (vi.channels < 1 ? 1 : vi.channels);
+            audioFrameLimit = (std::int64_t)activeQueue.audioMs * aFreq / 1000;
+            queueFreq.store(aFreq);
         }
         startTicks = timeGetTime();
+        audioSamplePos = 0;
         return true;
     }
 
@@ -415,45 +962,117 @@ private:
         }
     }
 
+    // ʱıѹBlocking ģʽߵѶȡݣ
+    //  false ʾӦǰ֡/(WaitFree ģʽ˳ seek ʹ)
+    template <typename Full>
+    bool waitForSpace(Full isFull, std::uint32_t gen) {
+        if (activeQueue.mode == QueueMode::WaitFree) return false;
+        producerWaits.fetch_add(1, std::memory_order_relaxed);
+        std::unique_lock<std::mutex> lock(mtxWait);
+        producerWaiting.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool ok = true;
+        while (isFull()) {
+            if (quit.load() || gen != seekGeneration.load()) { ok = false; break; }
+            // ѶȡݺỽѣʱֻǶ
+            cvSpace.wait_for(lock, std::chrono::milliseconds(20));
+        }
+        producerWaiting.store(false, std::memory_order_relaxed);
+        return ok;
+    }
+
+    // Ѷȡݺãڽ߳ȷʵڵȴʱż֪ͨ
+    void notifyProducer() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (producerWaiting.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(mtxWait);
+            cvSpace.notify_one();
+        }
+    }
+
     void pushVideoFrame(VideoFrame* vf) {
-        std::lock_guard<std::mutex> lock(mtxVideo);
-        if (!videoHead) { videoHead = vf; videoTail = vf; }
-        else { videoTail->next = vf; videoTail = vf; }
+        while (!videoQueue.push(vf)) {
+            if (!waitForSpace([this] { return videoQueue.full(); }, vf->seek_generation)) {
+                if (activeQueue.mode == QueueMode::WaitFree) droppedVideo.fetch_add(1, std::memory_order_relaxed);
+                freeVideoFrameChain(vf);
+                return;
+            }
+        }
     }
+
+    bool audioFull() {
+        return audioQueue.full() ||
+            (audioFrameLimit > 0 && queuedAudioFrames.load(std::memory_order_acquire) >= audioFrameLimit);
+    }
+
     void pushAudioPacket(AudioPacket* ap) {
-        std::lock_guard<std::mutex> lock(mtxAudio);
-        if (!audioHead) { audioHead = ap; audioTail = ap; }
-        else { audioTail->next = ap; audioTail = ap; }
+        if (audioFull() && !waitForSpace([this] { return audioFull(); }, ap->seek_generation)) {
+            if (activeQueue.mode == QueueMode::WaitFree) droppedAudio.fetch_add(1, std::memory_order_relaxed);
+            freeAudioPacketChain(ap);
+            return;
+        }
+        // ȼʱٷѶ˼ȥʱֵָ
+        queuedAudioFrames.fetch_add(ap->frames, std::memory_order_relaxed);
+        audioQueue.push(ap);
+    }
+
+    // (ڽ߳δʱ)
+    void drainQueues() {
+        while (VideoFrame* vf = videoQueue.pop()) freeVideoFrameChain(vf);
+        while (AudioPacket* ap = audioQueue.pop()) freeAudioPacketChain(ap);
+        queuedAudioFrames.store(0);
     }
 
     // ޸ģƵ - ʹ granulepos 㾫ȷʱ  
     void processAudioPacket(ogg_packet& op, std::uint32_t gen) {
+        if (audioResync) {
+            // seek ֱһҳĩ granulepos ֮׸λ
+            if (op.granulepos < 0) return;
+            if (vorbis_synthesis(&vb, &op) == 0) vorbis_synthesis_blockin(&vd, &vb);
+            float** discard = nullptr;
+            while (int n = vorbis_synthesis_pcmout(&vd, &discard)) vorbis_synthesis_read(&vd, n);
+            audioSamplePos = op.granulepos;
+            audioResync = false;
+            return;
+        }
+
         if (vorbis_synthesis(&vb, &op) == 0) vorbis_synthesis_blockin(&vd, &vb);
         float** pcm = nullptr; int samples = 0;
 
-        // ʹ granulepos ʱ׼  
-        static double audioTimeBase = 0.0;
+        // ʹ granulepos У׼ʱ׼granulepos ǱϺλ  
         if (op.granulepos >= 0) {
-            audioTimeBase = (double)op.granulepos / aFreq;
+            audioSamplePos = op.granulepos - vorbis_synthesis_pcmout(&vd, nullptr);
         }
 
         while ((samples = vorbis_synthesis_pcmout(&vd, &pcm)) > 0) {
+            // seek Ŀ֮ǰֻ벻
+            int skip = 0;
+            if (seekAudioSample > audioSamplePos) {
+                skip = (int)std::min<ogg_int64_t>(samples, seekAudioSample - audioSamplePos);
+                if (skip == samples) {
+                    audioSamplePos += samples;
+                    vorbis_synthesis_read(&vd, samples);
+                    continue;
+                }
+            }
+            seekAudioSample = -1;
+
             int outCh = aChannels;
-            std::size_t floats = (std::size_t)samples * (std::size_t)outCh;
-            float* buf = (float*)std::malloc(sizeof(float) * floats);
-            if (!buf) { vorbis_synthesis_read(&vd, samples); break; }
+            std::size_t floats = (std::size_t)(samples - skip) * (std::size_t)outCh;
+            AudioPacket* ap = pool->acquireAudio((std::uint32_t)floats);
+            if (!ap) { vorbis_synthesis_read(&vd, samples); break; }
 
             // ƵزϣŻ汾  
-            float* dst = buf;
+            float* dst = ap->samples;
             if (vi.channels == 1) {
-                for (int i = 0; i < samples; ++i) {
+                for (int i = skip; i < samples; ++i) {
                     float val = pcm[0][i];
                     if (outCh == 1) *dst++ = val;
                     else { *dst++ = val; *dst++ = val; }
                 }
             }
             else {
-                for (int i = 0; i < samples; ++i) {
+                for (int i = skip; i < samples; ++i) {
                     float L = pcm[0][i];
                     float R = (vi.channels > 1) ? pcm[1][i] : L;
 
@@ -475,52 +1094,65 @@ private:
             }
 
             // ʹ granulepos 㾫ȷʱ  
-            std::uint32_t playms = (std::uint32_t)(audioTimeBase * 1000.0);
-            audioTimeBase += (double)samples / aFreq;
-
-            AudioPacket* ap = (AudioPacket*)std::malloc(sizeof(AudioPacket));
-            if (!ap) { std::free(buf); vorbis_synthesis_read(&vd, samples); break; }
+            std::uint32_t playms = (std::uint32_t)((audioSamplePos + skip) * 1000 / aFreq);
+            audioSamplePos += samples;
 
             ap->seek_generation = gen;
             ap->playms = playms;
             ap->channels = outCh;
             ap->freq = aFreq;
-            ap->frames = samples;
-            ap->dataFloats = (std::uint32_t)floats;
-            ap->samples = buf;
-            ap->next = nullptr;
+            ap->frames = samples - skip;
             pushAudioPacket(ap);
             vorbis_synthesis_read(&vd, samples);
         }
     }
 
     // ޸ģƵ -  TH_DUPFRAME   
-    void processVideoPacket(const ogg_packet& op, std::uint32_t gen) {
+    // ظ֡ʱĲο֡䣬th_decode_ycbcr_out Էһ֡֡һݣ
+    // βѶˣٻض
+    void processVideoPacket(ogg_packet& op, std::uint32_t gen) {
+        if (videoResync) {
+            // seek ȵһҳĩȷ֡ţһؼ֡(ԾǸĩ)
+            // ǰѽ granulepos Ϊؼ֡ǰһ֮֡֡/ʱȷ
+            const int key = th_packet_iskeyframe(&op);
+            if (key < 0) return;                            // ͷ֡֡
+            if (videoNextFrame < 0) {
+                if (op.granulepos < 0) return;              // ҳǰİ֡δ֪
+                videoNextFrame = th_granule_frame(td, op.granulepos);
+            }
+            if (key != 1) { ++videoNextFrame; return; }
+            const int shift = ti.keyframe_granule_shift;
+            const ogg_int64_t bias = 1 - th_granule_frame(td, (ogg_int64_t)1 << shift); // 3.2.1 ֡Ŵ 1 
+            ogg_int64_t prev = (videoNextFrame - 1 + bias) << shift;
+            if (prev >= 0) th_decode_ctl(td, TH_DECCTL_SET_GRANPOS, &prev, sizeof(prev));
+            videoResync = false;
+        }
+
         ogg_int64_t gran = -1;
         int ret = th_decode_packetin(td, &op, &gran);
 
-        if (ret == 0) {
-            //   
+        if (ret == 0 || ret == TH_DUPFRAME) {
+            // seek Ŀ֮ǰֻ֡(άֲο֡)ת
+            if (seekVideoFrame >= 0) {
+                if (th_granule_frame(td, gran) < seekVideoFrame) return;
+                seekVideoFrame = -1;
+            }
+
             double vtime = th_granule_time(td, gran);
             if (vtime < 0.0) vtime = 0.0;
 
             th_ycbcr_buffer yuv;
             th_decode_ycbcr_out(td, yuv);
 
-            // ػӴ飩  
+            // ӻճȡػ壨̬¸ѹ黹֡  
             std::uint32_t stride = (std::uint32_t)vWidth * 4u;
             std::uint32_t bytes = stride * (std::uint32_t)vHeight;
-            std::uint8_t* px = (std::uint8_t*)std::malloc(bytes);
-            if (!px) return; // OOM֡  
+            VideoFrame* vf = pool->acquireVideo(bytes);
+            if (!vf) return; // OOM֡  
 
-            yuv420ToARGB(yuv, px, stride);
+            yuv420ToARGB(yuv, vf->pixels, stride);
 
             std::uint32_t playms = (std::uint32_t)std::llround(vtime * 1000.0);
-            VideoFrame* vf = (VideoFrame*)std::malloc(sizeof(VideoFrame));
-            if (!vf) {
-                std::free(px);
-                return;
-            }
 
             vf->seek_generation = gen;
             vf->playms = playms;
@@ -529,114 +1161,262 @@ private:
             vf->height = (std::uint32_t)vHeight;
             vf->format = VideoFormat::ARGB32;
             vf->stride = stride;
-            vf->dataBytes = bytes;
-            vf->pixels = px;
-            vf->next = nullptr;
             pushVideoFrame(vf);
-
-        }
-        else if (ret == TH_DUPFRAME) {
-            // ظ֡ - ǰһ֡  
-            VideoFrame* prev = getLastVideoFrame();
-            if (prev) {
-                VideoFrame* vf = duplicateVideoFrame(prev, gen);
-                if (vf) {
-                    vf->playms = (std::uint32_t)std::llround(th_granule_time(td, gran) * 1000.0);
-                    pushVideoFrame(vf);
-                }
-            }
         }
     }
 
     // ִ seek   
+    // 1)  granulepos ļƫƶ֣ҵĿ֮ǰһҳֻ O(log n) ζȡ
+    // 2) Theora ٻ˵Ŀ֡Ĺؼ֮֡ǰ
+    // 3) ̴֮߳ӹؼ֡ʼ룬Ŀʱ֮ǰ֡/
     void performSeek(double targetSeconds) {
         if (!hasTheora && !hasVorbis) return;
+        if (targetSeconds < 0.0) targetSeconds = 0.0;
 
-        // Ŀ granulepos  
-        ogg_int64_t targetGranule = -1;
-        if (hasTheora) {
-            targetGranule = (ogg_int64_t)(targetSeconds * vFps);
+        _fseeki64(infile, 0, SEEK_END);
+        fileBytes = _ftelli64(infile);
+
+        ogg_int64_t startOffset = fileBytes;
+        seekVideoFrame = -1;
+        seekAudioSample = -1;
+
+        // ʱֱӲһζλҪֶȡ
+        std::shared_ptr<const SeekIndex> idx;
+        {
+            std::lock_guard<std::mutex> lock(mtxIndex);
+            idx = seekIndex;
+        }
+        // 뵱ǰļ/ʱ·ö
+        const bool useIndex = idx && idx->fileSize == fileBytes && idx->hasVideo == hasTheora && idx->hasAudio == hasVorbis &&
+            (!hasTheora || idx->videoSerial == to.serialno) && (!hasVorbis || idx->audioSerial == vo.serialno);
+        if (useIndex) {
+            if (hasTheora) {
+                seekVideoFrame = (ogg_int64_t)(targetSeconds * vFps);
+                startOffset = idx->videoOffset(seekVideoFrame);
+            }
+            if (hasVorbis) {
+                seekAudioSample = (ogg_int64_t)(targetSeconds * aFreq);
+                startOffset = std::min(startOffset, idx->audioOffset(seekAudioSample));
+            }
+            startOffset = std::max(startOffset, dataOffset);    // ͷ 0ضͷҳ
+        }
+        else if (hasTheora) {
+            const ogg_int64_t target = (ogg_int64_t)(targetSeconds * vFps);   // Ŀ֡( 0 )
+            ogg_int64_t before = -1, after = -1;
+            ogg_int64_t offset = bisectPage(to.serialno, target, before, after);
+
+            // Ŀ֡Ĺؼ֮֡һҳĹؼ֡Ŀȡ֮ǰһҳĹؼ֡
+            ogg_int64_t key = 0;
+            if (after >= 0 && keyframeOf(after) <= target) key = keyframeOf(after);
+            else if (before >= 0) key = keyframeOf(before);
+
+            // ؼ֡İʼҳ֮ڻ֮ǰʱҹؼ֮֡ǰһҳ
+            if (before >= 0 && key <= th_granule_frame(td, before))
+                offset = bisectPage(to.serialno, key, before, after);
+
+            startOffset = offset;
+            seekVideoFrame = target;
         }
-        else if (hasVorbis) {
-            targetGranule = (ogg_int64_t)(targetSeconds * aFreq);
+        if (hasVorbis && !useIndex) {
+            const ogg_int64_t target = (ogg_int64_t)(targetSeconds * aFreq);
+            ogg_int64_t before = -1, after = -1;
+            const ogg_int64_t offset = bisectPage(vo.serialno, target, before, after);
+            if (offset < startOffset) startOffset = offset;
+            seekAudioSample = target;
         }
 
         // ļλ  
-        if (!seekToPosition(targetGranule)) return;
+        _fseeki64(infile, startOffset, SEEK_SET);
+        ogg_sync_reset(&oy);
+        eof.store(false);
 
         // ý״̬  
-        resetDecoderState(targetGranule);
+        resetDecoderState();
+        if (startOffset <= dataOffset) {
+            // ׸ҳʼմʱͬ֡/λô 0 ƣصҳĩ
+            // (ҳĩ֮ǰûʽȷλãĩᶪͷһҳƵ)
+            videoNextFrame = 0;
+            audioResync = false;
+            audioSamplePos = 0;
+        }
 
-        //   
-        clearQueues();
+        // оɴε֡/Ѷ peek/pop ʱ(SPSC ֻѶȡ)
     }
 
-    // ļλָ granulepos  
-    bool seekToPosition(ogg_int64_t targetGranule) {
-        // ȡļС  
-        fseek(infile, 0, SEEK_END);
-        long fileSize = ftell(infile);
-
-        // ʵ֣öֲ+  
-        fseek(infile, 0, SEEK_SET);
-        ogg_sync_reset(&oy);
+    //  serial жֲһ"ĩλ < target"ҳʼƫ(ûΪ׸ҳ)
+    // λõλ: Theora Ϊ֡ţVorbis Ϊbefore/after Ŀǰҳ granulepos
+    ogg_int64_t bisectPage(int serial, ogg_int64_t target, ogg_int64_t& before, ogg_int64_t& after) {
+        ogg_int64_t lo = dataOffset, hi = fileBytes, best = dataOffset;
+        before = after = -1;
+        while (hi - lo > SeekLinearBytes) {
+            const ogg_int64_t mid = lo + (hi - lo) / 2;
+            ogg_int64_t gp = -1;
+            seekRaw(mid);
+            const ogg_int64_t at = readStreamPage(hi, serial, gp);
+            if (at < 0) { hi = mid; continue; }                 // [mid, hi) ûиҳ
+            if (streamPosition(serial, gp) < target) { lo = at; best = at; before = gp; }
+            else { hi = mid; after = gp; }
+        }
+        // ʣǰֱĿҳ
+        seekRaw(lo);
+        ogg_int64_t gp = -1, at;
+        while ((at = readStreamPage(-1, serial, gp)) >= 0) {
+            if (streamPosition(serial, gp) < target) { best = at; before = gp; }
+            else { after = gp; break; }
+        }
+        return best;
+    }
 
-        while (!feof(infile)) {
-            if (bufferData() == 0) break;
+    // ̨λļ˳ȡȫļֻҳͷ
+    void startIndexer() {
+        if (indexer.joinable()) return;
+        IndexParams p;
+        p.path = mediaPath;
+        p.hasVideo = hasTheora;
+        p.hasAudio = hasVorbis;
+        p.videoSerial = hasTheora ? to.serialno : 0;
+        p.audioSerial = hasVorbis ? vo.serialno : 0;
+        if (hasTheora) {
+            p.shift = ti.keyframe_granule_shift;
+            p.bias = 1 - th_granule_frame(td, (ogg_int64_t)1 << p.shift);   // °֡Ŵ 1 
+            p.info.videoWidth = vWidth;
+            p.info.videoHeight = vHeight;
+            p.info.videoFps = vFps;
+        }
+        if (hasVorbis) {
+            p.info.audioFreq = aFreq;
+            p.info.audioChannels = aChannels;
+        }
+        indexer = std::thread([this, p]() {
+            SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);   //  IO/CPU ȼ벥
+            std::shared_ptr<SeekIndex> idx = buildIndex(p, indexQuit);
+            if (!idx) return;
+            if (!saveIndex(p.path, *idx))
+                std::fwprintf(stderr, L"[MDecoder] write seek index failed: %ls\n", indexPathFor(p.path).c_str());
+            std::lock_guard<std::mutex> lock(mtxIndex);
+            seekIndex = std::move(idx);
+        });
+    }
 
-            while (ogg_sync_pageout(&oy, &og) > 0) {
-                ogg_int64_t pageGranule = ogg_page_granulepos(&og);
-
-                // ǷΪĿ  
-                if (hasTheora && ogg_page_serialno(&og) == to.serialno) {
-                    if (pageGranule >= targetGranule) {
-                        // ҵĿλã˵ҳ濪ʼ  
-                        long pagePos = ftell(infile) - og.header_len - og.body_len;
-                        fseek(infile, pagePos, SEEK_SET);
-                        ogg_sync_reset(&oy);
-                        return true;
-                    }
+    static std::shared_ptr<SeekIndex> buildIndex(const IndexParams& p, const std::atomic<bool>& cancel) {
+        struct _stat64 st {};
+        if (_wstat64(p.path.c_str(), &st) != 0) return nullptr;
+        FILE* f = _wfopen(p.path.c_str(), L"rb");
+        if (!f) return nullptr;
+
+        auto idx = std::make_shared<SeekIndex>();
+        idx->fileSize = (ogg_int64_t)st.st_size;
+        idx->mtime = (ogg_int64_t)st.st_mtime;
+        idx->hasVideo = p.hasVideo;
+        idx->hasAudio = p.hasAudio;
+        idx->videoSerial = p.videoSerial;
+        idx->audioSerial = p.audioSerial;
+        idx->info = p.info;
+
+        ogg_sync_state sy{};
+        ogg_page pg{};
+        ogg_sync_init(&sy);
+        ogg_int64_t pos = 0;
+        ogg_int64_t lastKey = -1, prevVideoPage = 0, lastVideoGp = -1;
+        ogg_int64_t lastAudioGp = -1, lastAudioEntry = -1;
+        const ogg_int64_t audioStep = std::max(1, p.info.audioFreq / 4);
+        bool ok = true;
+        for (;;) {
+            const long ret = ogg_sync_pageseek(&sy, &pg);
+            if (ret < 0) { pos -= ret; continue; }
+            if (ret == 0) {
+                if (cancel.load()) { ok = false; break; }
+                char* buffer = ogg_sync_buffer(&sy, IndexReadBytes);
+                const std::size_t bytes = std::fread(buffer, 1, IndexReadBytes, f);
+                if (bytes == 0) break;
+                ogg_sync_wrote(&sy, (long)bytes);
+                continue;
+            }
+            const ogg_int64_t at = pos;
+            pos += ret;
+            const ogg_int64_t gp = ogg_page_granulepos(&pg);
+            if (gp < 0) continue;
+            const int serial = ogg_page_serialno(&pg);
+            if (p.hasVideo && serial == p.videoSerial) {
+                // ؼ֡ű˵¹ؼ֡ڱҳһ granulepos Ƶҳʼɽ뵽
+                const ogg_int64_t key = (gp >> p.shift) - p.bias;
+                if (key > lastKey) {
+                    idx->keyframes.push_back({ key, prevVideoPage });
+                    lastKey = key;
                 }
-                else if (hasVorbis && ogg_page_serialno(&og) == vo.serialno) {
-                    if (pageGranule >= targetGranule) {
-                        long pagePos = ftell(infile) - og.header_len - og.body_len;
-                        fseek(infile, pagePos, SEEK_SET);
-                        ogg_sync_reset(&oy);
-                        return true;
-                    }
+                prevVideoPage = at;
+                lastVideoGp = gp;
+            }
+            else if (p.hasAudio && serial == p.audioSerial) {
+                if (lastAudioEntry < 0 || gp - lastAudioEntry >= audioStep) {
+                    idx->audio.push_back({ gp, at });
+                    lastAudioEntry = gp;
                 }
+                lastAudioGp = gp;
             }
         }
+        ogg_sync_clear(&sy);
+        std::fclose(f);
+        if (!ok) return nullptr;
+
+        if (p.hasVideo && lastVideoGp >= 0 && p.info.videoFps > 0.0) {
+            const ogg_int64_t mask = ((ogg_int64_t)1 << p.shift) - 1;
+            const ogg_int64_t frame = (lastVideoGp >> p.shift) + (lastVideoGp & mask) - p.bias;
+            idx->info.videoDuration = (double)(frame + 1) / p.info.videoFps;
+        }
+        if (p.hasAudio && lastAudioGp >= 0 && p.info.audioFreq > 0)
+            idx->info.audioDuration = (double)lastAudioGp / p.info.audioFreq;
+        return idx;
+    }
 
-        return false;
+    ogg_int64_t streamPosition(int serial, ogg_int64_t gp) {
+        return (hasTheora && serial == to.serialno) ? th_granule_frame(td, gp) : gp;
     }
 
-    // ý״̬  
-    void resetDecoderState(ogg_int64_t targetGranule) {
-        if (hasTheora && td) {
-            //  Theora  granule λ<cite repo="xiph/theora" path="include/theora/theoradec.h" line="67" line="78" />  
-            th_decode_ctl(td, TH_DECCTL_SET_GRANPOS, &targetGranule, sizeof(targetGranule));
-        }
+    // granulepos ֡Ĺؼ֡
+    ogg_int64_t keyframeOf(ogg_int64_t gp) {
+        const int shift = ti.keyframe_granule_shift;
+        return th_granule_frame(td, (gp >> shift) << shift);
+    }
 
-        if (hasVorbis) {
-            // Vorbis Ҫ³ʼ״̬  
-            vorbis_synthesis_restart(&vd);
+    // õҳȡseekRaw  pos ͬreadPage һҳʼƫ
+    void seekRaw(ogg_int64_t pos) {
+        _fseeki64(infile, pos, SEEK_SET);
+        ogg_sync_reset(&oy);
+        seekCursor = pos;
+    }
+    ogg_int64_t readPage(ogg_int64_t limit) {
+        for (;;) {
+            if (limit >= 0 && seekCursor >= limit) return -1;
+            const long ret = ogg_sync_pageseek(&oy, &og);
+            if (ret < 0) seekCursor -= ret;                     // ҳ
+            else if (ret > 0) { const ogg_int64_t at = seekCursor; seekCursor += ret; return at; }
+            else if (bufferData() == 0) return -1;
+        }
+    }
+    // һ serial Ҵ granulepos ҳ(ֻҳ granulepos Ϊ -1)
+    ogg_int64_t readStreamPage(ogg_int64_t limit, int serial, ogg_int64_t& gp) {
+        ogg_int64_t at;
+        while ((at = readPage(limit)) >= 0) {
+            if (ogg_page_serialno(&og) != serial) continue;
+            gp = ogg_page_granulepos(&og);
+            if (gp >= 0) return at;
         }
+        return -1;
     }
 
-    //   
-    void clearQueues() {
-        {
-            std::lock_guard<std::mutex> lock(mtxVideo);
-            freeVideoFrameChain(videoHead);
-            videoHead = nullptr;
-            videoTail = nullptr;
+    // ý״̬  
+    void resetDecoderState() {
+        if (hasTheora) {
+            ogg_stream_reset(&to);
+            videoResync = true;
+            videoNextFrame = -1;
         }
-        {
-            std::lock_guard<std::mutex> lock(mtxAudio);
-            freeAudioPacketChain(audioHead);
-            audioHead = nullptr;
-            audioTail = nullptr;
+        if (hasVorbis) {
+            // Vorbis Ҫ³ʼ״̬  
+            ogg_stream_reset(&vo);
+            vorbis_synthesis_restart(&vd);
+            audioResync = true;
         }
     }
 
@@ -698,58 +1478,10 @@ private:
         }
     }
 
-    // ȡһ֡ظ֡  
-    VideoFrame* getLastVideoFrame() {
-        std::lock_guard<std::mutex> lock(mtxVideo);
-        VideoFrame* current = videoHead;
-        VideoFrame* last = nullptr;
-        while (current) {
-            last = current;
-            current = current->next;
-        }
-        return last;
-    }
-
-    // Ƶ֡  
-    VideoFrame* duplicateVideoFrame(VideoFrame* src, std::uint32_t gen) {
-        if (!src) return nullptr;
-
-        VideoFrame* vf = (VideoFrame*)std::malloc(sizeof(VideoFrame));
-        if (!vf) return nullptr;
-
-        std::uint8_t* px = (std::uint8_t*)std::malloc(src->dataBytes);
-        if (!px) {
-            std::free(vf);
-            return nullptr;
-        }
-
-        std::memcpy(px, src->pixels, src->dataBytes);
-
-        vf->seek_generation = gen;
-        vf->playms = src->playms;
-        vf->fps = src->fps;
-        vf->width = src->width;
-        vf->height = src->height;
-        vf->format = src->format;
-        vf->stride = src->stride;
-        vf->dataBytes = src->dataBytes;
-        vf->pixels = px;
-        vf->next = nullptr;
-
-        return vf;
-    }
-
     void cleanup() {
         if (infile) { std::fclose(infile); infile = nullptr; }
         // ն
-        {
-            std::lock_guard<std::mutex> lock(mtxVideo);
-            freeVideoFrameChain(videoHead); videoHead = nullptr; videoTail = nullptr;
-        }
-        {
-            std::lock_guard<std::mutex> lock(mtxAudio);
-            freeAudioPacketChain(audioHead); audioHead = nullptr; audioTail = nullptr;
-        }
+        drainQueues();
     }
 
 
@@ -764,13 +1496,21 @@ private:
     std::atomic<bool> seekRequested{ false };
     std::atomic<double> seekTargetSeconds{ 0.0 };
 
-    // Уͷβ
-    VideoFrame* videoHead = nullptr;
-    VideoFrame* videoTail = nullptr;
-    AudioPacket* audioHead = nullptr;
-    AudioPacket* audioTail = nullptr;
-    std::mutex mtxVideo;
-    std::mutex mtxAudio;
+    // (SPSC ζУ߳д̶߳)
+    SpscRing<VideoFrame> videoQueue;
+    SpscRing<AudioPacket> audioQueue;
+    QueueConfig queueConfig;                        // setQueueConfig д룬start ʱЧ
+    QueueConfig activeQueue;                        // νʹõ
+    std::atomic<std::int64_t> queuedAudioFrames{ 0 };
+    std::int64_t audioFrameLimit = 0;               //  audioMs ʻ㣬0 ʾʱ
+    std::atomic<std::int32_t> queueFreq{ 0 };
+    std::mutex mtxWait;                             // ڽ߳/ѣ
+    std::condition_variable cvSpace;
+    std::atomic<bool> producerWaiting{ false };
+    std::atomic<std::uint64_t> producerWaits{ 0 };
+    std::atomic<std::uint64_t> droppedVideo{ 0 };
+    std::atomic<std::uint64_t> droppedAudio{ 0 };
+    std::atomic<std::uint64_t> staleFlushed{ 0 };
 
     // Ogg/Theora/Vorbis״̬
     ogg_sync_state   oy{};
@@ -798,4 +1538,27 @@ private:
     double vFps = 0.0;
     int aFreq = 0, aChannels = 0;
     DWORD startTicks = 0;
+
+    // seek ״̬(̷߳)
+    static constexpr ogg_int64_t SeekLinearBytes = 64 * 1024;    // СڴֵΪɨ
+    ogg_int64_t fileBytes = 0;
+    ogg_int64_t dataOffset = 0;         // ׸ҳļƫ(probeHeaders ¼)
+    ogg_int64_t seekCursor = 0;         // ֶȡʱһֽڵļƫ
+    ogg_int64_t seekVideoFrame = -1;    // ڸ֡ŵ֡
+    ogg_int64_t seekAudioSample = -1;   // ڸλõ
+    ogg_int64_t videoNextFrame = -1;    // ͬʱһ Theora ֡
+    ogg_int64_t audioSamplePos = 0;     // һλ
+    bool videoResync = false;           // seek ȴؼ֡
+    bool audioResync = false;           // seek ȴ granulepos İ
+
+    // λ(̷߳߳ seek ʱȡ)
+    std::wstring mediaPath;
+    bool indexEnabled = false;
+    std::thread indexer;
+    std::atomic<bool> indexQuit{ false };
+    std::mutex mtxIndex;
+    std::shared_ptr<const SeekIndex> seekIndex;
+
+    // ֡/ճ(üʱ close)
+    MediaPool* pool = new MediaPool();
 };
\ No newline at end of file
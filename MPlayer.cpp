@@ -45,6 +45,8 @@ using json = nlohmann::json;
 #include <filamat/MaterialBuilder.h>
 
 #include "shadertoy_effects.h"
+#include "mlrc.h"
+#include "meq.h"
 
 // 频谱条可视化 — 独立 FFT 实现
 #include "avfft_standalone.h"
@@ -90,6 +92,8 @@ extern "C" {
 // miniaudio (single header, define implementation here)
 #define MINIAUDIO_IMPLEMENTATION
 #include "miniaudio/miniaudio.h"
+#include "mloud.h"
+#include "mvfs.h"
 
 #define HOTKEY_TOGGLE 1
 #define HOTKEY_VK VK_F5
@@ -143,11 +147,6 @@ struct PlaylistInfo {
     int scanInterval = 3600;
 };
 
-struct LrcLine {
-    double timestamp;   // seconds
-    std::string text;
-};
-
 #define FILAMENT_LIB_PATH "e:/MX/3rd/lib/filament/mt/"
 #pragma comment(lib, FILAMENT_LIB_PATH "filament.lib")
 #pragma comment(lib, FILAMENT_LIB_PATH "backend.lib")
@@ -1313,6 +1312,10 @@ struct AppState {
     ma_device audioDevice{};
     std::atomic<uint64_t> audioSamplesPlayed{0};
     AudioQueue audioQueue{kAudioBufCapacity};
+    meq::Equalizer equalizer;   // 设备回调内原地处理，参数可由 UI 线程无锁调整
+    mvfs::MappedVfs vfs;        // 响度分析解码用的内存映射 VFS(须先于 loudness 声明)
+    mloud::Analyzer loudness;   // 后台响度分析，结果缓存在 MData/loudness.cache
+    float trackGain = 1.0f;     // 当前曲目的响度增益，切歌时并入设备主音量
 	float volume = 0.5f;// 默认音量 50%
     static constexpr int AUDIO_SAMPLE_RATE = kAudioSampleRate;
     static constexpr int AUDIO_CHANNELS = kAudioChannels;
@@ -1385,7 +1388,7 @@ struct AppState {
     OX::UIDropdown* playlistDropdownPtr = nullptr;
 
     // --- Lyrics ---
-    std::vector<LrcLine> lrcLines;
+    mlrc::Document lrcLines;    // 各行以偏移引用同一块文本，不做逐行分配
     bool showLyrics = true;
     OX::UIFrame* lrcPanelPtr = nullptr;
     OX::UILabel* lrcLabels[7] = {};
@@ -1398,21 +1401,17 @@ struct AppState {
 };
 
 /*==================== 歌词更新 ====================*/
+// 第 i 行歌词文本(空文本行显示为 ♪)
+static const char* lrcText(const mlrc::Document& doc, int i) {
+    const mlrc::Line& l = doc[i];
+    return l.len ? doc.c_str(l) : "♪";
+}
+
 static void updateLyrics(AppState& st) {
     if (st.lrcLines.empty()) return;
 
     // 二分查找当前时间点对应的歌词行
-    int idx = -1;
-    int lo = 0, hi = (int)st.lrcLines.size() - 1;
-    while (lo <= hi) {
-        int mid = (lo + hi) / 2;
-        if (st.lrcLines[mid].timestamp <= st.videoTime) {
-            idx = mid;
-            lo = mid + 1;
-        } else {
-            hi = mid - 1;
-        }
-    }
+    int idx = st.lrcLines.indexAt((float)st.videoTime);
 
     // 如果没变，跳过 label 更新
     if (idx == st.lrcCurrentIndex) return;
@@ -1423,7 +1422,7 @@ static void updateLyrics(AppState& st) {
         if (!st.lrcLabels[i]) continue;
         int lineIdx = idx + (i - 3);  // offset from center line
         if (lineIdx >= 0 && lineIdx < (int)st.lrcLines.size()) {
-            st.lrcLabels[i]->setText(st.lrcLines[lineIdx].text.c_str());
+            st.lrcLabels[i]->setText(lrcText(st.lrcLines, lineIdx));
             // 高亮当前行 (index 3 = center)
             if (i == 3) {
                 st.lrcLabels[i]->fontSize = 18.0f;
@@ -1550,7 +1549,7 @@ static void renderLyricsToFbo(AppState& st, float lrcX, float lrcY, float lrcW,
         int lineIdx = st.lrcCurrentIndex + (i - 3);
         if (lineIdx < 0 || lineIdx >= (int)st.lrcLines.size()) continue;
         auto txt = tvg::Text::gen();
-        txt->text(st.lrcLines[lineIdx].text.c_str());
+        txt->text(lrcText(st.lrcLines, lineIdx));
         txt->font(fontName);
         txt->translate(lrcX + lrcW / 2.0f, startY + i * lineH + lineH / 2.0f - 4.0f);
         txt->align(0.5f, 0.5f);
@@ -1950,6 +1949,8 @@ static void ma_data_callback(ma_device* pDevice, void* pOutput, const void* /*pI
     if (got < needed) {
         memset(out + got, 0, (needed - got) * sizeof(float));
     }
+    // 均衡器(无锁、不分配)；放在频谱采集之前，可视化与听到的一致
+    st->equalizer.process(out, frameCount);
     // 捕获单声道 PCM 到 FFT 环形缓冲
     if (st->avRingBuf && st->avRingBuf->cap > 0 && got > 0) {
         ma_uint32 gotFrames = (ma_uint32)(got / st->AUDIO_CHANNELS);
@@ -1970,6 +1971,7 @@ static void ma_data_callback(ma_device* pDevice, void* pOutput, const void* /*pI
 
 /*==================== cleanup ====================*/
 static void cleanup(AppState& st) {
+    st.loudness.stop();
     if (st.audioDevice.pUserData) {
         ma_device_uninit(&st.audioDevice);
     }
@@ -2044,6 +2046,16 @@ static bool loadMediaFile(AppState& st, const char* path, int winW, int winH) {
     st.decoder.close();
     if (!st.decoder.open(path)) return false;
 
+    // 响度增益只在切歌时查一次缓存，并入设备主音量；尚未分析的文件按 1.0 播放并排到分析队列
+    mloud::Result loud;
+    if (st.loudness.lookup(std::filesystem::u8path(path), loud)) {
+        st.trackGain = loud.linearGain();
+    } else {
+        st.trackGain = 1.0f;
+        st.loudness.analyze({ std::filesystem::u8path(path) });
+    }
+    if (st.audioDevice.pUserData) ma_device_set_master_volume(&st.audioDevice, st.volume * st.trackGain);
+
     st.videoW = st.decoder.getWidth();
     st.videoH = st.decoder.getHeight();
 
@@ -2160,80 +2172,42 @@ static void updateRightInfo(AppState& st) {
 }
 
 /*==================== LRC 歌词解析 ====================*/
-static bool parseLRC(const char* lrcPath, std::vector<LrcLine>& lines) {
-    FILE* f = nullptr;
-    fopen_s(&f, lrcPath, "rb");
-    if (!f) return false;
-
-    lines.clear();
-    char buf[1024];
-    while (fgets(buf, sizeof(buf), f)) {
-        // 跳过空行和注释
-        if (buf[0] == '\0' || buf[0] == '\n' || buf[0] == '\r') continue;
-
-        // 解析 [mm:ss.xx] 或 [mm:ss.xxx] 时间戳
-        char* p = buf;
-        std::vector<double> timestamps;
-        while (*p == '[') {
-            int min = 0, sec_int = 0, frac = 0;
-            if (sscanf_s(p, "[%d:%d.%d]", &min, &sec_int, &frac) == 3) {
-                // 处理 .xx (百分秒) 和 .xxx (毫秒)
-                double sec = sec_int;
-                if (frac < 100)      sec += frac / 100.0;   // .xx = 百分秒
-                else                 sec += frac / 1000.0;  // .xxx = 毫秒
-                timestamps.push_back(min * 60.0 + sec);
-            }
-            // 跳到下一个 ]
-            char* close = strchr(p, ']');
-            if (!close) break;
-            p = close + 1;
-        }
-
-        // 提取歌词文本（跳过前导空白）
-        while (*p == ' ' || *p == '\t') p++;
-        // 去除尾部换行
-        size_t len = strlen(p);
-        while (len > 0 && (p[len - 1] == '\n' || p[len - 1] == '\r')) p[--len] = '\0';
-
-        std::string text(p);
-        if (text.empty()) text = "♪";
-
-        for (double ts : timestamps) {
-            lines.push_back({ts, text});
-        }
-    }
-    fclose(f);
-
-    // 按时间戳排序
-    std::sort(lines.begin(), lines.end(),
-        [](const LrcLine& a, const LrcLine& b) { return a.timestamp < b.timestamp; });
+static bool parseLRC(const char* lrcPath, mlrc::Document& doc) {
+    bool ok = doc.loadFile(lrcPath);
+    OX_LOG("[Lyrics] Parsed %zu lines from %s\n", doc.size(), lrcPath);
+    return ok;
+}
 
-    OX_LOG("[Lyrics] Parsed %zu lines from %s\n", lines.size(), lrcPath);
-    return !lines.empty();
+// 直接解析内存中的 LRC 文本(内嵌歌词)，不经过临时文件
+static bool parseLRCText(std::string_view text, mlrc::Document& doc) {
+    return doc.parse(text);
 }
 
-// 将纯文本歌词（无时间戳）转换为 LrcLine 格式，按歌曲时长均匀分布时间
-static void parsePlainLyrics(const std::string& text, std::vector<LrcLine>& lines, double duration) {
-    lines.clear();
+// 将纯文本歌词（无时间戳）转换为歌词文档，按歌曲时长均匀分布时间
+static void parsePlainLyrics(std::string_view text, mlrc::Document& doc, double duration) {
+    doc.clear();
     if (text.empty()) return;
 
-    // 按换行符分割
-    std::istringstream iss(text);
-    std::vector<std::string> rawLines;
-    std::string line;
-    while (std::getline(iss, line)) {
-        // 去掉首尾空白和回车符
-        while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) line.pop_back();
+    // 按换行符分割(只保存视图，文本由 addLine 追加进文档存储)
+    std::vector<std::string_view> rawLines;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t end = text.find('\n', pos);
+        if (end == std::string_view::npos) end = text.size();
+        std::string_view line = text.substr(pos, end - pos);
+        // 去掉尾部空白和回车符
+        while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) line.remove_suffix(1);
         if (!line.empty()) rawLines.push_back(line);
+        pos = end + 1;
     }
     if (rawLines.empty()) return;
 
     // 按歌曲时长均匀分布时间戳
     double interval = duration / (double)(rawLines.size() + 1);
     for (size_t i = 0; i < rawLines.size(); i++) {
-        lines.push_back({interval * (i + 1), rawLines[i]});
+        doc.addLine((float)(interval * (i + 1)), rawLines[i]);
     }
-    OX_LOG("[Lyrics] Parsed %zu plain text lines, interval=%.1fs\n", lines.size(), interval);
+    OX_LOG("[Lyrics] Parsed %zu plain text lines, interval=%.1fs\n", doc.size(), interval);
 }
 
 static void loadLyrics(AppState& st) {
@@ -2247,21 +2221,11 @@ static void loadLyrics(AppState& st) {
         // 检查是否包含 LRC 时间戳 [mm:ss
         if (embedded.find("[") != std::string::npos &&
             embedded.find(":") != std::string::npos) {
-            // 尝试将内嵌歌词写入临时文件然后用 parseLRC 解析
-            // 因为内嵌歌词可能使用 \r\n 或 \n 分隔
-            std::string tmpPath = "e:/MX/Data/_lrc_temp.lrc";
-            std::ofstream ofs(tmpPath, std::ios::binary);
-            if (ofs) {
-                ofs << embedded;
-                ofs.close();
-                if (parseLRC(tmpPath.c_str(), st.lrcLines)) {
-                    st.lrcCurrentIndex = 0;
-                    st.lrcLines = st.lrcLines; // keep
-                    OX_LOG("[Lyrics] Parsed embedded LRC lyrics: %zu lines\n", st.lrcLines.size());
-                    std::remove(tmpPath.c_str());
-                    return;
-                }
-                std::remove(tmpPath.c_str());
+            // 直接在内存中解析(支持 \r\n / \n 分隔)
+            if (parseLRCText(embedded, st.lrcLines)) {
+                st.lrcCurrentIndex = 0;
+                OX_LOG("[Lyrics] Parsed embedded LRC lyrics: %zu lines\n", st.lrcLines.size());
+                return;
             }
         }
         // 纯文本内嵌歌词：按时长均匀分布
@@ -2716,6 +2680,17 @@ static void applyConfig(AppState& st) {
             }
         }
 
+        // ---- player.equalizer (enable / preset) ----
+        if (cfg.contains("player") && cfg["player"].contains("equalizer")) {
+            const auto& eq = cfg["player"]["equalizer"];
+            st.equalizer.setEnabled(eq.value("enable", false));
+            std::string preset = eq.value("preset", std::string("flat"));
+            if (!st.equalizer.applyPreset(preset.c_str())) {
+                OX_LOG("[Config] unknown equalizer preset: %s\n", preset.c_str());
+            }
+            OX_LOG("[Config] equalizer %s, preset %s\n", st.equalizer.isEnabled() ? "on" : "off", preset.c_str());
+        }
+
         // ---- 加载歌单 ----
         loadPlaylists(st);
 
@@ -2819,6 +2794,16 @@ int main() {
     std::vector<std::string> scanDirs {kScanDirs[0], kScanDirs[1]};
     scanMediaFiles(st.mediaFiles, scanDirs);
     OX_LOG("[MAIN] Initial scan: %zu files from %s, %s\n", st.mediaFiles.size(), kScanDirs[0], kScanDirs[1]);
+    {
+        // 后台分析响度(miniaudio 能解码的音频文件；视频容器会计为失败并跳过)
+        wchar_t exePath[MAX_PATH];
+        GetModuleFileNameW(nullptr, exePath, MAX_PATH);
+        st.loudness.setVfs(st.vfs.get());
+        st.loudness.setCacheFile(std::filesystem::path(exePath).parent_path() / "MData" / "loudness.cache");
+        std::vector<std::filesystem::path> files;
+        for (const auto& f : st.mediaFiles) files.push_back(std::filesystem::u8path(f));
+        st.loudness.analyze(files);
+    }
     // Insert test FLAC as first item
     if (std::filesystem::exists(kDefaultFlac)) {
         for (size_t i = 0; i < st.mediaFiles.size(); i++) {
@@ -2997,11 +2982,12 @@ int main() {
     aConfig.sampleRate        = st.AUDIO_SAMPLE_RATE;
     aConfig.dataCallback      = ma_data_callback;
     aConfig.pUserData         = &st;
+    st.equalizer.init(st.AUDIO_SAMPLE_RATE, st.AUDIO_CHANNELS, 10);
     if (ma_device_init(nullptr, &aConfig, &st.audioDevice) != MA_SUCCESS) {
         OX_LOG("[MAIN] miniaudio device init failed\n");
         cleanup(st); st.app.destroy(); timeEndPeriod(1); return 1;
     }
-    ma_device_set_master_volume(&st.audioDevice, st.volume);
+    ma_device_set_master_volume(&st.audioDevice, st.volume * st.trackGain);
 
     // ---------- 8. ThorVG / OUI ----------
     if (tvg::Initializer::init(0) != tvg::Result::Success) {
@@ -3306,7 +3292,7 @@ int main() {
             volSlider->value = st.volume;
             volSlider->onValueChanged = [&st](float val) {
                 st.volume = val;
-                ma_device_set_master_volume(&st.audioDevice, val);
+                ma_device_set_master_volume(&st.audioDevice, val * st.trackGain);
             };
             st.volumeSliderPtr = volSlider.get();
             st.ui.addElement(std::move(volSlider));
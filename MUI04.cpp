@@ -73,6 +73,7 @@ namespace {
 
             if (btnPrev) btnPrev->onClick = [this]() { if (player) { player->preSong(); updateSongInfo(); } };
             if (btnNext) btnNext->onClick = [this]() { if (player) { player->nextSong(); updateSongInfo(); } };
+            player->onTrackChanged = [this](int32_t) { updateSongInfo(); };  // 无缝切到下一首
             if (btnPlay) btnPlay->onClick = [this]() {
                 if (!player) return;
                 auto st = player->getPlaybackState();
@@ -108,7 +109,7 @@ namespace {
             // 设置歌词时间提供器  
             if (lyricView && player) {
                 lyricView->setTimeProvider([this]() {
-                    return player->getCurrentPosition();  // 修正:使用 getCurrentPosition()  
+                    return static_cast<float>(player->getPlaybackPosition());  // 插值时钟，歌词滚动不随帧抖动
                     });
             }
         }
@@ -329,7 +330,7 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
     auto playlist = std::make_unique<MUI::PlayList>();
     playlist->rect = MUI::Rect(950, 80, 310, 520);
     playlist->fontName = "siyuan.ttf";
-    playlist->setItems(player.getSongLibrary());
+    playlist->setItems(player.getLibrarySnapshot());
     auto playlistRaw = playlist.get();
     ui->addElement(std::move(playlist));
 
@@ -22,6 +22,7 @@
 #pragma comment(lib, "Dwmapi.lib")
 
 #include <cstdio>
+#include <cstring>
 #include <io.h>
 #include <fcntl.h>
 #include <string>
@@ -147,6 +148,7 @@ namespace {
             };
             if (btnPrev) btnPrev->onClick = [this]() { if (player) { player->preSong(); updateSongInfo(); } };
             if (btnNext) btnNext->onClick = [this]() { if (player) { player->nextSong(); updateSongInfo(); } };
+            player->onTrackChanged = [this](int32_t) { updateSongInfo(); };  // 无缝切到下一首
             if (btnPlay) btnPlay->onClick = [this]() {
                 if (!player) return;
                 auto st = player->getPlaybackState();
@@ -171,7 +173,7 @@ namespace {
                 search->onTextChanged = [this](const std::string& q) { applyFilter(q); };
             }
             if (lyricView && player) {
-                lyricView->setTimeProvider([this]() { return player->getCurrentPosition(); });
+                lyricView->setTimeProvider([this]() { return static_cast<float>(player->getPlaybackPosition()); });
             }
         }
 
@@ -273,7 +275,9 @@ namespace {
 } // namespace
 
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow) {
-    (void)hInstance; (void)hPrevInstance; (void)lpCmdLine; (void)nCmdShow;
+    (void)hInstance; (void)hPrevInstance; (void)nCmdShow;
+    // --no-prewarm: 不预热播放列表字形(与预热时的首帧耗时对比)
+    const bool prewarmGlyphs = !(lpCmdLine && strstr(lpCmdLine, "--no-prewarm"));
 //int main(int argc, char** argv) {
     //(void)argc; (void)argv;
     _setmode(_fileno(stdout), _O_U16TEXT);
@@ -293,8 +297,13 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
     // 应用窗口效果（分层半透明 + 圆角）
     applyWindowEffects(app.getHwnd());
 
-    app.loadFontFromResource(IDR_FONT_SIYUAN, "siyuan.ttf");
-    app.loadFontFromResource(IDR_FONT_FUHAO, "fuhao.ttf");
+    // 资源缺失时退回可执行文件目录下的同名字体文件
+    if (!app.loadFontFromResource(IDR_FONT_SIYUAN, "siyuan.ttf")) {
+        app.loadFontFromFile(MUI::getExecutableDirectory() + L"\\siyuan.ttf", "siyuan.ttf");
+    }
+    if (!app.loadFontFromResource(IDR_FONT_FUHAO, "fuhao.ttf")) {
+        app.loadFontFromFile(MUI::getExecutableDirectory() + L"\\fuhao.ttf", "fuhao.ttf");
+    }
 
     MUI::MPlayer player;
     if (!player.init()) {
@@ -334,8 +343,9 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
     auto lblArtistRaw = lblArtist.get(); ui->addElement(std::move(lblArtist));
 
     auto playlist = std::make_unique<MUI::PlayList>();
-    playlist->rect = MUI::Rect(950, 80, 310, 520); playlist->fontName = "siyuan.ttf"; playlist->setItems(player.getSongLibrary());
+    playlist->rect = MUI::Rect(950, 80, 310, 520); playlist->fontName = "siyuan.ttf"; playlist->setItems(player.getLibrarySnapshot());
     auto playlistRaw = playlist.get(); ui->addElement(std::move(playlist));
+    if (prewarmGlyphs) app.prewarmGlyphs("siyuan.ttf", 14.0f, playlistRaw->getDisplayText());   // 主循环空隙中分块构建
 
     auto searchBox = std::make_unique<MUI::UITextInput>();
     searchBox->rect = MUI::Rect(740, 520, 320, 32); searchBox->fontName = "siyuan.ttf"; searchBox->setText(u8"");
@@ -0,0 +1,200 @@
+﻿/****************************************************************************
+ * 标题: TEST-BatchAnimator - BatchAnimator 正确性核对与吞吐基准
+ * 文件: TEST-BatchAnimator.cpp
+ * 功能: 1) 随机生成关键帧轨道(含循环/延迟/零时长/各类缓动)，逐帧把 BatchAnimator 的输出
+ *          与 Transition 的逐轨道标量求值对比；
+ *       2) 10 万条轨道(float/ColorF 混合)逐帧 update，统计每帧耗时(目标 < 1 ms)；
+ *       3) Animator(Binder 逐属性绑定)逐帧 update 期间计数 malloc，须为 0。
+ * 用法: TEST-BatchAnimator [轨道数=100000] [帧数=2000]
+ *       VS2022: Debug 构建经 _CrtSetAllocHook 计数；Linux: g++ -O2 -static-libstdc++ -Wl,--wrap=malloc
+ *       (operator new 须静态链接才经过 __wrap_malloc，计数先自检)
+ *       核对失败、每帧平均耗时超过 1 ms 或 Animator::update 出现堆分配时返回 1；
+ *       无法计数 malloc 的构建只打印分配检查不可用
+ * 依赖: C++17, manimation_ext.h
+ * 环境: Windows11 x64, VS2022 (Release) / Linux g++ -O2，控制台程序
+ * 编码: UTF-8 (BOM)
+ ****************************************************************************/
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#if defined(_MSC_VER) && defined(_DEBUG)
+#include <crtdbg.h>
+#endif
+
+#include "manimation_ext.h"
+
+using namespace manim;
+
+static std::atomic<long> g_mallocs{ 0 };
+
+#if defined(_MSC_VER) && defined(_DEBUG)
+#define TEST_COUNTS_MALLOC 1
+static int allocHook(int type, void*, size_t, int, long, const unsigned char*, int) {
+    if (type == _HOOK_ALLOC || type == _HOOK_REALLOC) g_mallocs.fetch_add(1, std::memory_order_relaxed);
+    return TRUE;
+}
+static void installCounter() { _CrtSetAllocHook(allocHook); }
+#elif defined(__GLIBC__)
+#define TEST_COUNTS_MALLOC 1
+extern "C" void* __real_malloc(size_t);
+extern "C" void* __wrap_malloc(size_t n) {
+    g_mallocs.fetch_add(1, std::memory_order_relaxed);
+    return __real_malloc(n);
+}
+static void installCounter() {}
+#else
+static void installCounter() {}
+#endif
+
+static void* volatile g_sink = nullptr;
+
+// 计数自检: operator new 必须被计入(动态链接的 libstdc++ 会绕过 __wrap_malloc)
+static bool counterWorks() {
+    const long before = g_mallocs.load();
+    g_sink = new char[4096];
+    delete[] static_cast<char*>(g_sink);
+    return g_mallocs.load() != before;
+}
+
+static std::vector<Keyframe<float>> randomKeys(std::mt19937& rng) {
+    std::uniform_real_distribution<float> u(0.0f, 1.0f);
+    std::vector<Keyframe<float>> keys;
+    int n = 1 + (int)(rng() % 5);
+    for (int k = 0; k < n; ++k) {
+        float t = (k == 0 && (rng() & 1)) ? 0.0f : u(rng);
+        keys.emplace_back(t, u(rng) * 200.0f - 100.0f, (EasingType)(rng() % 6));
+    }
+    return keys;
+}
+
+// BatchAnimator 与 Transition(逐轨道标量实现)逐帧比对
+static int runCheck() {
+    std::mt19937 rng(20261019);
+    const int tracks = 2000;
+    std::vector<float> batchOut(tracks), refOut(tracks);
+    std::vector<Transition<float>> refs(tracks);
+    std::vector<float> delays(tracks), durations(tracks);
+    std::vector<bool> loops(tracks);
+    BatchAnimator batch;
+
+    for (int i = 0; i < tracks; ++i) {
+        auto keys = randomKeys(rng);
+        delays[i] = (rng() % 4) * 0.25f;
+        durations[i] = (rng() % 16 == 0) ? 0.0f : 0.5f + (rng() % 8) * 0.25f;
+        loops[i] = (rng() % 3) == 0;
+        for (const auto& k : keys) refs[i].addKeyframe(k);
+        batch.addTrack(&batchOut[i], keys, durations[i], delays[i], loops[i]);
+    }
+
+    double maxErr = 0.0;
+    for (int f = 0; f < 600; ++f) {
+        float t = (f % 200 == 199) ? 0.1f * (f / 200) : f * (1.0f / 60.0f);   // 偶尔回跳
+        batch.evaluate(t);
+        for (int i = 0; i < tracks; ++i) {
+            // 与 BatchAnimator 同样以倒数相乘求进度，避免陡峭缓动段把舍入差异放大
+            float p = durations[i] > 0.0f ? (t - delays[i]) * (1.0f / durations[i]) : 1.0f;
+            p = loops[i] && durations[i] > 0.0f ? p - std::floor(p) : std::max(0.0f, std::min(1.0f, p));
+            refOut[i] = refs[i].getValueAt(p);
+            maxErr = std::max(maxErr, (double)std::fabs(refOut[i] - batchOut[i]));
+        }
+    }
+    bool ok = maxErr < 1e-3;
+    std::printf("check: %d tracks x 600 frames, max |batch - transition| = %.2e %s\n",
+        tracks, maxErr, ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
+
+static int runBenchmark(int tracks, int frames) {
+    using Clock = std::chrono::steady_clock;
+    std::mt19937 rng(7);
+    std::vector<float> floats(tracks / 2);
+    std::vector<ColorF> colors((tracks - tracks / 2 + 3) / 4);
+    BatchAnimator batch;
+
+    for (auto& f : floats) batch.addTrack(&f, randomKeys(rng), 1.0f + (rng() % 4), (rng() % 8) * 0.1f, (rng() & 1) != 0);
+    for (auto& c : colors) {
+        std::vector<Keyframe<ColorF>> keys{ { 0.0f, ColorF(0, 0, 0, 0), EasingType::Linear },
+            { 0.5f, ColorF(1, 0.5f, 0.2f, 1), EasingType::EaseOutBack }, { 1.0f, ColorF(0, 1, 1, 0.5f), EasingType::EaseInOut } };
+        batch.addTrack(&c, keys, 2.0f, (rng() % 8) * 0.1f, true);
+    }
+
+    for (int f = 0; f < 30; ++f) batch.update(1.0f / 60.0f);   // 预热: 定位各轨道首段
+
+    double total = 0.0, worst = 0.0;
+    for (int f = 0; f < frames; ++f) {
+        auto t0 = Clock::now();
+        batch.update(1.0f / 60.0f);
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+        total += ms;
+        worst = std::max(worst, ms);
+    }
+    double avg = total / frames;
+    std::printf("bench: %zu tracks, %d frames: avg %.3f ms, worst %.3f ms per update (%.1f ns/track)\n",
+        batch.size(), frames, avg, worst, avg * 1e6 / batch.size());
+    return avg < 1.0 ? 0 : 1;
+}
+
+// Animator 逐帧 update(经 Binder::apply 写入属性)不得触发堆分配
+static int runAllocCheck() {
+    std::mt19937 rng(11);
+    const int binders = 1000;
+    std::vector<float> floats(binders / 2);
+    std::vector<ColorF> colors(binders - binders / 2);
+    Animator anim;
+
+    for (auto& f : floats) {
+        Transition<float> t;
+        for (const auto& k : randomKeys(rng)) t.addKeyframe(k);
+        float* target = &f;
+        anim.addProperty<float>(std::move(t), [target](const float& v) { *target = v; }, "float");
+    }
+    for (auto& c : colors) {
+        Transition<ColorF> t;
+        t.addKeyframe({ 0.0f, ColorF(0, 0, 0, 0), EasingType::Linear });
+        t.addKeyframe({ 0.5f, ColorF(1, 0.5f, 0.2f, 1), EasingType::EaseOutBack });
+        t.addKeyframe({ 1.0f, ColorF(0, 1, 1, 0.5f), EasingType::EaseInOut });
+        ColorF* target = &c;
+        anim.addProperty<ColorF>(std::move(t), [target](const ColorF& v) { *target = v; }, "color");
+    }
+    anim.getTimeline().setDuration(2.0f);
+    anim.getTimeline().setLoop(true);
+    anim.getTimeline().play();
+
+    const int frames = 600;
+    const long before = g_mallocs.load();
+    for (int f = 0; f < frames; ++f) anim.update(1.0f / 60.0f);
+    const long allocs = g_mallocs.load() - before;
+
+    // 状态字符串只在查询时格式化(此处分配不计入 update)
+    std::string status = anim.getBindingStatus(anim.getBindingCount() - 1);
+#ifdef TEST_COUNTS_MALLOC
+    if (!counterWorks()) {
+        std::printf("alloc: operator new is not counted (link libstdc++ statically)\n");
+        return 1;
+    }
+    bool ok = allocs == 0 && !status.empty();
+    std::printf("alloc: Animator with %zu binders x %d frames: %ld mallocs during update (last status %s) %s\n",
+        anim.getBindingCount(), frames, allocs, status.c_str(), ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+#else
+    (void)allocs;
+    std::printf("alloc: malloc counting unavailable in this build (use a Debug build or -Wl,--wrap=malloc)\n");
+    return status.empty() ? 1 : 0;
+#endif
+}
+
+int main(int argc, char** argv) {
+    installCounter();
+    int tracks = argc > 1 ? std::atoi(argv[1]) : 100000;
+    int frames = argc > 2 ? std::atoi(argv[2]) : 2000;
+    int rc = runCheck();
+    rc |= runBenchmark(tracks, frames);
+    rc |= runAllocCheck();
+    return rc;
+}
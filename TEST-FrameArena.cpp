@@ -0,0 +1,161 @@
+﻿/****************************************************************************
+ * 标题: TEST-FrameArena - 无窗口 buildFrame 的每帧堆分配次数
+ * 文件: TEST-FrameArena.cpp
+ * 功能: 构建一个 PlayList(默认 2000 首，标题/艺术家超出短字符串优化长度)挂到未 init 的
+ *       UIManager 上，每帧改变悬停/选中/滚动后调用 buildFrame 并释放快照，计数 malloc。
+ *       分别在 FrameArena::enabled = false(临时字符串直接走 new/delete)与 true 下统计
+ *       每帧堆分配次数与 FrameArena 统计；预热后竞技场不得再溢出到堆，
+ *       且开启后的每帧分配次数须低于关闭时(差值即渲染路径临时分配)。
+ *       其余分配来自 ThorVG 生成 Scene/Shape/Text 等 Paint 本身。
+ * 用法: TEST-FrameArena [帧数=600] [歌曲数=2000]
+ *       VS2022: Debug 构建经 _CrtSetAllocHook 计数(ThorVG 须静态链接才计入其分配)；
+ *       Linux:  g++ -O2 -static-libstdc++ -Wl,--wrap=malloc -Wl,--wrap=aligned_alloc
+ *               (pmr 的 new_delete_resource 按对齐分配，经 aligned_alloc 而非 malloc)
+ *       无法计数 malloc 的构建只打印 FrameArena 统计
+ * 依赖: C++17, mui.h (ThorVG)
+ * 环境: Windows11 x64, VS2022，控制台程序
+ * 编码: UTF-8 (BOM)
+ ****************************************************************************/
+
+#define NOMINMAX
+#include <windows.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER) && defined(_DEBUG)
+#include <crtdbg.h>
+#endif
+
+#include "mui.h"
+
+static std::atomic<long> g_mallocs{ 0 };
+
+#if defined(_MSC_VER) && defined(_DEBUG)
+#define TEST_COUNTS_MALLOC 1
+static int allocHook(int type, void*, size_t, int, long, const unsigned char*, int) {
+    if (type == _HOOK_ALLOC || type == _HOOK_REALLOC) g_mallocs.fetch_add(1, std::memory_order_relaxed);
+    return TRUE;
+}
+static void installCounter() { _CrtSetAllocHook(allocHook); }
+#elif defined(__GLIBC__)
+#define TEST_COUNTS_MALLOC 1
+extern "C" void* __real_malloc(size_t);
+extern "C" void* __wrap_malloc(size_t n) {
+    g_mallocs.fetch_add(1, std::memory_order_relaxed);
+    return __real_malloc(n);
+}
+extern "C" void* __real_aligned_alloc(size_t, size_t);
+extern "C" void* __wrap_aligned_alloc(size_t align, size_t n) {
+    g_mallocs.fetch_add(1, std::memory_order_relaxed);
+    return __real_aligned_alloc(align, n);
+}
+static void installCounter() {}
+#else
+static void installCounter() {}
+#endif
+
+static int g_failures = 0;
+
+static void check(bool ok, const char* what) {
+    if (!ok) {
+        ++g_failures;
+        std::printf("  FAIL: %s\n", what);
+    }
+}
+
+struct Result {
+    double mallocsPerFrame = 0.0;
+    double arenaAllocsPerFrame = 0.0;
+    double arenaBytesPerFrame = 0.0;
+    uint32_t upstreamBlocks = 0;    // 稳态阶段竞技场溢出到堆的块数
+    double buildMs = 0.0;
+};
+
+static std::vector<MUI::Song> makeSongs(int count) {
+    std::vector<MUI::Song> songs(count);
+    for (int i = 0; i < count; ++i) {
+        songs[i].title = L"Track " + std::to_wstring(i + 1) + L" 测试歌曲";
+        songs[i].artist = L"Artist " + std::to_wstring(i % 37) + L" 演唱者";
+        songs[i].filePath = L"C:\\Music\\track" + std::to_wstring(i) + L".flac";
+        songs[i].duration = 180.0f + (i % 120);
+    }
+    return songs;
+}
+
+static void step(MUI::UIManager& ui, MUI::PlayList* playlist, int f, int songCount) {
+    const MUI::Rect r = playlist->rect;
+    playlist->setSelectedIndex((f * 7) % songCount);
+    ui.handleMMove(static_cast<int>(r.x + r.w / 2), static_cast<int>(r.y + 30 + (f % 8) * 60));
+    if (f % 20 == 0) ui.handleMWheel(static_cast<int>(r.x + 10), static_cast<int>(r.y + 10), (f / 20) % 2 ? 120 : -120);
+    ui.buildFrame()->unref();
+}
+
+static Result run(bool arena, int frames, int songCount) {
+    MUI::FrameArena::enabled = arena;
+
+    MUI::UIManager ui;      // 不 init: 只构建场景快照
+    auto list = std::make_unique<MUI::PlayList>();
+    MUI::PlayList* playlist = list.get();
+    playlist->setItems(makeSongs(songCount));
+    ui.addElement(std::move(list));
+
+    // 预热: 竞技场按需扩容、ShapeBatch 等容器达到稳态容量
+    for (int f = 0; f < 60; ++f) step(ui, playlist, f, songCount);
+
+    Result res;
+    const long before = g_mallocs.load();
+    for (int f = 0; f < frames; ++f) {
+        step(ui, playlist, 60 + f, songCount);
+        auto stats = ui.getFrameStats();     // 上一完整帧的竞技场统计
+        res.arenaAllocsPerFrame += stats.arenaAllocations;
+        res.arenaBytesPerFrame += static_cast<double>(stats.arenaBytes);
+        res.upstreamBlocks += stats.arenaUpstreamBlocks;
+        res.buildMs += stats.buildMs;
+    }
+    res.mallocsPerFrame = static_cast<double>(g_mallocs.load() - before) / frames;
+    res.arenaAllocsPerFrame /= frames;
+    res.arenaBytesPerFrame /= frames;
+    res.buildMs /= frames;
+    return res;
+}
+
+int main(int argc, char** argv) {
+    installCounter();
+    const int frames = argc > 1 ? std::max(1, std::atoi(argv[1])) : 600;
+    const int songCount = argc > 2 ? std::max(1, std::atoi(argv[2])) : 2000;
+
+    if (tvg::Initializer::init(0) != tvg::Result::Success) {
+        std::printf("ThorVG 初始化失败\n");
+        return 1;
+    }
+
+    std::printf("PlayList: %d 首, %d 帧\n", songCount, frames);
+    Result heap = run(false, frames, songCount);
+    Result arena = run(true, frames, songCount);
+    MUI::FrameArena::enabled = true;
+
+    std::printf("  %-10s %12s %14s %14s %12s\n", "模式", "malloc/帧", "竞技场分配/帧", "竞技场字节/帧", "build ms/帧");
+    std::printf("  %-10s %12.1f %14.1f %14.0f %12.3f\n", "new/delete",
+        heap.mallocsPerFrame, heap.arenaAllocsPerFrame, heap.arenaBytesPerFrame, heap.buildMs);
+    std::printf("  %-10s %12.1f %14.1f %14.0f %12.3f\n", "FrameArena",
+        arena.mallocsPerFrame, arena.arenaAllocsPerFrame, arena.arenaBytesPerFrame, arena.buildMs);
+    std::printf("  稳态竞技场溢出块数: %u\n", arena.upstreamBlocks);
+
+    check(arena.arenaAllocsPerFrame > 0.0, "渲染路径没有经过 FrameArena");
+    check(arena.upstreamBlocks == 0, "预热后 FrameArena 仍溢出到堆");
+#ifdef TEST_COUNTS_MALLOC
+    check(arena.mallocsPerFrame < heap.mallocsPerFrame, "开启 FrameArena 后每帧堆分配没有减少");
+#else
+    std::printf("malloc counting unavailable in this build (use a Debug build or -Wl,--wrap=malloc)\n");
+#endif
+
+    tvg::Initializer::term();
+
+    std::printf(g_failures ? "FAILED (%d)\n" : "all passed\n", g_failures);
+    return g_failures ? 1 : 0;
+}
@@ -0,0 +1,211 @@
+﻿/****************************************************************************
+ * 标题: TEST-Gapless - MPlayer 无缝播放的离线验证
+ * 文件: TEST-Gapless.cpp
+ * 功能: 以 MPlayer::init(true)(noDevice，48kHz 立体声)驱动真实的 MUI::MPlayer，
+ *       按实时节奏经 readFrames 拉取混音输出，每块之后调用 updateAudioPosition，与界面定时器相同。
+ *       两首测试曲目(32 位浮点 WAV，运行时写到当前目录)的样本值是一条连续的锯齿斜坡，逐帧核对输出:
+ *       1) 播放从 playSongByIndex 之后 20ms(startCurrentAt)处开始；
+ *       2) 曲目交界处没有静音帧、没有重叠(零采样间隙)，onTrackChanged 报告第二首；
+ *       3) 排定开始前与曲目播放期间 isPlaybackFinished 不误报结束，播完后报告结束；
+ *       4) seekAudio 之后等待开始的 20ms 内不误报结束，恢复发声不早于排定时刻且从目标帧继续斜坡，
+ *          并打印从 seekAudio 到恢复发声的帧数。
+ * 用法: TEST-Gapless [每次拉取帧数=480]
+ *       全部通过返回 0，否则打印首个不一致处并返回 1
+ * 依赖: C++17, mui.h (miniaudio 0.11.x 静态库)
+ * 环境: Windows11 x64, VS2022，控制台程序，无需音频设备
+ * 编码: UTF-8 (BOM)
+ ****************************************************************************/
+
+#define NOMINMAX
+#include <windows.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "mui.h"
+
+static const ma_uint32 kRate = 48000;       // 与 MPlayer::init(true) 的引擎格式相同
+static const ma_uint32 kChannels = 2;
+static const ma_uint64 kStartGap = kRate / 50;      // startCurrentAt 的 20ms 余量
+
+// 斜坡上第 n 帧的样本值，永不为 0，便于识别静音间隙
+static float rampAt(ma_uint64 n) {
+    return (float)((n % 997) + 1) / 1024.0f;
+}
+
+static int g_failures = 0;
+
+static void check(bool ok, const char* what) {
+    if (!ok) {
+        std::printf("FAIL: %s\n", what);
+        ++g_failures;
+    }
+}
+
+static void put16(std::FILE* f, uint16_t v) { std::fwrite(&v, 2, 1, f); }
+static void put32(std::FILE* f, uint32_t v) { std::fwrite(&v, 4, 1, f); }
+
+// 写出 32 位浮点 WAV，firstFrame: 本曲目第 0 帧在整条斜坡上的位置
+static bool writeRampWav(const char* path, ma_uint64 firstFrame, ma_uint64 frames) {
+    std::FILE* f = std::fopen(path, "wb");
+    if (!f) return false;
+    const uint32_t dataBytes = (uint32_t)(frames * kChannels * sizeof(float));
+    std::fwrite("RIFF", 1, 4, f);
+    put32(f, 36 + dataBytes);
+    std::fwrite("WAVEfmt ", 1, 8, f);
+    put32(f, 16);
+    put16(f, 3);                                    // WAVE_FORMAT_IEEE_FLOAT
+    put16(f, kChannels);
+    put32(f, kRate);
+    put32(f, kRate * kChannels * sizeof(float));
+    put16(f, kChannels * sizeof(float));
+    put16(f, 32);
+    std::fwrite("data", 1, 4, f);
+    put32(f, dataBytes);
+    std::vector<float> pcm((size_t)frames * kChannels);
+    for (ma_uint64 i = 0; i < frames; ++i) {
+        for (ma_uint32 c = 0; c < kChannels; ++c) pcm[(size_t)i * kChannels + c] = rampAt(firstFrame + i);
+    }
+    bool ok = std::fwrite(pcm.data(), sizeof(float), pcm.size(), f) == pcm.size();
+    return std::fclose(f) == 0 && ok;
+}
+
+// 拉取一块输出后更新播放位置；按块时长休眠，给流式解码与异步打开留出时间
+static ma_uint64 pull(MUI::MPlayer& player, std::vector<float>& out, ma_uint32 chunk) {
+    ma_uint64 read = player.readFrames(out.data(), chunk);
+    player.updateAudioPosition();
+    std::this_thread::sleep_for(std::chrono::microseconds(1000000ull * chunk / kRate));
+    return read;
+}
+
+static bool sampleMatches(const std::vector<float>& out, ma_uint64 i, float expect) {
+    for (ma_uint32 c = 0; c < kChannels; ++c) {
+        if (std::fabs(out[(size_t)i * kChannels + c] - expect) > 1e-6f) return false;
+    }
+    return true;
+}
+
+// 曲目 A 播完后无缝衔接曲目 B，交界处逐帧核对
+static void testBoundary(MUI::MPlayer& player, ma_uint32 chunk, ma_uint64 lenA, ma_uint64 lenB) {
+    int32_t changedTo = -1;
+    player.onTrackChanged = [&changedTo](int32_t index) { changedTo = index; };
+
+    ma_uint64 now = 0;
+    std::vector<float> out((size_t)chunk * kChannels);
+    now += player.readFrames(out.data(), chunk);    // 引擎时刻不从 0 开始，排除巧合
+    player.playSongByIndex(0);
+    const ma_uint64 originA = now + kStartGap;
+    const ma_uint64 endA = originA + lenA;
+    const ma_uint64 endB = endA + lenB;
+    check(!player.isPlaybackFinished(), "finished reported before the scheduled start");
+
+    ma_uint64 firstBad = 0;
+    bool bad = false, finishedEarly = false, finished = false;
+    while (now < endB + kRate) {                    // 最多多拉 1 秒
+        finished = player.isPlaybackFinished();
+        if (finished) {
+            finishedEarly = now < endB;
+            break;
+        }
+        ma_uint64 read = pull(player, out, chunk);
+        for (ma_uint64 i = 0; i < read && !bad; ++i) {
+            ma_uint64 t = now + i;
+            float expect = (t >= originA && t < endB) ? rampAt(t - originA) : 0.0f;
+            if (!sampleMatches(out, i, expect)) {
+                bad = true;
+                firstBad = t;
+            }
+        }
+        now += read;
+    }
+
+    if (bad) {
+        std::printf("first mismatch at engine frame %llu (track A starts %llu, B starts %llu)\n",
+            (unsigned long long)firstBad, (unsigned long long)originA, (unsigned long long)endA);
+    }
+    check(!bad, "output differs from the continuous ramp (late start, gap or overlap at the boundary)");
+    check(changedTo == 1, "onTrackChanged did not report the second track");
+    check(player.getCurrentSongIndex() == 1, "player did not advance to the second track");
+    check(!finishedEarly, "finished reported while a track was still playing");
+    check(finished, "finished never reported after the last track");
+    std::printf("boundary: A %llu + B %llu frames, chunk %u: %s\n",
+        (unsigned long long)lenA, (unsigned long long)lenB, chunk, bad ? "FAILED" : "no gap");
+    player.onTrackChanged = nullptr;
+}
+
+// 跳转: 停止、定位并重新排定开始，等待开始期间不得判定为结束，之后从目标帧继续
+static void testSeek(MUI::MPlayer& player, ma_uint32 chunk) {
+    std::vector<float> out((size_t)chunk * kChannels);
+    player.setGapless(false);       // 只看当前曲目
+    player.playSongByIndex(0);
+    for (int i = 0; i < (int)(kRate / 4 / chunk) + 1; ++i) pull(player, out, chunk);
+
+    const float target = 1.0f;
+    player.seekAudio(target);
+    ma_uint64 now = 0;
+    ma_uint64 origin = ~(ma_uint64)0;   // 跳转后第一个非零帧(相对 seek 之后的拉取)
+    bool finishedEarly = false, bad = false;
+    while (now < kStartGap + kRate / 4) {
+        if (player.isPlaybackFinished()) finishedEarly = true;
+        ma_uint64 read = pull(player, out, chunk);
+        for (ma_uint64 i = 0; i < read && !bad; ++i) {
+            ma_uint64 t = now + i;
+            if (origin == ~(ma_uint64)0) {
+                if (out[(size_t)i * kChannels] == 0.0f) continue;
+                origin = t;
+            }
+            if (!sampleMatches(out, i, rampAt((ma_uint64)(target * kRate) + (t - origin)))) bad = true;
+        }
+        now += read;
+    }
+    check(!finishedEarly, "finished reported while a seek was waiting for its start frame");
+    // 流式解码的跳转在后台完成，数据未就绪时引擎输出静音，因此只要求不早于排定时刻
+    check(origin != ~(ma_uint64)0 && origin >= kStartGap, "seek resumed before its start frame or never resumed");
+    check(!bad, "output after the seek does not continue from the target frame");
+    std::printf("seek: resumed after %lld frames: %s\n",
+        origin == ~(ma_uint64)0 ? -1LL : (long long)origin, finishedEarly || bad ? "FAILED" : "ok");
+    player.setGapless(true);
+}
+
+int main(int argc, char** argv) {
+    ma_uint32 chunk = argc > 1 ? (ma_uint32)std::atoi(argv[1]) : 480;
+    if (chunk == 0) chunk = 480;
+
+    const ma_uint64 lenA = kRate * 3 + 123;         // 不与拉取块对齐，且长于预加载窗口
+    const ma_uint64 lenB = kRate / 2 + 77;
+    if (!writeRampWav("gapless_a.wav", 0, lenA) || !writeRampWav("gapless_b.wav", lenA, lenB)) {
+        std::printf("cannot write test tracks\n");
+        return 1;
+    }
+
+    {
+        MUI::MPlayer player;
+        if (!player.init(true)) {
+            std::printf("MPlayer::init(noDevice) failed\n");
+            return 1;
+        }
+        std::vector<MUI::Song> songs(2);
+        songs[0].title = L"A";
+        songs[0].filePath = L"gapless_a.wav";
+        songs[0].duration = (float)lenA / kRate;
+        songs[1].title = L"B";
+        songs[1].filePath = L"gapless_b.wav";
+        songs[1].duration = (float)lenB / kRate;
+        player.setSongLibrary(songs);
+        player.setVolumeNormalization(false);       // 样本须原样输出
+        player.setVolume(100.0f);
+        player.setPreloadSeconds(1.0f);
+
+        testBoundary(player, chunk, lenA, lenB);
+        testSeek(player, chunk);
+    }
+
+    std::remove("gapless_a.wav");
+    std::remove("gapless_b.wav");
+    std::printf("%s\n", g_failures ? "FAILED" : "all passed");
+    return g_failures ? 1 : 0;
+}
@@ -0,0 +1,166 @@
+﻿/****************************************************************************
+ * 标题: TEST-LyricRender - LyricView 行缓存前后的逐帧耗时
+ * 文件: TEST-LyricRender.cpp
+ * 功能: 无窗口生成一份长 LRC(默认 5000 行，中英混排)，LyricView 按 MUI05 的尺寸与字号
+ *       逐帧 update + render 到新场景，再在软件画布(SwCanvas)上 update/draw/sync。
+ *       播放时间每帧前进 0.25 秒，保证滚动、卡拉OK擦除与换行都被覆盖。
+ *       分别在关闭/开启行缓存(setLineCacheEnabled)下统计 render 与光栅化的每帧耗时，
+ *       行缓存的合计耗时须比逐帧排版低一个数量级。
+ * 用法: TEST-LyricRender [帧数=1200] [行数=5000] [字体文件=siyuan.ttf]
+ *       缺少字体时文本不出字形，耗时对比没有意义，直接返回 1
+ * 依赖: C++17, mui.h (ThorVG 需启用软件渲染引擎与 TTF 加载器)
+ * 环境: Windows11 x64, VS2022 (Release)，控制台程序
+ * 编码: UTF-8 (BOM)
+ ****************************************************************************/
+
+#define NOMINMAX
+#include <windows.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mui.h"
+
+static int g_failures = 0;
+
+static void check(bool ok, const char* what) {
+    if (!ok) {
+        ++g_failures;
+        std::printf("  FAIL: %s\n", what);
+    }
+}
+
+struct Result {
+    double renderMs = 0.0;
+    double drawMs = 0.0;
+};
+
+static mlrc::Document makeLyrics(int lines) {
+    static const char* words[] = {
+        u8"夜空", u8"星光", u8"远方", u8"回忆", u8"城市", u8"微风", u8"海岸", u8"梦里",
+        "love", "night", "forever", "again", "light", "home", "rain", "dream"
+    };
+    mlrc::Document doc;
+    std::string text;
+    for (int i = 0; i < lines; ++i) {
+        text.clear();
+        int n = 4 + (i * 7) % 6;
+        for (int k = 0; k < n; ++k) {
+            if (k) text += ' ';
+            text += words[(i * 13 + k * 5) % 16];
+        }
+        if (i % 9 == 0) text = u8"副歌 让我们一起唱 la la la";    // 重复行
+        doc.addLine(i * 2.5f, text);
+    }
+    return doc;
+}
+
+static Result run(bool cached, int frames, int lines) {
+    MUI::LyricView view;
+    view.rect = MUI::Rect(400, 80, 300, 400);       // 与 MUI05 相同
+    view.setFontName("siyuan.ttf");
+    view.setStyle(24.0f, MUI::Color(255, 255, 255, 255), MUI::Color(180, 180, 180, 200));
+    view.setLyrics(makeLyrics(lines));
+    view.setLineCacheEnabled(cached);
+
+    float songTime = 0.0f;
+    view.setTimeProvider([&songTime] { return songTime; });
+
+    const uint32_t w = 720, h = 500;
+    std::vector<uint32_t> buffer(static_cast<size_t>(w) * h);
+    std::unique_ptr<tvg::SwCanvas> canvas(tvg::SwCanvas::gen());
+    Result res;
+    if (!canvas || canvas->target(buffer.data(), w, w, h, tvg::ColorSpace::ABGR8888S) != tvg::Result::Success) {
+        check(false, "SwCanvas 创建失败(ThorVG 未启用软件渲染引擎?)");
+        return res;
+    }
+
+    tvg::Scene* shown = nullptr;
+    for (int f = 0; f < frames; ++f) {
+        songTime += 0.25f;
+        view.update(1.0f / 60.0f);
+
+        auto t0 = std::chrono::steady_clock::now();
+        tvg::Scene* frame = tvg::Scene::gen();
+        view.render(frame);
+        auto t1 = std::chrono::steady_clock::now();
+        {
+            std::lock_guard<std::mutex> lock(MUI::textEngineMutex());
+            frame->ref();
+            if (shown) {
+                canvas->remove(shown);
+                shown->unref();
+            }
+            shown = frame;
+            canvas->push(shown);
+            canvas->update();
+        }
+        canvas->draw(true);
+        canvas->sync();
+        auto t2 = std::chrono::steady_clock::now();
+
+        res.renderMs += std::chrono::duration<double, std::milli>(t1 - t0).count();
+        res.drawMs += std::chrono::duration<double, std::milli>(t2 - t1).count();
+    }
+
+    {
+        // 先放掉场景，缓存的 Picture 才会脱离父节点，随 view 析构释放
+        std::lock_guard<std::mutex> lock(MUI::textEngineMutex());
+        canvas.reset();
+        if (shown) shown->unref();
+    }
+
+    res.renderMs /= frames;
+    res.drawMs /= frames;
+    return res;
+}
+
+int main(int argc, char** argv) {
+    const int frames = argc > 1 ? std::max(1, std::atoi(argv[1])) : 1200;
+    const int lines = argc > 2 ? std::max(1, std::atoi(argv[2])) : 5000;
+    const char* fontFile = argc > 3 ? argv[3] : "siyuan.ttf";
+
+    if (tvg::Initializer::init(0) != tvg::Result::Success) {
+        std::printf("ThorVG 初始化失败\n");
+        return 1;
+    }
+
+    std::vector<char> font;
+    {
+        std::ifstream in(fontFile, std::ios::binary);
+        font.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    if (font.empty()) {
+        std::printf("未找到字体 %s\n", fontFile);
+        tvg::Initializer::term();
+        return 1;
+    }
+    {
+        std::lock_guard<std::mutex> lock(MUI::textEngineMutex());
+        tvg::Text::load("siyuan.ttf", font.data(), static_cast<uint32_t>(font.size()), "ttf", true);
+    }
+
+    std::printf("LRC: %d 行, %d 帧\n", lines, frames);
+    Result plain = run(false, frames, lines);
+    Result cached = run(true, frames, lines);
+
+    const double plainMs = plain.renderMs + plain.drawMs;
+    const double cachedMs = cached.renderMs + cached.drawMs;
+    std::printf("  %-8s %14s %12s %12s\n", "模式", "render ms/帧", "draw ms/帧", "合计 ms/帧");
+    std::printf("  %-8s %14.3f %12.3f %12.3f\n", "逐帧排版", plain.renderMs, plain.drawMs, plainMs);
+    std::printf("  %-8s %14.3f %12.3f %12.3f\n", "行缓存", cached.renderMs, cached.drawMs, cachedMs);
+    std::printf("  加速比: %.1fx\n", cachedMs > 0.0 ? plainMs / cachedMs : 0.0);
+
+    check(cachedMs * 10.0 <= plainMs, "行缓存的每帧耗时没有降低一个数量级");
+
+    tvg::Initializer::term();
+
+    std::printf(g_failures ? "FAILED (%d)\n" : "all passed\n", g_failures);
+    return g_failures ? 1 : 0;
+}
@@ -0,0 +1,199 @@
+﻿/****************************************************************************
+ * 标题: TEST-MediaPool - MediaPool 稳态零堆分配核对
+ * 文件: TEST-MediaPool.cpp
+ * 功能: 计数进程内的 malloc 调用，按解码线程/渲染线程的方式借出与归还:
+ *       解码线程每帧借一个 1080p ARGB 视频帧和一个大小不一的音频包，经深度 4 的队列
+ *       交给消费线程，消费线程用 freeVideoFrameChain/freeAudioPacketChain 归还。
+ *       预热时按最大在途数量(队列深度 + 两端各持有一个)同时借出每种尺寸再归还。
+ *       1) 预热之后的稳态阶段 malloc 次数必须为 0；
+ *       2) 分辨率切换后 trim，新尺寸预热后同样为 0；
+ *       3) close 时仍有帧未归还，归还后池自行销毁。
+ * 用法: TEST-MediaPool [帧数=3000]
+ *       VS2022: Debug 构建(经 _CrtSetAllocHook 计数)；
+ *       Linux:  g++ -O2 -pthread -static-libstdc++ -Wl,--wrap=malloc (经 __wrap_malloc 计数；
+ *               libstdc++ 动态链接时其中的 operator new 不经过 __wrap_malloc)
+ *       稳态出现堆分配时返回 1；无法计数的构建只打印结果
+ * 依赖: C++17, MDecoder11seek.h (libogg/libvorbis/libtheora 头文件)
+ * 环境: Windows11 x64, VS2022 / Linux g++，控制台程序
+ * 编码: UTF-8 (BOM)
+ ****************************************************************************/
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <windows.h>
+#include <ogg/ogg.h>
+#include <vorbis/codec.h>
+#include <theora/theoradec.h>
+
+#if defined(_MSC_VER) && defined(_DEBUG)
+#include <crtdbg.h>
+#endif
+
+#include "MDecoder11seek.h"
+
+static std::atomic<long> g_mallocs{ 0 };
+
+#if defined(_MSC_VER) && defined(_DEBUG)
+#define TEST_COUNTS_MALLOC 1
+static int allocHook(int type, void*, size_t, int, long, const unsigned char*, int) {
+    if (type == _HOOK_ALLOC || type == _HOOK_REALLOC) g_mallocs.fetch_add(1, std::memory_order_relaxed);
+    return TRUE;
+}
+static void installCounter() { _CrtSetAllocHook(allocHook); }
+#elif defined(__GLIBC__)
+#define TEST_COUNTS_MALLOC 1
+extern "C" void* __real_malloc(size_t);
+extern "C" void* __wrap_malloc(size_t n) {
+    g_mallocs.fetch_add(1, std::memory_order_relaxed);
+    return __real_malloc(n);
+}
+static void installCounter() {}
+#else
+static void installCounter() {}
+#endif
+
+static int g_failures = 0;
+
+static void check(bool ok, const char* what) {
+    if (!ok) {
+        std::printf("FAIL: %s\n", what);
+        ++g_failures;
+    }
+}
+
+// 固定容量的帧队列，队列本身不做堆分配
+struct Handoff {
+    static const int Depth = 4;
+    std::mutex mtx;
+    std::condition_variable cv;
+    VideoFrame* video[Depth] = {};
+    AudioPacket* audio[Depth] = {};
+    int head = 0, count = 0;
+    bool done = false;
+
+    void push(VideoFrame* vf, AudioPacket* ap) {
+        std::unique_lock<std::mutex> lock(mtx);
+        cv.wait(lock, [&] { return count < Depth; });
+        int slot = (head + count) % Depth;
+        video[slot] = vf;
+        audio[slot] = ap;
+        ++count;
+        cv.notify_all();
+    }
+    bool pop(VideoFrame*& vf, AudioPacket*& ap) {
+        std::unique_lock<std::mutex> lock(mtx);
+        cv.wait(lock, [&] { return count > 0 || done; });
+        if (count == 0) return false;
+        vf = video[head];
+        ap = audio[head];
+        head = (head + 1) % Depth;
+        --count;
+        cv.notify_all();
+        return true;
+    }
+    void finish() {
+        std::lock_guard<std::mutex> lock(mtx);
+        done = true;
+        cv.notify_all();
+    }
+};
+
+static std::uint32_t audioFloats(int f) {
+    return (f % 3 ? 2048u : 256u) * 2 + (std::uint32_t)(f % 7);     // 每包样本数不固定
+}
+
+// 同时在途的帧最多为队列深度加上生产者、消费者各持有的一个
+static const int kInFlight = Handoff::Depth + 2;
+
+static void warmUp(MediaPool* pool, std::uint32_t width, std::uint32_t height) {
+    VideoFrame* video[kInFlight];
+    AudioPacket* audio[kInFlight];
+    for (int i = 0; i < kInFlight; ++i) video[i] = pool->acquireVideo(width * height * 4);
+    for (int i = 0; i < kInFlight; ++i) freeVideoFrameChain(video[i]);
+    for (int f = 0; f < 21; ++f) {                  // audioFloats 的全部取值
+        for (int i = 0; i < kInFlight; ++i) audio[i] = pool->acquireAudio(audioFloats(f));
+        for (int i = 0; i < kInFlight; ++i) freeAudioPacketChain(audio[i]);
+    }
+}
+
+// 预热后借出 frames 帧，返回期间的 malloc 次数
+static long stream(MediaPool* pool, std::uint32_t width, std::uint32_t height, int frames, double& ms) {
+    Handoff q;
+    std::thread consumer([&] {
+        VideoFrame* vf;
+        AudioPacket* ap;
+        while (q.pop(vf, ap)) {
+            freeVideoFrameChain(vf);
+            freeAudioPacketChain(ap);
+        }
+    });
+
+    warmUp(pool, width, height);
+    const long before = g_mallocs.load();
+    auto t0 = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; ++f) {
+        VideoFrame* vf = pool->acquireVideo(width * height * 4);
+        AudioPacket* ap = pool->acquireAudio(audioFloats(f));
+        if (!vf || !ap) {
+            check(false, "acquire returned null");
+            break;
+        }
+        vf->width = width;
+        vf->height = height;
+        vf->stride = width * 4;
+        vf->format = VideoFormat::ARGB32;
+        std::memset(vf->pixels, f & 0xFF, vf->dataBytes);
+        ap->frames = (std::int32_t)(ap->dataFloats / 2);
+        q.push(vf, ap);
+    }
+    long steady = g_mallocs.load() - before;
+    ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    q.finish();
+    consumer.join();
+    return steady;
+}
+
+int main(int argc, char** argv) {
+    const int frames = argc > 1 ? std::atoi(argv[1]) : 3000;
+    if (frames < 1) return 1;
+    installCounter();
+
+    MediaPool* pool = new MediaPool();
+    double ms = 0.0;
+    long steady = stream(pool, 1920, 1080, frames, ms);
+    MediaPool::Stats s = pool->getStats();
+    std::printf("1080p: %d frames in %.1f ms, steady-state mallocs %ld (pool: %llu allocs, %llu reused, %llu dropped)\n",
+        frames, ms, steady, (unsigned long long)s.heapAllocs, (unsigned long long)s.reused, (unsigned long long)s.dropped);
+#ifdef TEST_COUNTS_MALLOC
+    check(steady == 0, "heap allocations in steady state at 1080p");
+#endif
+
+    // 分辨率切换: 旧尺寸的空闲帧释放后，新尺寸重新进入稳态
+    pool->trim();
+    steady = stream(pool, 1280, 720, frames, ms);
+    std::printf("720p after trim: %d frames in %.1f ms, steady-state mallocs %ld\n", frames, ms, steady);
+#ifdef TEST_COUNTS_MALLOC
+    check(steady == 0, "heap allocations in steady state after a resolution change");
+#else
+    std::printf("malloc counting unavailable in this build (use a Debug build or -Wl,--wrap=malloc)\n");
+#endif
+
+    // 所有者先关闭，未归还的帧之后仍可安全归还
+    VideoFrame* held = pool->acquireVideo(4096);
+    pool->close();
+    freeVideoFrameChain(held);
+
+    std::printf("%s\n", g_failures ? "FAILED" : "all passed");
+    return g_failures ? 1 : 0;
+}
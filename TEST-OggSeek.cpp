@@ -0,0 +1,320 @@
+﻿/****************************************************************************
+ * 标题: TEST-OggSeek - MDecoder11seek.h 定位正确性与延迟基准(真实 Theora/Vorbis 码流)
+ * 文件: TEST-OggSeek.cpp
+ * 功能: 1) 生成测试文件: libtheora 编码 320x240@30fps(关键帧间隔 64)，每帧画面以 16 个
+ *          明暗方块写入帧号；libvorbis 编码 48kHz 立体声；两路按时间交错成 .ogv；
+ *       2) 定位核对: 开头(0、不足一帧、首个关键帧前后)、结尾附近与随机位置，
+ *          seek 后首帧的帧号(从画面读回)与 playms、首个音频包的 playms 必须与目标一致；
+ *       3) 延迟基准: 从 requestSeek 到音视频队列都有新代次数据的耗时(中位数/p95/最大)，
+ *          先删除 .mdx 以二分定位测一轮，再建立索引后以索引定位测一轮。
+ * 用法: TEST-OggSeek [文件=oggseek_test.ogv] [秒数=600] [随机跳转次数=200]
+ *       文件不存在时先生成；任何一次定位结果不符返回 1
+ * 依赖: C++17, MDecoder11seek.h, libogg, libtheora(含编码器), libvorbis(含 vorbisenc)
+ * 环境: Windows11 x64, VS2022 (Release)，控制台程序
+ * 编码: UTF-8 (BOM)
+ ****************************************************************************/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <windows.h>
+#include <ogg/ogg.h>
+#include <vorbis/codec.h>
+#include <vorbis/vorbisenc.h>
+#include <theora/theoraenc.h>
+#include <theora/theoradec.h>
+
+#pragma comment(lib, "libogg.lib")
+#pragma comment(lib, "libtheora.lib")
+#pragma comment(lib, "libvorbis.lib")
+#pragma comment(lib, "winmm.lib")
+
+#include "MDecoder11seek.h"
+
+using Clock = std::chrono::steady_clock;
+
+static const int kWidth = 320, kHeight = 240, kFps = 30, kRate = 48000;
+static const int kKeyframeInterval = 64;
+static const int kBits = 16;                // 帧号位数: 8 x 2 个方块
+static const int kBlockW = kWidth / 8, kBlockH = kHeight / 2;
+
+//---------------------------------------------------------------------------
+// 生成
+//---------------------------------------------------------------------------
+
+// 已编码的页：按时间交错写出
+struct PendingPage {
+    std::vector<unsigned char> bytes;
+    double time;
+};
+
+template <class TimeOf>
+static void takePages(ogg_stream_state& os, std::vector<PendingPage>& out, double& lastTime, TimeOf timeOf, bool flush) {
+    ogg_page og;
+    while (flush ? ogg_stream_flush(&os, &og) : ogg_stream_pageout(&os, &og)) {
+        const ogg_int64_t gp = ogg_page_granulepos(&og);
+        if (gp >= 0) lastTime = timeOf(gp);         // 续页没有 granulepos，沿用前一页时间
+        PendingPage p;
+        p.bytes.assign(og.header, og.header + og.header_len);
+        p.bytes.insert(p.bytes.end(), og.body, og.body + og.body_len);
+        p.time = lastTime;
+        out.push_back(std::move(p));
+    }
+}
+
+// 两路各取队首，时间早的先写；finish 时写完剩余
+static void writeInterleaved(FILE* f, std::vector<PendingPage>& video, std::vector<PendingPage>& audio, bool finish) {
+    size_t v = 0, a = 0;
+    while ((v < video.size() && a < audio.size()) || (finish && (v < video.size() || a < audio.size()))) {
+        const bool takeVideo = a >= audio.size() || (v < video.size() && video[v].time <= audio[a].time);
+        const PendingPage& p = takeVideo ? video[v++] : audio[a++];
+        std::fwrite(p.bytes.data(), 1, p.bytes.size(), f);
+    }
+    video.erase(video.begin(), video.begin() + v);
+    audio.erase(audio.begin(), audio.begin() + a);
+}
+
+static void drawFrame(unsigned char* y, int stride, long frame) {
+    for (int row = 0; row < kHeight; ++row) {
+        for (int col = 0; col < kWidth; ++col) {
+            const int bit = (row / kBlockH) * 8 + col / kBlockW;
+            y[row * stride + col] = ((frame >> bit) & 1) ? 216 : 40;
+        }
+    }
+}
+
+static bool generate(const std::filesystem::path& path, int seconds) {
+    FILE* f = _wfopen(path.wstring().c_str(), L"wb");
+    if (!f) return false;
+
+    th_info ti;
+    th_info_init(&ti);
+    ti.frame_width = ti.pic_width = kWidth;
+    ti.frame_height = ti.pic_height = kHeight;
+    ti.pic_x = ti.pic_y = 0;
+    ti.fps_numerator = kFps;
+    ti.fps_denominator = 1;
+    ti.aspect_numerator = ti.aspect_denominator = 1;
+    ti.colorspace = TH_CS_UNSPECIFIED;
+    ti.pixel_fmt = TH_PF_420;
+    ti.target_bitrate = 0;
+    ti.quality = 40;
+    ti.keyframe_granule_shift = 6;
+    th_enc_ctx* te = th_encode_alloc(&ti);
+    int keyframeInterval = kKeyframeInterval;
+    th_encode_ctl(te, TH_ENCCTL_SET_KEYFRAME_FREQUENCY_FORCE, &keyframeInterval, sizeof(keyframeInterval));
+
+    vorbis_info vi;
+    vorbis_comment vc;
+    vorbis_dsp_state vd;
+    vorbis_block vb;
+    vorbis_info_init(&vi);
+    vorbis_encode_init_vbr(&vi, 2, kRate, 0.3f);
+    vorbis_comment_init(&vc);
+    vorbis_analysis_init(&vd, &vi);
+    vorbis_block_init(&vd, &vb);
+
+    ogg_stream_state to, vo;
+    ogg_stream_init(&to, 0x7468);
+    ogg_stream_init(&vo, 0x766F);
+    ogg_packet op;
+    ogg_page og;
+
+    // 头: 两路的首个头包各占一页(BOS)，其余头包随后整页写出，数据从新页开始
+    th_comment tc;
+    th_comment_init(&tc);
+    th_encode_flushheader(te, &tc, &op);
+    ogg_stream_packetin(&to, &op);
+    ogg_stream_pageout(&to, &og);
+    std::fwrite(og.header, 1, og.header_len, f);
+    std::fwrite(og.body, 1, og.body_len, f);
+    ogg_packet header, headerComment, headerCode;
+    vorbis_analysis_headerout(&vd, &vc, &header, &headerComment, &headerCode);
+    ogg_stream_packetin(&vo, &header);
+    ogg_stream_pageout(&vo, &og);
+    std::fwrite(og.header, 1, og.header_len, f);
+    std::fwrite(og.body, 1, og.body_len, f);
+    while (th_encode_flushheader(te, &tc, &op) > 0) ogg_stream_packetin(&to, &op);
+    ogg_stream_packetin(&vo, &headerComment);
+    ogg_stream_packetin(&vo, &headerCode);
+    for (ogg_stream_state* os : { &to, &vo }) {
+        while (ogg_stream_flush(os, &og)) {
+            std::fwrite(og.header, 1, og.header_len, f);
+            std::fwrite(og.body, 1, og.body_len, f);
+        }
+    }
+
+    std::vector<unsigned char> luma((size_t)kWidth * kHeight), chroma((size_t)kWidth * kHeight / 4, 128);
+    th_ycbcr_buffer ycbcr;
+    ycbcr[0] = { kWidth, kHeight, kWidth, luma.data() };
+    ycbcr[1] = { kWidth / 2, kHeight / 2, kWidth / 2, chroma.data() };
+    ycbcr[2] = ycbcr[1];
+
+    std::vector<PendingPage> videoPages, audioPages;
+    double videoTime = 0.0, audioTime = 0.0;
+    auto videoTimeOf = [&](ogg_int64_t gp) { return th_granule_time(te, gp); };
+    auto audioTimeOf = [&](ogg_int64_t gp) { return vorbis_granule_time(&vd, gp); };
+
+    const long frames = (long)seconds * kFps;
+    const int samplesPerFrame = kRate / kFps;
+    double phase = 0.0;
+    for (long frame = 0; frame < frames; ++frame) {
+        drawFrame(luma.data(), kWidth, frame);
+        th_encode_ycbcr_in(te, ycbcr);
+        while (th_encode_packetout(te, frame == frames - 1, &op) > 0) ogg_stream_packetin(&to, &op);
+
+        float** pcm = vorbis_analysis_buffer(&vd, samplesPerFrame);
+        for (int i = 0; i < samplesPerFrame; ++i) {
+            pcm[0][i] = pcm[1][i] = 0.2f * (float)std::sin(phase);
+            phase += 2.0 * 3.14159265358979 * 440.0 / kRate;
+        }
+        vorbis_analysis_wrote(&vd, samplesPerFrame);
+        if (frame == frames - 1) vorbis_analysis_wrote(&vd, 0);
+        while (vorbis_analysis_blockout(&vd, &vb) == 1) {
+            vorbis_analysis(&vb, nullptr);
+            vorbis_bitrate_addblock(&vb);
+            while (vorbis_bitrate_flushpacket(&vd, &op)) ogg_stream_packetin(&vo, &op);
+        }
+
+        const bool last = frame == frames - 1;
+        takePages(to, videoPages, videoTime, videoTimeOf, last);
+        takePages(vo, audioPages, audioTime, audioTimeOf, last);
+        writeInterleaved(f, videoPages, audioPages, last);
+    }
+
+    ogg_stream_clear(&to);
+    ogg_stream_clear(&vo);
+    th_comment_clear(&tc);
+    th_encode_free(te);
+    th_info_clear(&ti);
+    vorbis_block_clear(&vb);
+    vorbis_dsp_clear(&vd);
+    vorbis_comment_clear(&vc);
+    vorbis_info_clear(&vi);
+    std::fclose(f);
+    return true;
+}
+
+//---------------------------------------------------------------------------
+// 定位核对与基准
+//---------------------------------------------------------------------------
+
+static int g_wrong = 0;
+
+static long frameNumberOf(const VideoFrame* vf) {
+    long n = 0;
+    for (int bit = 0; bit < kBits; ++bit) {
+        const int x = (bit % 8) * kBlockW + kBlockW / 2, y = (bit / 8) * kBlockH + kBlockH / 2;
+        const std::uint8_t g = vf->pixels[(size_t)y * vf->stride + (size_t)x * 4 + 1];
+        if (g > 128) n |= 1L << bit;
+    }
+    return n;
+}
+
+// 返回从请求到音视频都就绪的毫秒数
+static double seekOnce(MDecoder& dec, double t) {
+    auto t0 = Clock::now();
+    dec.requestSeek(t);
+    const VideoFrame* vf = nullptr;
+    const AudioPacket* ap = nullptr;
+    while ((!vf || !ap) && Clock::now() - t0 < std::chrono::seconds(5)) {
+        if (!vf) vf = dec.peekVideo();
+        if (!ap) ap = dec.peekAudio();
+        if (!vf || !ap) std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    const double ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+
+    // 与 MDecoder 相同的取整：目标帧/样本向下取整，视频 playms 为帧的结束时间
+    const long wantFrame = (long)(t * kFps);
+    const std::uint32_t wantVideoMs = (std::uint32_t)std::llround((wantFrame + 1) * 1000.0 / kFps);
+    const std::uint32_t wantAudioMs = (std::uint32_t)((ogg_int64_t)(t * kRate) * 1000 / kRate);
+    const long gotFrame = vf ? frameNumberOf(vf) : -1;
+    const bool ok = vf && ap && gotFrame == wantFrame && vf->playms == wantVideoMs && ap->playms == wantAudioMs;
+    if (!ok && g_wrong++ < 10) {
+        std::printf("seek %.4f s: frame %ld (want %ld), video %u ms (want %u), audio %u ms (want %u)\n", t,
+            gotFrame, wantFrame, vf ? vf->playms : 0u, wantVideoMs, ap ? ap->playms : 0u, wantAudioMs);
+    }
+    while (VideoFrame* x = dec.popVideoFrame()) freeVideoFrameChain(x);
+    while (AudioPacket* x = dec.popAudioPacket()) freeAudioPacketChain(x);
+    return ms;
+}
+
+static void runSeeks(const std::filesystem::path& path, double duration, int count, const char* mode) {
+    MDecoder dec;
+    dec.start(path.wstring());
+    for (auto t0 = Clock::now(); !dec.peekVideo() && Clock::now() - t0 < std::chrono::seconds(5);)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    // 开头: 0、不足一帧、首个关键帧前后；结尾附近
+    const double edges[] = { 0.0, 0.5 / kFps, 1.0 / kFps, (kKeyframeInterval - 1.0) / kFps, (double)kKeyframeInterval / kFps,
+                             (kKeyframeInterval + 1.0) / kFps, duration - 1.0, 0.0 };
+    const int before = g_wrong;
+    for (double t : edges) seekOnce(dec, t);
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> pick(0.0, duration - 1.0);
+    std::vector<double> ms;
+    for (int i = 0; i < count; ++i) ms.push_back(seekOnce(dec, pick(rng)));
+    dec.stop();
+
+    std::sort(ms.begin(), ms.end());
+    std::printf("%-9s %d seeks: median %.2f ms, p95 %.2f ms, max %.2f ms; wrong %d\n", mode, count,
+        ms[ms.size() / 2], ms[ms.size() * 95 / 100], ms.back(), g_wrong - before);
+}
+
+int main(int argc, char** argv) {
+    const std::filesystem::path path = argc > 1 ? argv[1] : "oggseek_test.ogv";
+    const int seconds = argc > 2 ? std::atoi(argv[2]) : 600;
+    const int count = argc > 3 ? std::atoi(argv[3]) : 200;
+    if (seconds < 10 || seconds * kFps >= (1L << kBits) || count < 1) return 1;
+
+    if (!std::filesystem::exists(path)) {
+        auto t0 = Clock::now();
+        if (!generate(path, seconds)) {
+            std::printf("cannot write %ls\n", path.wstring().c_str());
+            return 1;
+        }
+        std::printf("generated %ls: %d s, %.1f MB in %.1f s\n", path.wstring().c_str(), seconds,
+            std::filesystem::file_size(path) / 1048576.0, std::chrono::duration<double>(Clock::now() - t0).count());
+    }
+
+    MDecoder::DurationInfo info;
+    if (!MDecoder::queryDuration(path.wstring(), info) || info.videoDuration < 10.0) {
+        std::printf("cannot read the duration of %ls\n", path.wstring().c_str());
+        return 1;
+    }
+
+    // 二分定位: 删除旧索引，且不在后台建立
+    std::filesystem::path mdx = path;
+    mdx += ".mdx";
+    std::filesystem::remove(mdx);
+    runSeeks(path, info.videoDuration, count, "bisect");
+
+    // 建立索引后以索引定位
+    {
+        MDecoder dec;
+        dec.setSeekIndexEnabled(true);
+        dec.start(path.wstring());
+        for (auto t0 = Clock::now(); !dec.hasSeekIndex() && Clock::now() - t0 < std::chrono::seconds(60);)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        dec.stop();
+    }
+    if (std::filesystem::exists(mdx)) runSeeks(path, info.videoDuration, count, "index");
+    else std::printf("index: not built, skipped\n");
+
+    std::printf("%s\n", g_wrong ? "FAILED" : "all passed");
+    return g_wrong ? 1 : 0;
+}
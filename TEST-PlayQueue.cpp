@@ -0,0 +1,135 @@
+﻿/****************************************************************************
+ * 标题: TEST-PlayQueue - PlayQueue 百万规模正确性核对与基准
+ * 文件: TEST-PlayQueue.cpp
+ * 功能: 1) 100 万首歌曲的随机顺序: 洗牌耗时，order/position 互逆；
+ *       2) 100 万次随机操作(入队/插队/删除/移动/下一首/上一首)，统计每次操作耗时，
+ *          结束后核对"接下来播放"链表与句柄；
+ *       3) 歌曲库变化: 删除 1/3 并追加新歌后 remap，核对映射与相对顺序。
+ * 用法: TEST-PlayQueue [歌曲数=1000000] [操作数=1000000]
+ *       核对失败返回 1
+ * 依赖: C++17, mui.h (仅使用 MUI::PlayQueue)
+ * 环境: Windows11 x64, VS2022 (Release)，控制台程序
+ * 编码: UTF-8 (BOM)
+ ****************************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "mui.h"
+
+using MUI::PlayQueue;
+using Clock = std::chrono::steady_clock;
+
+static int g_failures = 0;
+
+static void check(bool ok, const char* what) {
+    if (!ok && g_failures++ == 0) std::printf("FAIL: %s\n", what);
+}
+
+static double msSince(Clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+static bool orderIsPermutation(const PlayQueue& q) {
+    for (int32_t i = 0; i < q.size(); ++i) {
+        if (q.orderAt(q.positionOf(i)) != i) return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    const int32_t songs = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    const long operations = argc > 2 ? std::atol(argv[2]) : 1000000;
+    if (songs < 2) return 1;
+
+    PlayQueue q;
+    auto t0 = Clock::now();
+    q.reset(songs);
+    q.shuffle(5);
+    double shuffleMs = msSince(t0);
+    check(q.orderAt(0) == 5, "shuffle does not start with the requested song");
+    check(orderIsPermutation(q), "order/position are not inverse after shuffle");
+
+    // 随机操作: 与播放器一致，每次上一首/下一首都经过 peek + advanceTo/retreatTo
+    std::mt19937 rng(1);
+    std::vector<PlayQueue::Handle> handles;
+    int32_t current = 5;
+    q.setAnchor(current);
+    long counts[6] = {};
+    t0 = Clock::now();
+    for (long i = 0; i < operations; ++i) {
+        int op = static_cast<int>(rng() % 6);
+        ++counts[op];
+        switch (op) {
+        case 0: handles.push_back(q.enqueue(static_cast<int32_t>(rng() % songs))); break;
+        case 1: handles.push_back(q.playNext(static_cast<int32_t>(rng() % songs))); break;
+        case 2:
+            if (!handles.empty()) {
+                size_t k = rng() % handles.size();
+                q.remove(handles[k]);
+                handles[k] = handles.back();
+                handles.pop_back();
+            }
+            break;
+        case 3:
+            if (handles.size() > 1) q.moveAfter(handles[rng() % handles.size()], handles[rng() % handles.size()]);
+            break;
+        case 4: {
+            int32_t next = q.peekNext(true);
+            q.advanceTo(current, next);
+            current = next;
+            break;
+        }
+        case 5: {
+            int32_t prev = q.peekPrev(true);
+            if (prev >= 0) {
+                q.retreatTo(prev);
+                current = prev;
+            }
+            break;
+        }
+        }
+    }
+    double opsMs = msSince(t0);
+
+    // "接下来播放"链表与句柄一致，已出队的句柄均已失效
+    size_t listed = 0;
+    q.forEachUpNext([&](PlayQueue::Handle h, int32_t song) {
+        check(q.songOf(h) == song, "up-next handle does not resolve to its song");
+        ++listed;
+    });
+    check(listed == q.upNextSize(), "up-next size differs from the linked list");
+    size_t live = 0;
+    for (const auto& h : handles) live += q.songOf(h) >= 0 ? 1 : 0;
+    check(live == q.upNextSize(), "live handles differ from the up-next size");
+
+    // 删除每第 3 首并追加 1000 首，remap 保留剩余歌曲的相对顺序
+    std::vector<int32_t> before(q.size());
+    for (int32_t p = 0; p < q.size(); ++p) before[p] = q.orderAt(p);
+    std::vector<int32_t> oldToNew(songs);
+    int32_t kept = 0;
+    for (int32_t i = 0; i < songs; ++i) oldToNew[i] = (i % 3 == 0) ? -1 : kept++;
+    t0 = Clock::now();
+    q.remap(oldToNew, kept + 1000);
+    double remapMs = msSince(t0);
+    check(q.size() == kept + 1000, "remap produced the wrong size");
+    check(orderIsPermutation(q), "order/position are not inverse after remap");
+    int32_t lastPos = -1;
+    bool ordered = true;
+    for (int32_t song : before) {
+        if (oldToNew[song] < 0) continue;
+        int32_t pos = q.positionOf(oldToNew[song]);
+        ordered = ordered && pos > lastPos;
+        lastPos = pos;
+    }
+    check(ordered, "remap changed the relative order of remaining songs");
+
+    std::printf("songs %d: shuffle %.1f ms, remap %.1f ms\n", songs, shuffleMs, remapMs);
+    std::printf("%ld ops (enqueue %ld, playNext %ld, remove %ld, move %ld, next %ld, prev %ld): %.1f ms, %.0f ns/op\n",
+        operations, counts[0], counts[1], counts[2], counts[3], counts[4], counts[5], opsMs, opsMs * 1e6 / operations);
+    std::printf("up next %zu, history %zu: %s\n", q.upNextSize(), q.historySize(), g_failures ? "FAILED" : "ok");
+    return g_failures ? 1 : 0;
+}
@@ -0,0 +1,173 @@
+﻿/****************************************************************************
+ * 标题: TEST-ShapeBatch - 播放列表合批前后的 Paint 数与每帧耗时
+ * 文件: TEST-ShapeBatch.cpp
+ * 功能: 无窗口构建一个 PlayList(默认 2000 首)，挂到未 init 的 UIManager 上，
+ *       用 buildFrame 生成场景快照，再在软件画布(SwCanvas)上 update/draw/sync。
+ *       每帧改变悬停项/选中项/滚动位置，分别在 ShapeBatch::enabled = false / true 下
+ *       统计每帧平均 Paint 数、合批图元数、buildFrame 耗时与光栅化耗时。
+ *       并报告两种模式最后一帧不同的像素数(同一路径内相邻图元的抗锯齿边缘可能略有差别)。
+ * 用法: TEST-ShapeBatch [帧数=600] [歌曲数=2000] [字体文件=siyuan.ttf]
+ *       字体文件不存在时文本不出字形，只统计矩形/线段部分；合批后 Paint 数增加时返回 1
+ * 依赖: C++17, mui.h (ThorVG 需启用软件渲染引擎)
+ * 环境: Windows11 x64, VS2022 (Release)，控制台程序
+ * 编码: UTF-8 (BOM)
+ ****************************************************************************/
+
+#define NOMINMAX
+#include <windows.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mui.h"
+
+static int g_failures = 0;
+
+static void check(bool ok, const char* what) {
+    if (!ok) {
+        ++g_failures;
+        std::printf("  FAIL: %s\n", what);
+    }
+}
+
+struct Result {
+    double paints = 0.0;
+    double primitives = 0.0;
+    double shapes = 0.0;
+    double buildMs = 0.0;
+    double drawMs = 0.0;
+    std::vector<uint32_t> lastFrame;
+};
+
+static std::vector<MUI::Song> makeSongs(int count) {
+    std::vector<MUI::Song> songs(count);
+    for (int i = 0; i < count; ++i) {
+        songs[i].title = L"Track " + std::to_wstring(i + 1) + L" 测试歌曲";
+        songs[i].artist = L"Artist " + std::to_wstring(i % 37) + L" 演唱者";
+        songs[i].filePath = L"C:\\Music\\track" + std::to_wstring(i) + L".flac";
+        songs[i].duration = 180.0f + (i % 120);
+    }
+    return songs;
+}
+
+static Result run(bool batching, int frames, int songCount) {
+    MUI::ShapeBatch::enabled = batching;
+
+    MUI::UIManager ui;      // 不 init: 只用 buildFrame 构建场景，光栅化交给下面的软件画布
+    ui.setCountPaints(true);
+    auto list = std::make_unique<MUI::PlayList>();
+    MUI::PlayList* playlist = list.get();
+    playlist->setItems(makeSongs(songCount));
+    ui.addElement(std::move(list));
+
+    const MUI::Rect r = playlist->rect;
+    const uint32_t w = static_cast<uint32_t>(r.x + r.w) + 10;
+    const uint32_t h = static_cast<uint32_t>(r.y + r.h) + 10;
+    std::vector<uint32_t> buffer(static_cast<size_t>(w) * h);
+    std::unique_ptr<tvg::SwCanvas> canvas(tvg::SwCanvas::gen());
+    Result res;
+    if (!canvas || canvas->target(buffer.data(), w, w, h, tvg::ColorSpace::ABGR8888S) != tvg::Result::Success) {
+        check(false, "SwCanvas 创建失败(ThorVG 未启用软件渲染引擎?)");
+        return res;
+    }
+
+    tvg::Scene* shown = nullptr;
+    for (int f = 0; f < frames; ++f) {
+        // 每帧改变状态，让 PlayList 真正重建场景
+        playlist->setSelectedIndex((f * 7) % songCount);
+        ui.handleMMove(static_cast<int>(r.x + r.w / 2), static_cast<int>(r.y + 30 + (f % 8) * 60));
+        if (f % 20 == 0) ui.handleMWheel(static_cast<int>(r.x + 10), static_cast<int>(r.y + 10), (f / 20) % 2 ? 120 : -120);
+
+        tvg::Scene* frame = ui.buildFrame();
+        auto stats = ui.getFrameStats();
+
+        auto t0 = std::chrono::steady_clock::now();
+        {
+            std::lock_guard<std::mutex> lock(MUI::textEngineMutex());
+            frame->ref();
+            if (shown) {
+                canvas->remove(shown);
+                shown->unref();
+            }
+            shown = frame;
+            canvas->push(shown);
+            canvas->update();
+        }
+        canvas->draw(true);
+        canvas->sync();
+        auto t1 = std::chrono::steady_clock::now();
+
+        res.paints += stats.paintCount;
+        res.primitives += stats.batchedPrimitives;
+        res.shapes += stats.batchedShapes;
+        res.buildMs += stats.buildMs;
+        res.drawMs += std::chrono::duration<double, std::milli>(t1 - t0).count();
+    }
+    res.lastFrame = buffer;
+
+    {
+        std::lock_guard<std::mutex> lock(MUI::textEngineMutex());
+        canvas.reset();
+        if (shown) shown->unref();
+    }
+
+    res.paints /= frames;
+    res.primitives /= frames;
+    res.shapes /= frames;
+    res.buildMs /= frames;
+    res.drawMs /= frames;
+    return res;
+}
+
+int main(int argc, char** argv) {
+    const int frames = argc > 1 ? std::max(1, std::atoi(argv[1])) : 600;
+    const int songCount = argc > 2 ? std::max(1, std::atoi(argv[2])) : 2000;
+    const char* fontFile = argc > 3 ? argv[3] : "siyuan.ttf";
+
+    if (tvg::Initializer::init(0) != tvg::Result::Success) {
+        std::printf("ThorVG 初始化失败\n");
+        return 1;
+    }
+
+    std::vector<char> font;
+    {
+        std::ifstream in(fontFile, std::ios::binary);
+        font.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    if (!font.empty()) {
+        std::lock_guard<std::mutex> lock(MUI::textEngineMutex());
+        tvg::Text::load("siyuan.ttf", font.data(), static_cast<uint32_t>(font.size()), "ttf", true);
+    } else {
+        std::printf("未找到字体 %s，文本不出字形\n", fontFile);
+    }
+
+    std::printf("PlayList: %d 首, %d 帧\n", songCount, frames);
+    Result plain = run(false, frames, songCount);
+    Result batched = run(true, frames, songCount);
+
+    std::printf("  %-8s %10s %10s %10s %12s %12s\n", "模式", "Paint/帧", "图元/帧", "Shape/帧", "build ms/帧", "draw ms/帧");
+    std::printf("  %-8s %10.1f %10.1f %10.1f %12.3f %12.3f\n", "逐个",
+        plain.paints, plain.primitives, plain.shapes, plain.buildMs, plain.drawMs);
+    std::printf("  %-8s %10.1f %10.1f %10.1f %12.3f %12.3f\n", "合批",
+        batched.paints, batched.primitives, batched.shapes, batched.buildMs, batched.drawMs);
+
+    check(plain.primitives == batched.primitives, "两种模式的图元数不同");
+    check(batched.paints <= plain.paints, "合批后 Paint 数反而增加");
+
+    size_t diff = 0;
+    for (size_t i = 0; i < plain.lastFrame.size() && i < batched.lastFrame.size(); ++i) {
+        if (plain.lastFrame[i] != batched.lastFrame[i]) ++diff;
+    }
+    std::printf("  最后一帧不同像素: %zu / %zu\n", diff, batched.lastFrame.size());
+
+    tvg::Initializer::term();
+
+    std::printf(g_failures ? "FAILED (%d)\n" : "all passed\n", g_failures);
+    return g_failures ? 1 : 0;
+}
@@ -0,0 +1,462 @@
+﻿/****************************************************************************
+ * 标题: meq.h - 实时参数均衡器(双二阶滤波级联)
+ * 文件: meq.h
+ * 版本: 0.1
+ * 作者: AEGLOVE
+ * 日期: 2026-10-19
+ * 功能: 10 段(倍频程)或 31 段(1/3 倍频程)图示均衡器，RBJ 峰值/搁架滤波器级联，
+ *       转置直接 II 型(DF2T)，SSE2 下按声道 4 路并行；立体声时相邻两个频段错开一帧流水，
+ *       同一寄存器装 [L_b, R_b, L_b+1, R_b+1]，4 路全部用上；增益为 0dB 的频段整段跳过。
+ *       参数由任意线程无锁写入(原子量)，音频线程每 32 帧平滑一次并重算系数，
+ *       前级增益逐帧线性过渡，调节时无拉链噪声。
+ *       供 mui.h 的 MPlayer 作为 ma_node 接入引擎图，也可在 miniaudio 设备回调中
+ *       直接对交错 float PCM 调用 Equalizer::process(MPlayer.cpp / momo2.cpp)。
+ * 依赖: C++17
+ * 环境: Windows11 x64, VS2022, C++17, Unicode字符集
+ * 编码: UTF-8 (BOM)
+ ****************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <cctype>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MEQ_SSE2 1
+#endif
+
+namespace meq {
+
+constexpr int MaxBands = 31;
+constexpr int MaxChannels = 8;
+
+enum class FilterType : uint32_t { Peaking, LowShelf, HighShelf };
+
+// 10 段倍频程中心频率(ISO)
+constexpr float kOctaveCenters[10] = { 31.25f, 62.5f, 125.0f, 250.0f, 500.0f, 1000.0f, 2000.0f, 4000.0f, 8000.0f, 16000.0f };
+
+// 31 段 1/3 倍频程中心频率(ISO 266)
+constexpr float kThirdOctaveCenters[31] = {
+    20.0f, 25.0f, 31.5f, 40.0f, 50.0f, 63.0f, 80.0f, 100.0f, 125.0f, 160.0f,
+    200.0f, 250.0f, 315.0f, 400.0f, 500.0f, 630.0f, 800.0f, 1000.0f, 1250.0f, 1600.0f,
+    2000.0f, 2500.0f, 3150.0f, 4000.0f, 5000.0f, 6300.0f, 8000.0f, 10000.0f, 12500.0f, 16000.0f,
+    20000.0f };
+
+// 预设(10 段 dB，对应 config.json 中 player.equalizer.preset)；31 段时按对数频率插值
+struct Preset {
+    const char* name;
+    float gainDb[10];
+};
+
+constexpr Preset kPresets[] = {
+    { "flat",      {  0,  0,  0,  0,  0,  0,  0,  0,  0,  0 } },
+    { "classical", {  0,  0,  0,  0,  0,  0, -2, -2, -2, -4 } },
+    { "pop",       { -1,  1,  3,  4,  3,  0, -1, -1, -1, -1 } },
+    { "rock",      {  5,  3, -2, -4, -1,  2,  4,  5,  5,  5 } },
+    { "jazz",      {  3,  2,  1,  2, -1, -1,  0,  1,  2,  3 } },
+    { "dance",     {  6,  5,  2,  0,  0, -2, -3, -3,  0,  0 } },
+    { "vocal",     { -2, -3, -3,  1,  4,  4,  3,  1,  0, -2 } },
+};
+
+class Equalizer {
+public:
+    Equalizer() {
+        for (int b = 0; b < MaxBands; ++b) {
+            target[b].freq.store(1000.0f, std::memory_order_relaxed);
+            target[b].gainDb.store(0.0f, std::memory_order_relaxed);
+            target[b].q.store(1.41f, std::memory_order_relaxed);
+            target[b].type.store(FilterType::Peaking, std::memory_order_relaxed);
+        }
+    }
+
+    // 设置采样率、声道数与频段数(10 或 31，其他值按 10 段)，并清空滤波器状态。
+    // 不是线程安全的: 在音频设备/节点开始回调之前调用。
+    bool init(uint32_t sampleRate, uint32_t channels, int bandCount = 10) {
+        if (sampleRate == 0 || channels == 0 || channels > MaxChannels) return false;
+        rate = static_cast<float>(sampleRate);
+        channelCount = channels;
+        bands = (bandCount == 31) ? 31 : 10;
+        const float* centers = (bands == 31) ? kThirdOctaveCenters : kOctaveCenters;
+        const float q = (bands == 31) ? 4.32f : 1.41f;     // 1/3 倍频程 / 倍频程带宽
+        for (int b = 0; b < bands; ++b) {
+            target[b].freq.store(centers[b], std::memory_order_relaxed);
+            target[b].q.store(q, std::memory_order_relaxed);
+            target[b].type.store(FilterType::Peaking, std::memory_order_relaxed);
+        }
+        bandCountAtomic.store(bands, std::memory_order_release);
+        reset();
+        return true;
+    }
+
+    // 清空滤波器状态并让当前参数立即等于目标值(切换音源时调用，同样只在音频线程外且回调停止时)
+    void reset() {
+        std::memset(state, 0, sizeof(state));
+        for (int b = 0; b < MaxBands; ++b) current[b] = Smoothed();
+        currentPreamp = targetLinearPreamp();
+    }
+
+    int getBandCount() const { return bandCountAtomic.load(std::memory_order_acquire); }
+    uint32_t getChannels() const { return channelCount; }
+
+    // ---- 任意线程，无锁 ----
+    void setEnabled(bool enable) { enabled.store(enable, std::memory_order_relaxed); }
+    bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+    void setBandGain(int band, float gainDb) {
+        if (band < 0 || band >= MaxBands) return;
+        target[band].gainDb.store(std::clamp(gainDb, -24.0f, 24.0f), std::memory_order_relaxed);
+    }
+    float getBandGain(int band) const {
+        return (band >= 0 && band < MaxBands) ? target[band].gainDb.load(std::memory_order_relaxed) : 0.0f;
+    }
+
+    void setBand(int band, float freq, float gainDb, float q, FilterType type = FilterType::Peaking) {
+        if (band < 0 || band >= MaxBands) return;
+        target[band].freq.store(std::max(freq, 10.0f), std::memory_order_relaxed);
+        target[band].q.store(std::clamp(q, 0.1f, 30.0f), std::memory_order_relaxed);
+        target[band].type.store(type, std::memory_order_relaxed);
+        setBandGain(band, gainDb);
+    }
+
+    // 前级增益(dB)，提升频段时可设为负值防止削波
+    void setPreamp(float gainDb) { preampDb.store(std::clamp(gainDb, -24.0f, 24.0f), std::memory_order_relaxed); }
+    float getPreamp() const { return preampDb.load(std::memory_order_relaxed); }
+
+    // 按名称应用预设(不区分大小写)，未知名称返回 false
+    bool applyPreset(const char* name) {
+        for (const Preset& p : kPresets) {
+            if (equalsNoCase(p.name, name)) {
+                applyPreset(p);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void applyPreset(const Preset& preset) {
+        const int n = getBandCount();
+        for (int b = 0; b < n; ++b) {
+            if (n == 10) {
+                setBandGain(b, preset.gainDb[b]);
+                continue;
+            }
+            // 31 段: 在 10 段的对数频率上线性插值
+            float x = std::log2(kThirdOctaveCenters[b] / kOctaveCenters[0]);
+            x = std::clamp(x, 0.0f, 9.0f);
+            int i = std::min(static_cast<int>(x), 8);
+            float t = x - static_cast<float>(i);
+            setBandGain(b, preset.gainDb[i] + (preset.gainDb[i + 1] - preset.gainDb[i]) * t);
+        }
+        setPreamp(-std::max(0.0f, *std::max_element(preset.gainDb, preset.gainDb + 10)) * 0.5f);
+    }
+
+    // ---- 音频线程 ----
+    // 交错 float PCM 原地处理
+    void process(float* frames, uint32_t frameCount) { process(frames, frames, frameCount); }
+
+    // in/out 可以相同；不分配内存、不加锁
+    void process(const float* in, float* out, uint32_t frameCount) {
+#ifdef MEQ_SSE2
+        const unsigned int csr = _mm_getcsr();
+        _mm_setcsr(csr | 0x8040);       // FTZ | DAZ: 静音尾部的次正规数会让 IIR 慢上百倍
+#endif
+        for (uint32_t done = 0; done < frameCount;) {
+            const uint32_t n = std::min<uint32_t>(SubBlock, frameCount - done);
+            updateCoefficients();
+            const float* src = in + static_cast<size_t>(done) * channelCount;
+            float* dst = out + static_cast<size_t>(done) * channelCount;
+            processBlock(src, dst, n);
+            done += n;
+        }
+#ifdef MEQ_SSE2
+        _mm_setcsr(csr);
+#endif
+    }
+
+private:
+    static constexpr uint32_t SubBlock = 32;    // 参数平滑与系数重算的粒度(帧)
+    static constexpr float Smoothing = 0.25f;   // 每个子块向目标靠近的比例(约 20ms 完成 48kHz 下的大幅调节)
+
+    struct Target {
+        std::atomic<float> freq{ 1000.0f };
+        std::atomic<float> gainDb{ 0.0f };
+        std::atomic<float> q{ 1.41f };
+        std::atomic<FilterType> type{ FilterType::Peaking };
+    };
+
+    struct Smoothed {
+        float freq = 1000.0f;
+        float gainDb = 0.0f;
+        float q = 1.41f;
+        FilterType type = FilterType::Peaking;
+        bool valid = false;
+        bool active = false;    // 0dB 的峰值/搁架滤波器为恒等变换，跳过
+    };
+
+    // 归一化系数(a0 = 1)，每个系数按 4 路声道广播，便于 SIMD 直接加载
+    struct alignas(16) Coeffs {
+        float b0[4], b1[4], b2[4], a1[4], a2[4];
+    };
+
+    // 每频段每声道组的 DF2T 状态
+    struct alignas(16) State {
+        float z1[4], z2[4];
+    };
+
+    Target target[MaxBands];
+    std::atomic<float> preampDb{ 0.0f };
+    std::atomic<bool> enabled{ false };
+    std::atomic<int> bandCountAtomic{ 10 };
+
+    // 以下只在音频线程访问
+    float rate = 48000.0f;
+    uint32_t channelCount = 2;
+    int bands = 10;
+    Smoothed current[MaxBands];
+    Coeffs coeffs[MaxBands];
+    State state[MaxBands][MaxChannels / 4];
+    int activeList[MaxBands];
+    int activeCount = 0;
+    float currentPreamp = 1.0f;
+    float preampFrom = 1.0f;
+    float preampTo = 1.0f;
+    alignas(16) float scratch[MaxChannels / 4][SubBlock][4];
+
+    static bool equalsNoCase(const char* a, const char* b) {
+        if (!a || !b) return false;
+        for (; *a && *b; ++a, ++b) {
+            if (std::tolower(static_cast<unsigned char>(*a)) != std::tolower(static_cast<unsigned char>(*b))) return false;
+        }
+        return *a == *b;
+    }
+
+    float targetLinearPreamp() const {
+        return enabled.load(std::memory_order_relaxed)
+            ? std::pow(10.0f, preampDb.load(std::memory_order_relaxed) / 20.0f) : 1.0f;
+    }
+
+    // 每个子块: 读取目标参数，平滑后有变化的频段重算系数，并重建活动频段列表
+    void updateCoefficients() {
+        const bool on = enabled.load(std::memory_order_relaxed);
+        activeCount = 0;
+        for (int b = 0; b < bands; ++b) {
+            Smoothed& c = current[b];
+            const float tGain = on ? target[b].gainDb.load(std::memory_order_relaxed) : 0.0f;   // 关闭时平滑回 0dB 后旁路
+            const float tFreq = std::min(target[b].freq.load(std::memory_order_relaxed), rate * 0.45f);
+            const float tQ = target[b].q.load(std::memory_order_relaxed);
+            const FilterType tType = target[b].type.load(std::memory_order_relaxed);
+
+            bool changed = !c.valid || c.type != tType;
+            if (changed) {
+                c.freq = tFreq; c.q = tQ; c.type = tType;
+                c.gainDb = c.valid ? c.gainDb : tGain;
+                c.valid = true;
+            }
+            changed |= approach(c.gainDb, tGain, 0.01f);
+            changed |= approachLog(c.freq, tFreq);
+            changed |= approach(c.q, tQ, 0.001f);
+
+            const bool active = c.gainDb != 0.0f;
+            if (active && !c.active) {
+                // 从 0dB(恒等)重新启用: 恒等滤波器的状态必然为 0，清零即与连续处理等价
+                for (auto& s : state[b]) std::memset(&s, 0, sizeof(s));
+            }
+            c.active = active;
+            if (!active) continue;
+            if (changed) computeCoefficients(b);
+            activeList[activeCount++] = b;
+        }
+
+        preampFrom = currentPreamp;
+        preampTo = currentPreamp;
+        const float tPre = targetLinearPreamp();
+        approach(preampTo, tPre, 1e-5f);
+        currentPreamp = preampTo;
+    }
+
+    static bool approach(float& value, float target, float epsilon) {
+        if (value == target) return false;
+        float diff = target - value;
+        if (std::fabs(diff) <= epsilon) value = target;
+        else value += diff * Smoothing;
+        return true;
+    }
+
+    static bool approachLog(float& freq, float target) {
+        if (freq == target) return false;
+        float ratio = target / freq;
+        if (std::fabs(ratio - 1.0f) < 1e-4f) freq = target;
+        else freq *= std::pow(ratio, Smoothing);
+        return true;
+    }
+
+    // RBJ Audio EQ Cookbook
+    void computeCoefficients(int band) {
+        const Smoothed& s = current[band];
+        const double A = std::pow(10.0, s.gainDb / 40.0);
+        const double w0 = 2.0 * 3.14159265358979323846 * s.freq / rate;
+        const double cw = std::cos(w0);
+        const double alpha = std::sin(w0) / (2.0 * s.q);
+        double b0, b1, b2, a0, a1, a2;
+        switch (s.type) {
+        case FilterType::LowShelf: {
+            const double k = 2.0 * std::sqrt(A) * alpha;
+            b0 = A * ((A + 1) - (A - 1) * cw + k);
+            b1 = 2 * A * ((A - 1) - (A + 1) * cw);
+            b2 = A * ((A + 1) - (A - 1) * cw - k);
+            a0 = (A + 1) + (A - 1) * cw + k;
+            a1 = -2 * ((A - 1) + (A + 1) * cw);
+            a2 = (A + 1) + (A - 1) * cw - k;
+            break;
+        }
+        case FilterType::HighShelf: {
+            const double k = 2.0 * std::sqrt(A) * alpha;
+            b0 = A * ((A + 1) + (A - 1) * cw + k);
+            b1 = -2 * A * ((A - 1) + (A + 1) * cw);
+            b2 = A * ((A + 1) + (A - 1) * cw - k);
+            a0 = (A + 1) - (A - 1) * cw + k;
+            a1 = 2 * ((A - 1) - (A + 1) * cw);
+            a2 = (A + 1) - (A - 1) * cw - k;
+            break;
+        }
+        default:
+            b0 = 1 + alpha * A;
+            b1 = -2 * cw;
+            b2 = 1 - alpha * A;
+            a0 = 1 + alpha / A;
+            a1 = -2 * cw;
+            a2 = 1 - alpha / A;
+            break;
+        }
+        Coeffs& c = coeffs[band];
+        for (int i = 0; i < 4; ++i) {
+            c.b0[i] = static_cast<float>(b0 / a0);
+            c.b1[i] = static_cast<float>(b1 / a0);
+            c.b2[i] = static_cast<float>(b2 / a0);
+            c.a1[i] = static_cast<float>(a1 / a0);
+            c.a2[i] = static_cast<float>(a2 / a0);
+        }
+    }
+
+    // 子块处理: 交错 PCM 转为按 4 声道一组的 SoA，逐频段跑完整个子块(状态留在寄存器)，再写回
+    void processBlock(const float* in, float* out, uint32_t frames) {
+        const uint32_t ch = channelCount;
+        if (activeCount == 0 && preampFrom == 1.0f && preampTo == 1.0f) {
+            if (in != out) std::memmove(out, in, sizeof(float) * frames * ch);
+            return;
+        }
+        const uint32_t groups = (ch + 3) / 4;
+        const float gainStep = (preampTo - preampFrom) / static_cast<float>(frames);
+
+        for (uint32_t i = 0; i < frames; ++i) {
+            const float gain = preampFrom + gainStep * static_cast<float>(i + 1);
+            const float* x = in + static_cast<size_t>(i) * ch;
+            for (uint32_t g = 0; g < groups; ++g) {
+                float* v = scratch[g][i];
+                const uint32_t lanes = std::min<uint32_t>(4, ch - g * 4);
+                for (uint32_t l = 0; l < 4; ++l) v[l] = (l < lanes) ? x[g * 4 + l] * gain : 0.0f;
+            }
+        }
+
+        int k = 0;
+#ifdef MEQ_SSE2
+        if (ch == 2) {
+            // 立体声只占 2 路，两个频段合用一个寄存器
+            for (; k + 1 < activeCount; k += 2) {
+                const int b = activeList[k], b1 = activeList[k + 1];
+                runBandPair(coeffs[b], state[b][0], coeffs[b1], state[b1][0], scratch[0], frames);
+            }
+        }
+#endif
+        for (; k < activeCount; ++k) {
+            const int b = activeList[k];
+            for (uint32_t g = 0; g < groups; ++g) runBand(coeffs[b], state[b][g], scratch[g], frames);
+        }
+
+        for (uint32_t i = 0; i < frames; ++i) {
+            float* y = out + static_cast<size_t>(i) * ch;
+            for (uint32_t g = 0; g < groups; ++g) {
+                const uint32_t lanes = std::min<uint32_t>(4, ch - g * 4);
+                for (uint32_t l = 0; l < lanes; ++l) y[g * 4 + l] = scratch[g][i][l];
+            }
+        }
+    }
+
+    // 一个频段处理一组(最多 4 个声道)的整个子块
+    static void runBand(const Coeffs& c, State& s, float (*v)[4], uint32_t frames) {
+#ifdef MEQ_SSE2
+        const __m128 b0 = _mm_load_ps(c.b0), b1 = _mm_load_ps(c.b1), b2 = _mm_load_ps(c.b2);
+        const __m128 a1 = _mm_load_ps(c.a1), a2 = _mm_load_ps(c.a2);
+        __m128 z1 = _mm_load_ps(s.z1);
+        __m128 z2 = _mm_load_ps(s.z2);
+        for (uint32_t i = 0; i < frames; ++i) {
+            const __m128 x = _mm_load_ps(v[i]);
+            const __m128 y = _mm_add_ps(_mm_mul_ps(b0, x), z1);
+            z1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1, x), _mm_mul_ps(a1, y)), z2);
+            z2 = _mm_sub_ps(_mm_mul_ps(b2, x), _mm_mul_ps(a2, y));
+            _mm_store_ps(v[i], y);
+        }
+        _mm_store_ps(s.z1, z1);
+        _mm_store_ps(s.z2, z2);
+#else
+        for (uint32_t i = 0; i < frames; ++i) {
+            for (int l = 0; l < 4; ++l) {
+                const float x = v[i][l];
+                const float y = c.b0[l] * x + s.z1[l];
+                s.z1[l] = c.b1[l] * x - c.a1[l] * y + s.z2[l];
+                s.z2[l] = c.b2[l] * x - c.a2[l] * y;
+                v[i][l] = y;
+            }
+        }
+#endif
+    }
+
+#ifdef MEQ_SSE2
+    // 立体声两个级联频段: 低 2 路为频段 c0 的第 i 帧，高 2 路为频段 c1 的第 i-1 帧(输入即上一步低 2 路的输出)，
+    // 一个子块 frames + 1 步跑完两个频段；首步只推进低 2 路状态，末步只推进高 2 路状态。
+    // 每路的运算与 runBand 完全相同，结果逐位一致。
+    static void runBandPair(const Coeffs& c0, State& s0, const Coeffs& c1, State& s1, float (*v)[4], uint32_t frames) {
+        auto pair = [](const float* lo, const float* hi) {
+            return _mm_shuffle_ps(_mm_load_ps(lo), _mm_load_ps(hi), _MM_SHUFFLE(1, 0, 1, 0));
+        };
+        const __m128 b0 = pair(c0.b0, c1.b0), b1 = pair(c0.b1, c1.b1), b2 = pair(c0.b2, c1.b2);
+        const __m128 a1 = pair(c0.a1, c1.a1), a2 = pair(c0.a2, c1.a2);
+        __m128 z1 = pair(s0.z1, s1.z1);
+        __m128 z2 = pair(s0.z2, s1.z2);
+
+        auto step = [&](__m128 x, __m128& n1, __m128& n2) {
+            const __m128 y = _mm_add_ps(_mm_mul_ps(b0, x), z1);
+            n1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1, x), _mm_mul_ps(a1, y)), z2);
+            n2 = _mm_sub_ps(_mm_mul_ps(b2, x), _mm_mul_ps(a2, y));
+            return y;
+        };
+
+        // 首步: 频段 c1 尚无输入，保留其状态
+        __m128 n1, n2;
+        __m128 y = step(_mm_load_ps(v[0]), n1, n2);
+        z1 = _mm_shuffle_ps(n1, z1, _MM_SHUFFLE(3, 2, 1, 0));
+        z2 = _mm_shuffle_ps(n2, z2, _MM_SHUFFLE(3, 2, 1, 0));
+        for (uint32_t i = 1; i < frames; ++i) {
+            y = step(_mm_movelh_ps(_mm_load_ps(v[i]), y), z1, z2);
+            _mm_storeh_pi(reinterpret_cast<__m64*>(v[i - 1]), y);
+        }
+        // 末步: 频段 c0 已处理完整个子块，保留其状态
+        y = step(_mm_movelh_ps(_mm_setzero_ps(), y), n1, n2);
+        _mm_storeh_pi(reinterpret_cast<__m64*>(v[frames - 1]), y);
+        z1 = _mm_shuffle_ps(z1, n1, _MM_SHUFFLE(3, 2, 1, 0));
+        z2 = _mm_shuffle_ps(z2, n2, _MM_SHUFFLE(3, 2, 1, 0));
+
+        _mm_storel_pi(reinterpret_cast<__m64*>(s0.z1), z1);
+        _mm_storel_pi(reinterpret_cast<__m64*>(s0.z2), z2);
+        _mm_storeh_pi(reinterpret_cast<__m64*>(s1.z1), z1);
+        _mm_storeh_pi(reinterpret_cast<__m64*>(s1.z2), z2);
+    }
+#endif
+};
+
+} // namespace meq
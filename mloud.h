@@ -0,0 +1,543 @@
+﻿/****************************************************************************
+ * 标题: mloud.h - 响度分析(EBU R128 / ReplayGain 2.0)与结果缓存
+ * 文件: mloud.h
+ * 版本: 0.1
+ * 作者: AEGLOVE
+ * 日期: 2026-10-19
+ * 功能: Meter 按 ITU-R BS.1770-4 计算积分响度(K 加权、400ms 块、绝对/相对门限)
+ *       与真峰值(4 倍过采样)；Analyzer 在低优先级后台线程池中用 miniaudio 解码并分析，
+ *       结果按文件身份(路径 + 大小 + 修改时间)缓存到磁盘，播放时只需查表设置一次音量。
+ * 依赖: C++17, miniaudio(须在本文件之前包含 miniaudio.h)
+ * 环境: Windows11 x64, VS2022, C++17, Unicode字符集
+ * 编码: UTF-8 (BOM)
+ ****************************************************************************/
+
+#pragma once
+
+#ifndef miniaudio_h
+#error "mloud.h: include miniaudio.h first"
+#endif
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <algorithm>
+
+namespace mloud {
+
+constexpr float kReferenceLufs = -18.0f;    // ReplayGain 2.0 参考响度
+
+struct Result {
+    float integratedLufs = -70.0f;  // 积分响度(LUFS)，无有效块时为 -70
+    float truePeak = 0.0f;          // 真峰值(线性，1.0 = 0 dBTP)
+    float gainDb = 0.0f;            // 相对参考响度的增益
+    double seconds = 0.0;           // 音频时长
+
+    // 播放时的线性增益；preventClipping 时保证 truePeak * gain <= 1
+    float linearGain(bool preventClipping = true) const {
+        float g = std::pow(10.0f, gainDb / 20.0f);
+        if (preventClipping && truePeak > 0.0f) g = std::min(g, 1.0f / truePeak);
+        return g;
+    }
+};
+
+// BS.1770-4 响度计。add() 可分块多次调用，不保留音频数据(每 100ms 只记一个能量值)
+class Meter {
+public:
+    bool init(uint32_t sampleRate, uint32_t channelCount) {
+        if (sampleRate == 0 || channelCount == 0 || channelCount > 8) return false;
+        rate = sampleRate;
+        channels = channelCount;
+        designKWeighting();
+        hop = std::max<uint32_t>(1, rate / 10);
+        filters.assign(channels, Biquads());
+        history.assign(channels, TruePeakHistory());
+        weights.assign(channels, 1.0);
+        if (channels >= 6) {        // 5.1: L R C LFE Ls Rs
+            weights[3] = 0.0;
+            weights[4] = weights[5] = 1.41;
+        }
+        subBlocks.clear();
+        hopEnergy = 0.0;
+        hopFrames = 0;
+        totalFrames = 0;
+        peak = 0.0f;
+        return true;
+    }
+
+    // 交错 float PCM
+    void add(const float* frames, uint32_t frameCount) {
+        for (uint32_t i = 0; i < frameCount; ++i) {
+            const float* x = frames + static_cast<size_t>(i) * channels;
+            double sum = 0.0;
+            for (uint32_t c = 0; c < channels; ++c) {
+                const double y = filters[c].run(x[c], kw);
+                sum += weights[c] * y * y;
+                peak = std::max(peak, history[c].push(x[c]));
+            }
+            hopEnergy += sum;
+            if (++hopFrames == hop) {
+                subBlocks.push_back(hopEnergy / hop);
+                hopEnergy = 0.0;
+                hopFrames = 0;
+            }
+        }
+        totalFrames += frameCount;
+    }
+
+    // 积分响度: 400ms 块(4 个 100ms 子块，75% 重叠)，-70 LUFS 绝对门限，再以 -10 LU 相对门限
+    float integratedLufs() const {
+        if (subBlocks.size() < 4) return -70.0f;
+        std::vector<double> blocks;
+        blocks.reserve(subBlocks.size() - 3);
+        for (size_t i = 3; i < subBlocks.size(); ++i) {
+            blocks.push_back((subBlocks[i - 3] + subBlocks[i - 2] + subBlocks[i - 1] + subBlocks[i]) * 0.25);
+        }
+        const double absGate = energyOf(-70.0);
+        double sum = 0.0;
+        size_t n = 0;
+        for (double e : blocks) if (e > absGate) { sum += e; ++n; }
+        if (n == 0) return -70.0f;
+        const double relGate = std::max(absGate, sum / n * std::pow(10.0, -10.0 / 10.0));
+        sum = 0.0;
+        n = 0;
+        for (double e : blocks) if (e > relGate) { sum += e; ++n; }
+        return n ? static_cast<float>(lufsOf(sum / n)) : -70.0f;
+    }
+
+    float truePeak() const { return peak; }
+    double seconds() const { return rate ? static_cast<double>(totalFrames) / rate : 0.0; }
+
+    Result result(float referenceLufs = kReferenceLufs) const {
+        Result r;
+        r.integratedLufs = integratedLufs();
+        r.truePeak = peak;
+        r.gainDb = (r.integratedLufs > -70.0f) ? referenceLufs - r.integratedLufs : 0.0f;
+        r.seconds = seconds();
+        return r;
+    }
+
+private:
+    struct Coeffs { double b0, b1, b2, a1, a2; };
+    struct KWeighting { Coeffs shelf, highpass; };
+
+    // 两级 DF2T: 高搁架(头部声学) + RLB 高通
+    struct Biquads {
+        double s1 = 0, s2 = 0, h1 = 0, h2 = 0;
+        double run(double x, const KWeighting& k) {
+            double y = k.shelf.b0 * x + s1;
+            s1 = k.shelf.b1 * x - k.shelf.a1 * y + s2;
+            s2 = k.shelf.b2 * x - k.shelf.a2 * y;
+            x = y;
+            y = k.highpass.b0 * x + h1;
+            h1 = k.highpass.b1 * x - k.highpass.a1 * y + h2;
+            h2 = k.highpass.b2 * x - k.highpass.a2 * y;
+            return y;
+        }
+    };
+
+    // 4 倍过采样真峰值: 每个新采样在 n-6 与 n-5 之间插出 1/4、2/4、3/4 三个点(12 抽头 Hann 窗 sinc)
+    struct TruePeakHistory {
+        float x[24] = {};   // 环形历史写两份，x[pos..pos+11] 总是从旧到新连续排列(便于向量化)
+        int pos = 0;
+        float push(float v) {
+            x[pos] = x[pos + 12] = v;
+            pos = (pos == 11) ? 0 : pos + 1;
+            const float* w = x + pos;
+            const auto& taps = phaseTaps();
+            float m = std::fabs(v);
+            for (int p = 0; p < 3; ++p) {
+                float acc = 0.0f;
+                for (int k = 0; k < 12; ++k) acc += taps[p][k] * w[k];
+                m = std::max(m, std::fabs(acc));
+            }
+            return m;
+        }
+    };
+
+    static const std::array<std::array<float, 12>, 3>& phaseTaps() {
+        static const std::array<std::array<float, 12>, 3> taps = [] {
+            const double pi = 3.14159265358979323846;
+            std::array<std::array<float, 12>, 3> t{};
+            for (int p = 0; p < 3; ++p) {
+                double sum = 0.0;
+                for (int k = 0; k < 12; ++k) {
+                    const double d = 5.0 + (p + 1) / 4.0 - k;     // 插值点到第 k 个历史采样的距离
+                    const double sinc = std::sin(pi * d) / (pi * d);
+                    const double w = 0.5 + 0.5 * std::cos(pi * d / 6.0);
+                    t[p][k] = static_cast<float>(sinc * w);
+                    sum += sinc * w;
+                }
+                for (float& v : t[p]) v = static_cast<float>(v / sum);     // 单位直流增益
+            }
+            return t;
+        }();
+        return taps;
+    }
+
+    uint32_t rate = 0;
+    uint32_t channels = 0;
+    uint32_t hop = 4800;
+    KWeighting kw{};
+    std::vector<Biquads> filters;
+    std::vector<TruePeakHistory> history;
+    std::vector<double> weights;
+    std::vector<double> subBlocks;  // 每 100ms 的加权均方
+    double hopEnergy = 0.0;
+    uint32_t hopFrames = 0;
+    uint64_t totalFrames = 0;
+    float peak = 0.0f;
+
+    static double energyOf(double lufs) { return std::pow(10.0, (lufs + 0.691) / 10.0); }
+    static double lufsOf(double energy) { return -0.691 + 10.0 * std::log10(energy); }
+
+    // 任意采样率下的 K 加权系数(双线性变换，48kHz 时与 BS.1770 给出的系数一致)
+    void designKWeighting() {
+        const double pi = 3.14159265358979323846;
+        {
+            const double f0 = 1681.974450955533, G = 3.999843853973347, Q = 0.7071752369554196;
+            const double K = std::tan(pi * f0 / rate);
+            const double Vh = std::pow(10.0, G / 20.0);
+            const double Vb = std::pow(Vh, 0.4996667741545416);
+            const double a0 = 1.0 + K / Q + K * K;
+            kw.shelf = { (Vh + Vb * K / Q + K * K) / a0, 2.0 * (K * K - Vh) / a0, (Vh - Vb * K / Q + K * K) / a0,
+                         2.0 * (K * K - 1.0) / a0, (1.0 - K / Q + K * K) / a0 };
+        }
+        {
+            const double f0 = 38.13547087602444, Q = 0.5003270373238773;
+            const double K = std::tan(pi * f0 / rate);
+            const double a0 = 1.0 + K / Q + K * K;
+            kw.highpass = { 1.0, -2.0, 1.0, 2.0 * (K * K - 1.0) / a0, (1.0 - K / Q + K * K) / a0 };
+        }
+    }
+};
+
+// 后台分析器: analyze() 只入队路径，工作线程(低优先级)查缓存、解码、计算，结果按文件身份缓存
+class Analyzer {
+public:
+    struct Stats {
+        uint64_t queued = 0;
+        uint64_t analyzed = 0;      // 本次实际解码分析的曲目
+        uint64_t cached = 0;        // 缓存命中跳过的曲目
+        uint64_t failed = 0;
+        double audioSeconds = 0.0;  // 已分析的音频总时长
+        double wallSeconds = 0.0;   // 工作线程忙碌的墙钟时间
+        // 每分钟分析的音频小时数
+        double hoursPerMinute() const { return wallSeconds > 0.0 ? (audioSeconds / 3600.0) / (wallSeconds / 60.0) : 0.0; }
+    };
+
+    // 在工作线程中调用(每首分析完成后)
+    std::function<void(const std::filesystem::path&, const Result&)> onResult;
+    // 在最后退出的工作线程中调用(队列清空、缓存写回之后)，参数为累计统计；stop() 取消时不调用
+    std::function<void(const Stats&)> onFinished;
+
+    ~Analyzer() { stop(); }
+
+    // 解码时使用的 VFS(如 mvfs::MappedVfs)；为空时使用 miniaudio 默认的 stdio 读取。在 analyze() 之前设置
+    void setVfs(ma_vfs* v) { vfs = v; }
+
+    // 设置缓存文件并读取已有结果；队列清空时自动写回
+    bool setCacheFile(const std::filesystem::path& file) {
+        std::lock_guard<std::mutex> lock(mutex);
+        cacheFile = file;
+        return loadCacheLocked();
+    }
+
+    // 入队(立即返回)。threads 为 0 时使用 硬件线程数 - 1
+    void analyze(const std::vector<std::filesystem::path>& files, unsigned threads = 0) {
+        std::vector<std::thread> finished;      // 上一批已退出循环的线程，解锁后再 join(可能正在写缓存)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (const auto& f : files) {
+                std::string key = keyOf(f);
+                if (queuedKeys.insert(key).second) queue.push_back(f);
+            }
+            stats.queued += files.size();
+            stopping = false;
+            if (threads == 0) {
+                const unsigned hw = std::thread::hardware_concurrency();    // 可能返回 0(未知)
+                threads = hw > 1 ? hw - 1 : 1;
+            }
+            if (activeWorkers == 0) {
+                finished.swap(workers);
+                busySince = std::chrono::steady_clock::now();
+            }
+            const unsigned want = static_cast<unsigned>(std::min<size_t>(threads, queue.size()));
+            while (activeWorkers < want) {
+                ++activeWorkers;
+                workers.emplace_back([this] { workerLoop(); });
+            }
+        }
+        for (auto& t : finished) if (t.joinable()) t.join();
+    }
+
+    // 取消尚未开始的曲目并等待工作线程退出
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            queue.clear();
+            queuedKeys.clear();
+        }
+        for (auto& t : workers) if (t.joinable()) t.join();
+        workers.clear();
+    }
+
+    bool isBusy() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return activeWorkers > 0;
+    }
+
+    // 按文件身份查找(会 stat 一次文件，大小或修改时间变化视为未分析)
+    bool lookup(const std::filesystem::path& file, Result& out) const {
+        Identity id;
+        if (!identityOf(file, id)) return false;
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = cache.find(keyOf(file));
+        if (it == cache.end() || it->second.size != id.size || it->second.mtime != id.mtime) return false;
+        out = it->second.result;
+        return true;
+    }
+
+    // 播放用线性增益，未分析时为 1
+    float gainFor(const std::filesystem::path& file, bool preventClipping = true) const {
+        Result r;
+        return lookup(file, r) ? r.linearGain(preventClipping) : 1.0f;
+    }
+
+    Stats getStats() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        Stats s = stats;
+        if (activeWorkers > 0) {
+            s.wallSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - busySince).count();
+        }
+        return s;
+    }
+
+    bool saveCache() {
+        CacheSnapshot snap;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!snapshotCacheLocked(snap)) return false;
+        }
+        return writeCache(snap);
+    }
+
+private:
+    struct Identity {
+        uint64_t size = 0;
+        int64_t mtime = 0;
+    };
+
+    struct Entry {
+        uint64_t size = 0;
+        int64_t mtime = 0;
+        Result result;
+    };
+
+    // 在锁内格式化好的缓存内容，锁外写盘(写文件期间 gainFor 等查询不被阻塞)
+    struct CacheSnapshot {
+        std::filesystem::path file;
+        std::string text;
+        uint64_t generation = 0;
+    };
+
+    mutable std::mutex mutex;
+    std::deque<std::filesystem::path> queue;
+    std::unordered_set<std::string> queuedKeys;
+    std::unordered_map<std::string, Entry> cache;
+    std::filesystem::path cacheFile;
+    ma_vfs* vfs = nullptr;
+    std::vector<std::thread> workers;
+    unsigned activeWorkers = 0;
+    bool stopping = false;
+    bool dirty = false;
+    uint64_t snapshotGeneration = 0;    // mutex 保护
+    std::mutex saveMutex;               // 串行化写文件；较旧的快照不覆盖较新的
+    uint64_t writtenGeneration = 0;     // saveMutex 保护
+    Stats stats;
+    std::chrono::steady_clock::time_point busySince;
+
+    static std::string keyOf(const std::filesystem::path& file) {
+        return file.lexically_normal().generic_u8string();
+    }
+
+    static bool identityOf(const std::filesystem::path& file, Identity& id) {
+        std::error_code ec;
+        id.size = std::filesystem::file_size(file, ec);
+        if (ec) return false;
+        auto t = std::filesystem::last_write_time(file, ec);
+        if (ec) return false;
+        id.mtime = static_cast<int64_t>(t.time_since_epoch().count());
+        return true;
+    }
+
+    void workerLoop() {
+#ifdef _WIN32
+        SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);   // 同时降低 CPU 与磁盘 I/O 优先级
+#endif
+        std::vector<float> buffer;
+        for (;;) {
+            std::filesystem::path file;
+            CacheSnapshot snap;
+            bool finished = false, save = false, drained = false;
+            Stats total;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (stopping || queue.empty()) {
+                    finished = true;
+                    if (--activeWorkers == 0) {
+                        stats.wallSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - busySince).count();
+                        save = dirty && snapshotCacheLocked(snap);
+                        drained = !stopping;
+                        total = stats;
+                    }
+                }
+                else {
+                    file = std::move(queue.front());
+                    queue.pop_front();
+                    queuedKeys.erase(keyOf(file));
+                }
+            }
+            if (finished) {
+                if (save) writeCache(snap);
+                if (drained && onFinished) onFinished(total);
+                return;
+            }
+
+            Identity id;
+            const std::string key = keyOf(file);
+            bool ok = identityOf(file, id);
+            if (ok) {
+                std::lock_guard<std::mutex> lock(mutex);
+                auto it = cache.find(key);
+                if (it != cache.end() && it->second.size == id.size && it->second.mtime == id.mtime) {
+                    ++stats.cached;
+                    continue;
+                }
+            }
+
+            Result r;
+            ok = ok && analyzeFile(file, r, buffer);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!ok) {
+                    ++stats.failed;
+                    continue;
+                }
+                cache[key] = Entry{ id.size, id.mtime, r };
+                ++stats.analyzed;
+                stats.audioSeconds += r.seconds;
+                dirty = true;
+            }
+            if (onResult) onResult(file, r);
+        }
+    }
+
+    bool analyzeFile(const std::filesystem::path& file, Result& out, std::vector<float>& buffer) {
+        ma_decoder_config config = ma_decoder_config_init(ma_format_f32, 0, 0);   // 原始声道数与采样率
+        ma_decoder decoder;
+#ifdef _WIN32
+        ma_result opened = vfs ? ma_decoder_init_vfs_w(vfs, file.c_str(), &config, &decoder)
+                               : ma_decoder_init_file_w(file.c_str(), &config, &decoder);
+#else
+        ma_result opened = vfs ? ma_decoder_init_vfs(vfs, file.c_str(), &config, &decoder)
+                               : ma_decoder_init_file(file.c_str(), &config, &decoder);
+#endif
+        if (opened != MA_SUCCESS) return false;
+        Meter meter;
+        bool ok = meter.init(decoder.outputSampleRate, decoder.outputChannels);
+        const ma_uint64 chunk = 4096;
+        buffer.resize(static_cast<size_t>(chunk) * std::max<ma_uint32>(decoder.outputChannels, 1));
+        while (ok) {
+            ma_uint64 read = 0;
+            ma_result result = ma_decoder_read_pcm_frames(&decoder, buffer.data(), chunk, &read);
+            if (read > 0) meter.add(buffer.data(), static_cast<uint32_t>(read));
+            if (result != MA_SUCCESS || read < chunk) break;
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping) ok = false;
+        }
+        ma_decoder_uninit(&decoder);
+        if (ok) out = meter.result();
+        return ok;
+    }
+
+    // 缓存文件: UTF-8 文本，每行 "大小\t修改时间\tLUFS\t真峰值\t增益dB\t时长\t路径"
+    bool loadCacheLocked() {
+        std::ifstream in(cacheFile, std::ios::binary);
+        if (!in) return false;
+        std::string line;
+        while (std::getline(in, line)) {
+            unsigned long long size = 0;
+            long long mtime = 0;
+            float lufs = 0, peak = 0, gain = 0;
+            double seconds = 0;
+            int consumed = 0;
+            if (std::sscanf(line.c_str(), "%llu\t%lld\t%f\t%f\t%f\t%lf\t%n", &size, &mtime, &lufs, &peak, &gain, &seconds, &consumed) < 6
+                || consumed <= 0) continue;
+            Entry e;
+            e.size = size;
+            e.mtime = mtime;
+            e.result = Result{ lufs, peak, gain, seconds };
+            cache[line.substr(consumed)] = e;
+        }
+        return true;
+    }
+
+    bool snapshotCacheLocked(CacheSnapshot& snap) {
+        if (cacheFile.empty()) return false;
+        snap.file = cacheFile;
+        snap.text.clear();
+        snap.text.reserve(cache.size() * 96);
+        char buf[160];
+        for (const auto& [key, e] : cache) {
+            std::snprintf(buf, sizeof(buf), "%llu\t%lld\t%.3f\t%.6f\t%.3f\t%.3f\t",
+                static_cast<unsigned long long>(e.size), static_cast<long long>(e.mtime),
+                e.result.integratedLufs, e.result.truePeak, e.result.gainDb, e.result.seconds);
+            snap.text += buf;
+            snap.text += key;
+            snap.text += '\n';
+        }
+        snap.generation = ++snapshotGeneration;
+        dirty = false;
+        return true;
+    }
+
+    bool writeCache(const CacheSnapshot& snap) {
+        std::lock_guard<std::mutex> saveLock(saveMutex);
+        if (snap.generation <= writtenGeneration) return true;     // 已有更新的快照写入
+        std::filesystem::path tmp = snap.file;
+        tmp += ".tmp";
+        bool ok = false;
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            ok = static_cast<bool>(out.write(snap.text.data(), static_cast<std::streamsize>(snap.text.size())));
+        }
+        std::error_code ec;
+        if (ok) std::filesystem::rename(tmp, snap.file, ec);   // 先写临时文件再替换，中途退出不会损坏缓存
+        ok = ok && !ec;
+        if (ok) {
+            writtenGeneration = snap.generation;
+        }
+        else {
+            std::lock_guard<std::mutex> lock(mutex);
+            dirty = true;
+        }
+        return ok;
+    }
+};
+
+} // namespace mloud
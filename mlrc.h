@@ -0,0 +1,352 @@
+﻿/****************************************************************************
+ * 标题: mlrc.h - LRC / 增强 LRC 歌词解析
+ * 文件: mlrc.h
+ * 版本: 0.1
+ * 作者: AEGLOVE
+ * 日期: 2026-10-18
+ * 功能: 在 UTF-8 原始缓冲上一次扫描完成解析，支持 BOM、一行多时间标签、
+ *       [offset:] 偏移、[ti:]/[ar:]/[al:] 元数据与逐字 <mm:ss.xx> 时间。
+ *       所有行/字只以偏移引用同一块文本存储，解析过程不做逐行分配。
+ * 依赖: C++17
+ * 环境: Windows11 x64, VS2022, C++17, Unicode字符集
+ * 编码: UTF-8 (BOM)
+ ****************************************************************************/
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+
+namespace mlrc {
+
+// 逐字时间(增强 LRC)。dt 相对所在行的起始时间，便于同一文本被多个时间标签复用
+struct Word {
+    float dt = 0.0f;
+    uint32_t off = 0;       // 在 Document 文本存储中的字节偏移
+    uint32_t len = 0;       // 字节长度(行尾的结束时间标签对应长度为 0 的字)
+};
+
+struct Line {
+    float t = 0.0f;         // 秒
+    uint32_t off = 0;       // 文本字节偏移(文本以 '\0' 结尾，可直接当 C 字符串使用)
+    uint32_t len = 0;
+    uint32_t firstWord = 0;
+    uint32_t wordCount = 0;
+};
+
+class Document {
+public:
+    // 解析 UTF-8 文本。keepUntimed=true 时无时间标签的非空行按 0 秒保留
+    bool parse(std::string_view src, bool keepUntimed = false);
+
+    // 读取整个文件后解析(路径按 fopen 的本地编码)
+    bool loadFile(const char* path, bool keepUntimed = false);
+#ifdef _WIN32
+    bool loadFile(const wchar_t* path, bool keepUntimed = false);
+#endif
+
+    void clear() {
+        storage.clear();
+        lineList.clear();
+        wordList.clear();
+        offsetMs = 0;
+        titleRange = artistRange = albumRange = Range();
+    }
+
+    bool empty() const { return lineList.empty(); }
+    size_t size() const { return lineList.size(); }
+
+    const std::vector<Line>& lines() const { return lineList; }
+    const std::vector<Word>& words() const { return wordList; }
+    const Line& operator[](size_t i) const { return lineList[i]; }
+
+    const char* c_str(const Line& l) const { return storage.data() + l.off; }
+    std::string_view text(const Line& l) const { return std::string_view(storage.data() + l.off, l.len); }
+    std::string_view text(const Word& w) const { return std::string_view(storage.data() + w.off, w.len); }
+
+    int offset() const { return offsetMs; }
+    std::string_view title() const { return view(titleRange); }
+    std::string_view artist() const { return view(artistRange); }
+    std::string_view album() const { return view(albumRange); }
+
+    // 追加一行(供旧接口转换使用)，text 会复制进文本存储
+    void addLine(float t, std::string_view text) {
+        Line l;
+        l.t = t;
+        l.off = static_cast<uint32_t>(storage.size());
+        l.len = static_cast<uint32_t>(text.size());
+        l.firstWord = static_cast<uint32_t>(wordList.size());
+        storage.append(text.data(), text.size());
+        storage.push_back('\0');
+        lineList.push_back(l);
+    }
+
+    // 二分查找 t 时刻所在行，之前无行时返回 -1
+    int indexAt(float t) const {
+        auto it = std::upper_bound(lineList.begin(), lineList.end(), t,
+            [](float v, const Line& l) { return v < l.t; });
+        return static_cast<int>(it - lineList.begin()) - 1;
+    }
+
+private:
+    struct Range { uint32_t off = 0, len = 0; };
+
+    std::string storage;            // 源文本副本(单次分配)，解析时就地压缩去除逐字标签
+    std::vector<Line> lineList;
+    std::vector<Word> wordList;
+    int offsetMs = 0;
+    Range titleRange, artistRange, albumRange;
+
+    std::string_view view(Range r) const { return std::string_view(storage.data() + r.off, r.len); }
+
+    bool parseStorage(bool keepUntimed);
+    bool readFile(FILE* f, bool keepUntimed);
+    void parseLine(size_t begin, size_t end, bool keepUntimed);
+};
+
+namespace detail {
+
+inline bool isSpace(char c) { return c == ' ' || c == '\t'; }
+
+// 解析 "mm:ss"、"mm:ss.xx"、"mm:ss.xxx"、"mm:ss:xx"，成功返回 true
+inline bool parseTime(const char* p, const char* end, float& out) {
+    auto digits = [&](const char*& q, uint32_t& v, int& n) {
+        v = 0; n = 0;
+        while (q < end && *q >= '0' && *q <= '9' && n < 9) { v = v * 10 + uint32_t(*q - '0'); ++q; ++n; }
+        return n > 0;
+    };
+
+    while (p < end && isSpace(*p)) ++p;
+    uint32_t mm, ss, frac = 0;
+    int n, fracDigits = 0;
+    if (!digits(p, mm, n) || p >= end || *p != ':') return false;
+    ++p;
+    if (!digits(p, ss, n)) return false;
+    if (p < end && (*p == '.' || *p == ':')) {
+        ++p;
+        if (!digits(p, frac, fracDigits)) return false;
+    }
+    while (p < end && isSpace(*p)) ++p;
+    if (p != end) return false;
+
+    float scale = 1.0f;
+    for (int i = 0; i < fracDigits; ++i) scale *= 10.0f;
+    out = float(mm) * 60.0f + float(ss) + (fracDigits ? float(frac) / scale : 0.0f);
+    return true;
+}
+
+inline bool parseInt(const char* p, const char* end, int& out) {
+    while (p < end && isSpace(*p)) ++p;
+    bool neg = false;
+    if (p < end && (*p == '+' || *p == '-')) { neg = (*p == '-'); ++p; }
+    if (p >= end || *p < '0' || *p > '9') return false;
+    long v = 0;
+    while (p < end && *p >= '0' && *p <= '9') { if (v < 100000000) v = v * 10 + (*p - '0'); ++p; }
+    out = static_cast<int>(neg ? -v : v);
+    return true;
+}
+
+inline bool keyEquals(const char* p, const char* end, const char* key) {
+    while (p < end && isSpace(*p)) ++p;
+    for (; *key; ++key, ++p) {
+        if (p >= end) return false;
+        char c = *p;
+        if (c >= 'A' && c <= 'Z') c = char(c - 'A' + 'a');
+        if (c != *key) return false;
+    }
+    while (p < end && isSpace(*p)) ++p;
+    return p == end;
+}
+
+} // namespace detail
+
+inline bool Document::parse(std::string_view src, bool keepUntimed) {
+    clear();
+
+    if (src.size() >= 3 && (unsigned char)src[0] == 0xEF && (unsigned char)src[1] == 0xBB && (unsigned char)src[2] == 0xBF) {
+        src.remove_prefix(3);
+    }
+    if (src.size() >= 0xFFFFFFF0u) return false;    // 偏移为 32 位
+
+    storage.assign(src.data(), src.size());
+    return parseStorage(keepUntimed);
+}
+
+// 解析已放入 storage 的文本(不含 BOM)
+inline bool Document::parseStorage(bool keepUntimed) {
+    // 按换行/标签数预留容量，解析过程中两个数组基本不再扩容
+    size_t newlines = static_cast<size_t>(std::count(storage.begin(), storage.end(), '\n')) + 1;
+    lineList.reserve(newlines);
+    wordList.reserve(static_cast<size_t>(std::count(storage.begin(), storage.end(), '<')));
+
+    size_t pos = 0;
+    const size_t n = storage.size();
+    while (pos < n) {
+        size_t end = pos;
+        while (end < n && storage[end] != '\n' && storage[end] != '\r') ++end;
+
+        // parseLine 会在行尾写入 '\0'，先确定下一行起点
+        size_t next = end;
+        if (next < n && storage[next] == '\r') ++next;
+        if (next < n && storage[next] == '\n') ++next;
+
+        parseLine(pos, end, keepUntimed);
+        pos = next;
+    }
+
+    if (offsetMs != 0) {
+        // [offset:+N] 表示歌词整体提前 N 毫秒
+        float shift = offsetMs / 1000.0f;
+        for (auto& l : lineList) l.t = std::max(0.0f, l.t - shift);
+    }
+
+    std::stable_sort(lineList.begin(), lineList.end(),
+        [](const Line& a, const Line& b) { return a.t < b.t; });
+    return !lineList.empty();
+}
+
+inline void Document::parseLine(size_t begin, size_t end, bool keepUntimed) {
+    char* s = &storage[0];
+    const size_t MAX_TAGS = 64;
+    float times[MAX_TAGS];
+    size_t timeCount = 0;
+
+    size_t p = begin;
+    while (p < end && detail::isSpace(s[p])) ++p;
+
+    // 行首的 [..] 标签: 时间或元数据
+    while (p < end && s[p] == '[') {
+        size_t close = p + 1;
+        while (close < end && s[close] != ']') ++close;
+        if (close >= end) break;
+
+        const char* tb = s + p + 1;
+        const char* te = s + close;
+        float t;
+        if (detail::parseTime(tb, te, t)) {
+            if (timeCount < MAX_TAGS) times[timeCount++] = t;
+        }
+        else {
+            const char* colon = tb;
+            while (colon < te && *colon != ':') ++colon;
+            if (colon < te) {
+                const char* vb = colon + 1;
+                const char* ve = te;
+                while (vb < ve && detail::isSpace(*vb)) ++vb;
+                while (ve > vb && detail::isSpace(ve[-1])) --ve;
+                Range value{ static_cast<uint32_t>(vb - s), static_cast<uint32_t>(ve - vb) };
+                if (detail::keyEquals(tb, colon, "offset")) detail::parseInt(colon + 1, te, offsetMs);
+                else if (detail::keyEquals(tb, colon, "ti")) titleRange = value;
+                else if (detail::keyEquals(tb, colon, "ar")) artistRange = value;
+                else if (detail::keyEquals(tb, colon, "al")) albumRange = value;
+            }
+        }
+
+        p = close + 1;
+        while (p < end && detail::isSpace(s[p])) ++p;
+    }
+
+    // 文本: 就地压缩，去掉 <mm:ss.xx> 逐字标签(输出不会比输入长)
+    const size_t textStart = p;
+    size_t w = p;
+    const uint32_t firstWord = static_cast<uint32_t>(wordList.size());
+    float lineStart = timeCount ? times[0] : 0.0f;
+
+    while (p < end) {
+        if (s[p] == '<') {
+            size_t close = p + 1;
+            while (close < end && s[close] != '>') ++close;
+            float t;
+            if (close < end && detail::parseTime(s + p + 1, s + close, t)) {
+                if (timeCount == 0 && wordList.size() == firstWord) lineStart = t;
+                Word word;
+                word.dt = t - lineStart;
+                word.off = static_cast<uint32_t>(w);
+                wordList.push_back(word);
+                p = close + 1;
+                continue;
+            }
+        }
+        s[w++] = s[p++];
+    }
+
+    // 去掉尾部空白并写入结束符(写在被压缩掉的位置或原换行符上)
+    size_t textEnd = w;
+    while (textEnd > textStart && detail::isSpace(s[textEnd - 1])) --textEnd;
+    s[textEnd] = '\0';
+
+    const uint32_t wordCount = static_cast<uint32_t>(wordList.size()) - firstWord;
+    for (uint32_t i = 0; i < wordCount; ++i) {
+        Word& word = wordList[firstWord + i];
+        size_t wordEnd = (i + 1 < wordCount) ? wordList[firstWord + i + 1].off : textEnd;
+        wordEnd = std::min(wordEnd, textEnd);
+        word.off = static_cast<uint32_t>(std::min<size_t>(word.off, textEnd));
+        word.len = static_cast<uint32_t>(wordEnd - word.off);
+    }
+
+    Line line;
+    line.off = static_cast<uint32_t>(textStart);
+    line.len = static_cast<uint32_t>(textEnd - textStart);
+    line.firstWord = firstWord;
+    line.wordCount = wordCount;
+
+    if (timeCount == 0) {
+        // 只有逐字时间的行以第一个字的时间为行时间
+        if (wordCount > 0 || (keepUntimed && line.len > 0)) {
+            line.t = lineStart;
+            lineList.push_back(line);
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < timeCount; ++i) {
+        line.t = times[i];
+        lineList.push_back(line);
+    }
+}
+
+// 文件内容直接读入文本存储后就地解析，不经过中间缓冲；f 由此函数关闭
+inline bool Document::readFile(FILE* f, bool keepUntimed) {
+    clear();
+    std::fseek(f, 0, SEEK_END);
+    long size = std::ftell(f);
+    std::fseek(f, 0, SEEK_SET);
+    if (size >= 3) {
+        unsigned char bom[3] = {};
+        if (std::fread(bom, 1, 3, f) == 3 && bom[0] == 0xEF && bom[1] == 0xBB && bom[2] == 0xBF) size -= 3;
+        else std::fseek(f, 0, SEEK_SET);
+    }
+    if (size <= 0 || static_cast<unsigned long>(size) >= 0xFFFFFFF0u) {
+        std::fclose(f);
+        return false;
+    }
+    storage.resize(static_cast<size_t>(size));
+    storage.resize(std::fread(&storage[0], 1, storage.size(), f));
+    std::fclose(f);
+    return parseStorage(keepUntimed);
+}
+
+inline bool Document::loadFile(const char* path, bool keepUntimed) {
+    FILE* f = nullptr;
+#ifdef _MSC_VER
+    if (fopen_s(&f, path, "rb") != 0) f = nullptr;
+#else
+    f = std::fopen(path, "rb");
+#endif
+    if (!f) { clear(); return false; }
+    return readFile(f, keepUntimed);
+}
+
+#ifdef _WIN32
+inline bool Document::loadFile(const wchar_t* path, bool keepUntimed) {
+    FILE* f = nullptr;
+    if (_wfopen_s(&f, path, L"rb") != 0 || !f) { clear(); return false; }
+    return readFile(f, keepUntimed);
+}
+#endif
+
+} // namespace mlrc
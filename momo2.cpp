@@ -17,6 +17,8 @@ using json = nlohmann::json;
 
 #include "xav.h"
 #include "avfft_standalone.h"
+#include "mlrc.h"
+#include "meq.h"
 
 #include <glad/glad.h>
 #include <windows.h>
@@ -839,6 +841,7 @@ struct AppState {
     ma_device audioDevice{};
     std::atomic<uint64_t> audioSamplesPlayed{0};
     AudioQueue audioQueue{kAudioBufCapacity};
+    meq::Equalizer equalizer;   // 设备回调内原地处理，参数可由 UI 线程无锁调整
     float volume = 0.5f;
     static constexpr int AUDIO_SAMPLE_RATE = kAudioSampleRate;
     static constexpr int AUDIO_CHANNELS = kAudioChannels;
@@ -918,7 +921,7 @@ struct AppState {
     OX::UIDropdown* playlistDropdownPtr = nullptr;
 
     // --- Lyrics ---
-    std::vector<LrcLine> lrcLines;
+    mlrc::Document lrcLines;    // 各行以偏移引用同一块文本，不做逐行分配
     bool showLyrics = true;
     OX::UIButton* lyricsBtnPtr = nullptr;
     int lrcCurrentIndex = -1;
@@ -1038,20 +1041,16 @@ static void uploadVideoFrame(AppState& st, const uint8_t* data, int w, int h) {
 }
 
 /*==================== 歌词更新 ====================*/
+// 第 i 行歌词文本(空文本行显示为 ♪)
+static const char* lrcText(const mlrc::Document& doc, int i) {
+    const mlrc::Line& l = doc[i];
+    return l.len ? doc.c_str(l) : "\xe2\x99\xaa";
+}
+
 static void updateLyrics(AppState& st) {
     if (st.lrcLines.empty()) return;
 
-    int idx = -1;
-    int lo = 0, hi = (int)st.lrcLines.size() - 1;
-    while (lo <= hi) {
-        int mid = (lo + hi) / 2;
-        if (st.lrcLines[mid].timestamp <= st.videoTime) {
-            idx = mid;
-            lo = mid + 1;
-        } else {
-            hi = mid - 1;
-        }
-    }
+    int idx = st.lrcLines.indexAt((float)st.videoTime);
 
     if (idx == st.lrcCurrentIndex) return;
     st.lrcCurrentIndex = idx;
@@ -1164,7 +1163,7 @@ static void renderLyricsToFbo(AppState& st, float lrcX, float lrcY, float lrcW,
         int lineIdx = st.lrcCurrentIndex + (i - 3);
         if (lineIdx < 0 || lineIdx >= (int)st.lrcLines.size()) continue;
         auto txt = tvg::Text::gen();
-        txt->text(st.lrcLines[lineIdx].text.c_str());
+        txt->text(lrcText(st.lrcLines, lineIdx));
         txt->font(fontName);
         txt->translate(lrcX + lrcW / 2.0f, startY + i * lineH + lineH / 2.0f - 4.0f);
         txt->align(0.5f, 0.5f);
@@ -1381,6 +1380,8 @@ static void ma_data_callback(ma_device* pDevice, void* pOutput, const void* /*pI
     if (got < needed) {
         memset(out + got, 0, (needed - got) * sizeof(float));
     }
+    // 均衡器(无锁、不分配)；放在频谱采集之前，可视化与听到的一致
+    st->equalizer.process(out, frameCount);
     if (st->avRingBuf && st->avRingBuf->cap > 0 && got > 0) {
         ma_uint32 gotFrames = (ma_uint32)(got / st->AUDIO_CHANNELS);
         if (gotFrames > 0) {
@@ -1447,69 +1448,38 @@ static void scanMediaFiles(std::vector<std::string>& files, const std::vector<st
 }
 
 /*==================== parseLRC, parsePlainLyrics, loadLyrics ====================*/
-static bool parseLRC(const char* lrcPath, std::vector<LrcLine>& lines) {
-    FILE* f = nullptr;
-    fopen_s(&f, lrcPath, "rb");
-    if (!f) return false;
-
-    lines.clear();
-    char buf[1024];
-    while (fgets(buf, sizeof(buf), f)) {
-        if (buf[0] == '\0' || buf[0] == '\n' || buf[0] == '\r') continue;
-
-        char* p = buf;
-        std::vector<double> timestamps;
-        while (*p == '[') {
-            int min = 0, sec_int = 0, frac = 0;
-            if (sscanf_s(p, "[%d:%d.%d]", &min, &sec_int, &frac) == 3) {
-                double sec = sec_int;
-                if (frac < 100)      sec += frac / 100.0;
-                else                 sec += frac / 1000.0;
-                timestamps.push_back(min * 60.0 + sec);
-            }
-            char* close = strchr(p, ']');
-            if (!close) break;
-            p = close + 1;
-        }
-
-        while (*p == ' ' || *p == '\t') p++;
-        size_t len = strlen(p);
-        while (len > 0 && (p[len - 1] == '\n' || p[len - 1] == '\r')) p[--len] = '\0';
-
-        std::string text(p);
-        if (text.empty()) text = "\xe2\x99\xaa";
-
-        for (double ts : timestamps) {
-            lines.push_back({ts, text});
-        }
-    }
-    fclose(f);
-
-    std::sort(lines.begin(), lines.end(),
-        [](const LrcLine& a, const LrcLine& b) { return a.timestamp < b.timestamp; });
+static bool parseLRC(const char* lrcPath, mlrc::Document& doc) {
+    bool ok = doc.loadFile(lrcPath);
+    OX_LOG("[Lyrics] Parsed %zu lines from %s\n", doc.size(), lrcPath);
+    return ok;
+}
 
-    OX_LOG("[Lyrics] Parsed %zu lines from %s\n", lines.size(), lrcPath);
-    return !lines.empty();
+// 直接解析内存中的 LRC 文本(内嵌歌词)，不经过临时文件
+static bool parseLRCText(std::string_view text, mlrc::Document& doc) {
+    return doc.parse(text);
 }
 
-static void parsePlainLyrics(const std::string& text, std::vector<LrcLine>& lines, double duration) {
-    lines.clear();
+static void parsePlainLyrics(std::string_view text, mlrc::Document& doc, double duration) {
+    doc.clear();
     if (text.empty()) return;
 
-    std::istringstream iss(text);
-    std::vector<std::string> rawLines;
-    std::string line;
-    while (std::getline(iss, line)) {
-        while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) line.pop_back();
+    std::vector<std::string_view> rawLines;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t end = text.find('\n', pos);
+        if (end == std::string_view::npos) end = text.size();
+        std::string_view line = text.substr(pos, end - pos);
+        while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) line.remove_suffix(1);
         if (!line.empty()) rawLines.push_back(line);
+        pos = end + 1;
     }
     if (rawLines.empty()) return;
 
     double interval = duration / (double)(rawLines.size() + 1);
     for (size_t i = 0; i < rawLines.size(); i++) {
-        lines.push_back({interval * (i + 1), rawLines[i]});
+        doc.addLine((float)(interval * (i + 1)), rawLines[i]);
     }
-    OX_LOG("[Lyrics] Parsed %zu plain text lines, interval=%.1fs\n", lines.size(), interval);
+    OX_LOG("[Lyrics] Parsed %zu plain text lines, interval=%.1fs\n", doc.size(), interval);
 }
 
 static void loadLyrics(AppState& st) {
@@ -1521,17 +1491,9 @@ static void loadLyrics(AppState& st) {
         OX_LOG("[Lyrics] Embedded lyrics: %zu bytes\n", embedded.size());
         if (embedded.find("[") != std::string::npos &&
             embedded.find(":") != std::string::npos) {
-            std::string tmpPath = "e:/MX/Data/_lrc_temp.lrc";
-            std::ofstream ofs(tmpPath, std::ios::binary);
-            if (ofs) {
-                ofs << embedded;
-                ofs.close();
-                if (parseLRC(tmpPath.c_str(), st.lrcLines)) {
-                    OX_LOG("[Lyrics] Parsed embedded LRC lyrics: %zu lines\n", st.lrcLines.size());
-                    std::remove(tmpPath.c_str());
-                    return;
-                }
-                std::remove(tmpPath.c_str());
+            if (parseLRCText(embedded, st.lrcLines)) {
+                OX_LOG("[Lyrics] Parsed embedded LRC lyrics: %zu lines\n", st.lrcLines.size());
+                return;
             }
         }
         double dur = st.decoder.getDuration();
@@ -2039,6 +2001,17 @@ static void applyConfig(AppState& st) {
             }
         }
 
+        // ---- player.equalizer (enable / preset) ----
+        if (cfg.contains("player") && cfg["player"].contains("equalizer")) {
+            const auto& eq = cfg["player"]["equalizer"];
+            st.equalizer.setEnabled(eq.value("enable", false));
+            std::string preset = eq.value("preset", std::string("flat"));
+            if (!st.equalizer.applyPreset(preset.c_str())) {
+                OX_LOG("[Config] unknown equalizer preset: %s\n", preset.c_str());
+            }
+            OX_LOG("[Config] equalizer %s, preset %s\n", st.equalizer.isEnabled() ? "on" : "off", preset.c_str());
+        }
+
         loadPlaylists(st);
 
         if (cfg.contains("lastPlayed")) {
@@ -2243,6 +2216,7 @@ void main() { fragColor = texture(lyricsTex, vUV); }
     aConfig.sampleRate        = st.AUDIO_SAMPLE_RATE;
     aConfig.dataCallback      = ma_data_callback;
     aConfig.pUserData         = &st;
+    st.equalizer.init(st.AUDIO_SAMPLE_RATE, st.AUDIO_CHANNELS, 10);
     if (ma_device_init(nullptr, &aConfig, &st.audioDevice) != MA_SUCCESS) {
         OX_LOG("[MAIN] miniaudio device init failed\n");
         cleanup(st); st.app.destroy(); timeEndPeriod(1); return 1;
@@ -14,19 +14,41 @@
  *
  * 主要功能（此处列出当前实现的要点）:
  *   - 基于 ThorVG(GlCanvas) + OpenGL 的 2D 矢量即时渲染。
- *   - 简单 3D 渲染器 (Renderer3D) 用于示例/混合渲染。
+ *   - 可选图层缓存 (UIElement::setCacheAsLayer)：静态子树光栅化到离屏位图后每帧只做合成。
+ *   - 可选帧剖析 (Application::setProfiling / setProfilerOverlay)：输入延迟、各阶段耗时的 p50/p95/p99，
+ *     无锁事件环可导出 Chrome trace JSON (FrameProfiler::exportChromeTrace)。
+ *   - 可选渲染线程 (Application::setThreadedRendering)：UI 线程构建场景快照，渲染线程光栅化并交换缓冲。
+ *   - 分层时间轮 (TimerWheel) 统一派发定时器，Application::setIdleWait 可让主循环空闲时阻塞。
+ *   - UITextInput 批量插入/替换 (insertText / replaceRange / UIManager::handleText) 与增量重排。
+ *   - 程序化纹理缓存 (TextureCache)：光晕等生成位图按参数缓存，每帧只复用 Picture 并设置变换。
+ *   - 帧内单调分配器 (FrameArena)：渲染路径的临时字符串/数组按帧复位，稳定后不再触发堆分配。
+ *   - 同样式矩形/线段合批 (ShapeBatch)，UIManager::getFrameStats() 报告每帧耗时与(可选的) Paint 数。
+ *   - 简单 3D 渲染器 (Renderer3D) 用于示例/混合渲染；beginInstances/commitInstances 支持
+ *     数千个立方体实例一次实例化绘制(频谱可视化等)，uniform 位置在链接时缓存。
  *   - 丰富的 UI 组件集合：UIManager, UIElement, UIButton, UILabel,
  *     UITextInput, UISlider, UIProgressBar, UITooltip, UIFrame 等。
  *   - 两种列表控件：ListPanel（通用列表）与 PlayList（支持封面缩略图、缓存、交互）。
  *   - CoverImage：大封面显示 + 全局 LRU 缓存机制，支持从磁盘以宽字符路径读取图片。
- *   - LyricView：LRC 解析、时间驱动滚动与卡拉 OK 高亮效果。
+ *   - LyricView：LRC / 增强 LRC 解析 (mlrc.h)、时间驱动滚动与卡拉 OK 高亮效果；
+ *     每行预光栅化为位图缓存，滚动/衰减/擦除只做合成。
+ *   - SongLibrary：不可变、引用计数的歌曲库快照(写时复制)，MPlayer 与 PlayList 共享同一实例，
+ *     扫描完成后经 SongLibrarySource 原子发布新版本。
  *   - MPlayer：基于 miniaudio 的播放封装，支持宽字符路径播放、播放控制、音量、
- *     随机顺序生成等。
+ *     随机顺序生成等；下一首后台预打开并在引擎内按采样帧无缝衔接(可选交叉淡化)。
+ *     引擎图中接入参数均衡器节点(meq.h，10/31 段，SSE2，无锁调参)，getEqualizer() 调整频段/预设。
+ *     PlaybackClock 由音频线程经序列锁发布 (采样帧, 时间戳)，getPlaybackPosition 无锁插值出平滑单调的位置。
+ *   - 内存映射 VFS (mvfs.h)：miniaudio 读取本地文件不再逐块 read/跳转重读，网络路径改用自适应预读窗口；
+ *     MPlayer::getIoStats 报告系统调用与读取字节数。
+ *   - 响度均衡 (mloud.h)：后台线程池按 EBU R128 分析积分响度/真峰值，结果按文件身份缓存，
+ *     MPlayer 开始播放时按 ReplayGain 增益设置一次音量 (setVolumeNormalization)。
+ *   - PlayQueue：播放顺序(顺序/随机)、"接下来播放"与有界历史，上一首/下一首/入队/删除/移动均为 O(1)，
+ *     歌曲库增删后保留原有随机顺序(MPlayer::enqueueSong / playNextSong / getQueue)。
  *   - 使用 TagLib 提取音频元数据与嵌入封面（extractCover、getSongInfo、scanMusic）。
  *   - 图片加载使用 stb_image/stb_image_write（支持从宽路径读取文件流以避免路径编码问题）。
  *   - UTF-8/UTF-16 工具（wideToUtf8 / utf8ToWide）与 UTF-8 字符处理辅助函数。
  *   - 封面提取、默认封面生成、封面缓存（thumbnailCache / coverCache）与预加载逻辑。
- *   - 从 RCDATA 加载字体到 ThorVG（tvg::Text::load 支持内存字体）。
+ *   - 从 RCDATA 原地引用字体 / 从磁盘内存映射加载字体（均不复制到堆），
+ *     Application::prewarmGlyphs 在主循环空隙中分块预构建字形轮廓。
  *   - 日志输出封装 ODD（默认为 wprintf），并在代码中注意了 UTF-8 -> 宽字符转换以避免乱码。
  *
  * 设计与实现注意事项:
@@ -47,6 +69,7 @@
  *   - miniaudio (静态)
  *   - TagLib (静态)
  *   - stb_image / stb_image_write
+ *   - mlrc.h (同目录，歌词解析)
  *
  * 环境:
  *   - Windows 10/11 x64, Visual Studio 2022, C++17, Unicode (UTF-16) 字符集
@@ -68,9 +91,13 @@
 #include <windowsx.h>      // Win32 帮助宏: GET_X_LPARAM/GET_Y_LPARAM 等消息参数辅助宏
 #include <set>             // std::set 容器（用于有序集合）
 #include <thread>          // std::thread, std::this_thread, std::thread::hardware_concurrency
+#include <mutex>           // std::mutex / std::lock_guard（渲染线程帧交接）
+#include <atomic>          // std::atomic（跨线程统计与标志）
+#include <condition_variable> // std::condition_variable（渲染线程等待新帧）
 #include <string>          // std::string / std::wstring 字符串类型与操作
 #include <cwchar>          // 宽字符 C API：std::wprintf, swprintf_s, _wfopen 等
 #include <vector>          // std::vector 动态数组容器
+#include <deque>           // std::deque 双端队列（TimerWheel 节点池，扩容不移动已有元素）
 #include <random>          // 随机数：std::random_device, std::mt19937, std::shuffle
 #include <chrono>          // 时间/计时：std::chrono::steady_clock, duration, Sleep 时间计算
 #include <memory>          // 智能指针：std::unique_ptr, std::shared_ptr
@@ -81,6 +108,10 @@
 #include <filesystem>      // 文件系统操作：std::filesystem::path, directory_iterator, exists, create_directories
 #include <functional>      // std::function 回调包装
 #include <unordered_map>   // 哈希表容器（如需快速映射时可用）
+#include <memory_resource> // std::pmr::monotonic_buffer_resource / pmr 容器（FrameArena 帧内临时分配）
+#include <optional>        // std::optional（FrameArena 重建单调资源）
+#include <cstring>         // std::memcpy（PlaybackClock 序列锁按字复制记录）
+#include <type_traits>     // std::is_trivially_copyable
 
 
 #include "resource.h"  
@@ -89,12 +120,17 @@
 #define TVG_STATIC  
 #include <thorvg/thorvg.h>  
 
+#include "mlrc.h"          // LRC / 增强 LRC 歌词解析
+#include "meq.h"           // 参数均衡器(MPlayer 引擎图中的 ma_node)
+
 #include <glm/glm.hpp>  
 #include <glm/gtc/matrix_transform.hpp>  
 #include <glm/gtc/type_ptr.hpp>
 
  // miniaudio静态库
  #include "miniaudio.h" 
+ #include "mloud.h"     // 响度分析(EBU R128 / ReplayGain)，依赖 miniaudio
+ #include "mvfs.h"      // 内存映射 VFS，引擎与响度分析的所有文件读取都经过它
  // TagLib 静态库  
  #define TAGLIB_STATIC    
  #include "tag.h"    
@@ -227,6 +263,19 @@ namespace MUI {
         return result;
     }
 
+    // UTF-16 转 UTF-8，结果从指定内存资源分配(渲染路径传 FrameArena::get() 避免堆分配)
+    std::pmr::string wideToUtf8(const std::wstring& wstr, std::pmr::memory_resource* mr) {
+        std::pmr::string result(mr);
+        if (wstr.empty()) return result;
+
+        int size_needed = WideCharToMultiByte(CP_UTF8, 0, wstr.c_str(),
+            (int)wstr.length(), NULL, 0, NULL, NULL);
+        result.resize(size_needed);
+        WideCharToMultiByte(CP_UTF8, 0, wstr.c_str(), (int)wstr.length(),
+            &result[0], size_needed, NULL, NULL);
+        return result;
+    }
+
     // 从文件加载图片到 OBitmap  
     OBitmap loadImageToBitmap(const std::wstring& filePath) {
         ODD(L"开始加载图片: %ls\n", filePath.c_str());
@@ -342,6 +391,29 @@ namespace MUI {
             }
             return byteOffset;
         }
+
+        // 解码一个 UTF-8 字符为码点(无效序列按单字节返回)  
+        inline uint32_t decode(const char* str) {
+            const unsigned char* p = reinterpret_cast<const unsigned char*>(str);
+            size_t len = charLength(str);
+            if (len == 1) return p[0];
+            uint32_t cp = p[0] & (0xFF >> (len + 1));
+            for (size_t i = 1; i < len; ++i) {
+                if ((p[i] & 0xC0) != 0x80) return p[0];
+                cp = (cp << 6) | (p[i] & 0x3F);
+            }
+            return cp;
+        }
+
+        // 生成字符→字节偏移表: out 依次追加每个字符的起始字节(加上 base)
+        // 调用方可在末尾再追加总长度作为哨兵，使 out[i+1]-out[i] 即第 i 个字符的字节长度
+        inline void appendCharOffsets(const std::string& str, size_t base, std::vector<size_t>& out) {
+            size_t i = 0;
+            while (i < str.size()) {
+                out.push_back(base + i);
+                i += std::min(charLength(str.c_str() + i), str.size() - i);
+            }
+        }
     }
 
 
@@ -349,6 +421,287 @@ namespace MUI {
 
 // 定时器类
 namespace MUI {
+
+    // 分层时间轮: 3 级 × 64 槽，1 tick = 1ms，精确覆盖约 262 秒，更远的定时器在最高级循环等待。
+    // 插入/取消 O(1)，派发按 tick 推进并在低级槽回绕时逐级下放(均摊 O(1))。
+    // Application 持有一个实例并在主循环中推进；msUntilNext() 给出下一个到期时间，
+    // 主循环据此阻塞等待而不必空转。
+    class TimerWheel {
+    public:
+        using TimerId = uint64_t;                 // 高 32 位为代数，低 32 位为槽位索引 + 1
+        static constexpr TimerId InvalidTimer = 0;
+        static constexpr uint32_t NoDeadline = 0xFFFFFFFFu;
+
+        TimerWheel() {
+            for (auto& level : slots) {
+                for (auto& head : level) head = -1;
+            }
+            start = std::chrono::steady_clock::now();
+        }
+
+        TimerWheel(const TimerWheel&) = delete;
+        TimerWheel& operator=(const TimerWheel&) = delete;
+
+        // 注册定时器: delaySeconds 后触发，repeatSeconds > 0 时按该周期重复
+        TimerId schedule(float delaySeconds, std::function<void()> cb, float repeatSeconds = 0.0f) {
+            syncTick();
+
+            int32_t idx;
+            if (!freeList.empty()) {
+                idx = freeList.back();
+                freeList.pop_back();
+            }
+            else {
+                idx = static_cast<int32_t>(nodes.size());
+                nodes.emplace_back();
+            }
+
+            Node& n = nodes[idx];
+            n.callback = std::move(cb);
+            n.interval = repeatSeconds > 0.0f ? std::max<uint64_t>(1, toTicks(repeatSeconds)) : 0;
+            n.expires = currentTick + std::max<uint64_t>(1, toTicks(delaySeconds));
+            n.active = true;
+            link(idx, false);
+            ++activeCount;
+
+            return (static_cast<TimerId>(n.generation) << 32) | static_cast<uint32_t>(idx + 1);
+        }
+
+        TimerId every(float intervalSeconds, std::function<void()> cb) {
+            return schedule(intervalSeconds, std::move(cb), intervalSeconds);
+        }
+
+        bool cancel(TimerId id) {
+            int32_t idx = resolve(id);
+            if (idx < 0) return false;
+
+            unlink(idx);
+            nodes[idx].active = false;
+            --activeCount;
+            if (idx != firing) release(idx);   // 正在派发的节点在回调返回后再回收
+            return true;
+        }
+
+        // 从当前时刻重新计时(仅对周期定时器有效，如输入时重置光标闪烁)
+        bool restart(TimerId id) {
+            int32_t idx = resolve(id);
+            if (idx < 0 || nodes[idx].interval == 0) return false;
+
+            syncTick();
+            unlink(idx);
+            nodes[idx].expires = currentTick + nodes[idx].interval;
+            link(idx, false);
+            return true;
+        }
+
+        bool isActive(TimerId id) const { return resolve(id) >= 0; }
+        size_t size() const { return activeCount; }
+
+        // 推进到当前时刻并派发所有到期定时器
+        void advance() {
+            uint64_t target = nowTick();
+            if (activeCount == 0) {
+                currentTick = std::max(currentTick, target);
+                return;
+            }
+
+            while (currentTick < target) {
+                ++currentTick;
+                uint64_t t = currentTick;
+
+                // 低级槽回绕时，把上一级对应槽的定时器下放
+                if ((t & SLOT_MASK) == 0) {
+                    if (((t >> SLOT_BITS) & SLOT_MASK) == 0) {
+                        cascade(2, static_cast<int>((t >> (2 * SLOT_BITS)) & SLOT_MASK));
+                    }
+                    cascade(1, static_cast<int>((t >> SLOT_BITS) & SLOT_MASK));
+                }
+
+                dispatch(static_cast<int>(t & SLOT_MASK));
+                if (activeCount == 0) {
+                    currentTick = target;
+                    break;
+                }
+            }
+        }
+
+        // 距下一个到期定时器的毫秒数；没有定时器时返回 NoDeadline
+        uint32_t msUntilNext() const {
+            if (activeCount == 0) return NoDeadline;
+
+            uint64_t earliest = UINT64_MAX;
+
+            // 0 级槽内的定时器都在 64 tick 内到期，找到第一个非空槽即可
+            for (uint64_t k = 1; k <= SLOT_COUNT; ++k) {
+                if (slots[0][(currentTick + k) & SLOT_MASK] >= 0) {
+                    earliest = currentTick + k;
+                    break;
+                }
+            }
+
+            // 高级槽中的定时器数量通常很少，直接取最小到期时间
+            for (int level = 1; level < LEVELS; ++level) {
+                for (int32_t head : slots[level]) {
+                    for (int32_t i = head; i >= 0; i = nodes[i].next) {
+                        earliest = std::min(earliest, nodes[i].expires);
+                    }
+                }
+            }
+
+            uint64_t now = nowTick();
+            if (earliest <= now) return 0;
+            return static_cast<uint32_t>(std::min<uint64_t>(earliest - now, NoDeadline - 1));
+        }
+
+        // 动画时钟: 存在活动动画时主循环按帧运行，不进入阻塞等待
+        void beginAnimation() { ++animations; }
+        void endAnimation() { if (animations > 0) --animations; }
+        bool isAnimating() const { return animations > 0; }
+
+        // 默认时间轮(由 Application 设置)，Timer 启动时自动注册到此
+        static TimerWheel* getDefault() { return defaultWheel; }
+        static void setDefault(TimerWheel* wheel) { defaultWheel = wheel; }
+
+    private:
+        static constexpr int LEVELS = 3;
+        static constexpr int SLOT_BITS = 6;
+        static constexpr uint64_t SLOT_COUNT = 1u << SLOT_BITS;
+        static constexpr uint64_t SLOT_MASK = SLOT_COUNT - 1;
+
+        struct Node {
+            uint64_t expires = 0;
+            uint64_t interval = 0;                // 0 表示单次
+            std::function<void()> callback;
+            uint32_t generation = 0;
+            int32_t prev = -1;
+            int32_t next = -1;
+            int8_t level = -1;
+            uint8_t slot = 0;
+            bool active = false;
+        };
+
+        std::deque<Node> nodes;                   // deque 保证回调中新增定时器时引用不失效
+        std::vector<int32_t> freeList;
+        int32_t slots[LEVELS][SLOT_COUNT];        // 各槽双向链表表头
+        uint64_t currentTick = 0;                 // 已处理到的 tick
+        size_t activeCount = 0;
+        int32_t firing = -1;
+        int animations = 0;
+        std::chrono::steady_clock::time_point start;
+
+        static inline TimerWheel* defaultWheel = nullptr;
+
+        static uint64_t toTicks(float seconds) {
+            return seconds > 0.0f ? static_cast<uint64_t>(seconds * 1000.0f + 0.5f) : 0;
+        }
+
+        uint64_t nowTick() const {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start).count());
+        }
+
+        // 长时间未推进(例如主循环阻塞)后注册新定时器前先追上时间，保证延迟从"现在"算起
+        void syncTick() {
+            if (activeCount == 0 && firing < 0) currentTick = std::max(currentTick, nowTick());
+        }
+
+        int32_t resolve(TimerId id) const {
+            uint32_t low = static_cast<uint32_t>(id & 0xFFFFFFFFu);
+            if (low == 0 || low > nodes.size()) return -1;
+            int32_t idx = static_cast<int32_t>(low - 1);
+            const Node& n = nodes[idx];
+            if (!n.active || n.generation != static_cast<uint32_t>(id >> 32)) return -1;
+            return idx;
+        }
+
+        // cascading: 下放过程中允许放入当前 tick 的槽(随后立即派发)
+        void link(int32_t idx, bool cascading) {
+            Node& n = nodes[idx];
+            uint64_t minExpire = cascading ? currentTick : currentTick + 1;
+            if (n.expires < minExpire) n.expires = minExpire;
+
+            uint64_t delta = n.expires - currentTick;
+            int level;
+            uint64_t slot;
+            if (delta < SLOT_COUNT) {
+                level = 0;
+                slot = n.expires & SLOT_MASK;
+            }
+            else if (delta < (SLOT_COUNT << SLOT_BITS)) {
+                level = 1;
+                slot = (n.expires >> SLOT_BITS) & SLOT_MASK;
+            }
+            else if (delta < (SLOT_COUNT << (2 * SLOT_BITS))) {
+                level = 2;
+                slot = (n.expires >> (2 * SLOT_BITS)) & SLOT_MASK;
+            }
+            else {
+                // 超出范围: 放到最高级中最晚下放的槽，下放时再按剩余时间重新定位
+                level = 2;
+                slot = ((currentTick >> (2 * SLOT_BITS)) - 1) & SLOT_MASK;
+            }
+
+            n.level = static_cast<int8_t>(level);
+            n.slot = static_cast<uint8_t>(slot);
+            n.prev = -1;
+            n.next = slots[level][slot];
+            if (n.next >= 0) nodes[n.next].prev = idx;
+            slots[level][slot] = idx;
+        }
+
+        void unlink(int32_t idx) {
+            Node& n = nodes[idx];
+            if (n.level < 0) return;
+            if (n.prev >= 0) nodes[n.prev].next = n.next;
+            else slots[n.level][n.slot] = n.next;
+            if (n.next >= 0) nodes[n.next].prev = n.prev;
+            n.prev = n.next = -1;
+            n.level = -1;
+        }
+
+        void release(int32_t idx) {
+            Node& n = nodes[idx];
+            n.callback = nullptr;
+            ++n.generation;
+            freeList.push_back(idx);
+        }
+
+        void cascade(int level, int slot) {
+            int32_t idx = slots[level][slot];
+            slots[level][slot] = -1;
+            while (idx >= 0) {
+                int32_t next = nodes[idx].next;
+                nodes[idx].level = -1;
+                link(idx, true);
+                idx = next;
+            }
+        }
+
+        void dispatch(int slot) {
+            int32_t idx;
+            while ((idx = slots[0][slot]) >= 0) {
+                unlink(idx);
+                Node& n = nodes[idx];
+
+                if (n.interval > 0) {
+                    // 周期定时器先重新挂回，回调中 cancel/restart 均可正常生效
+                    n.expires = std::max(n.expires + n.interval, currentTick + 1);
+                    link(idx, false);
+                }
+                else {
+                    n.active = false;
+                    --activeCount;
+                }
+
+                firing = idx;
+                if (n.callback) n.callback();
+                firing = -1;
+
+                if (!n.active) release(idx);
+            }
+        }
+    };
+
     class Timer {
     private:
         std::chrono::steady_clock::time_point lastTime;
@@ -357,14 +710,30 @@ namespace MUI {
         bool running;
         std::function<void()> callback;
 
+        // 启动时若存在默认时间轮则注册到时间轮，由主循环统一派发，update() 不再轮询
+        TimerWheel* wheel = nullptr;
+        TimerWheel::TimerId wheelId = TimerWheel::InvalidTimer;
+
+        void detach() {
+            if (wheel) wheel->cancel(wheelId);
+            wheel = nullptr;
+            wheelId = TimerWheel::InvalidTimer;
+        }
+
     public:
         Timer(float intervalSeconds = 0.5f)
             : interval(intervalSeconds), elapsed(0.0f), running(false) {
             lastTime = std::chrono::steady_clock::now();
         }
 
+        ~Timer() { detach(); }
+
+        Timer(const Timer&) = delete;
+        Timer& operator=(const Timer&) = delete;
+
         void setInterval(float seconds) {
             interval = seconds;
+            if (running && wheel) start();
         }
 
         void setCallback(std::function<void()> cb) {
@@ -372,22 +741,30 @@ namespace MUI {
         }
 
         void start() {
+            detach();
             running = true;
             elapsed = 0.0f;
             lastTime = std::chrono::steady_clock::now();
+
+            wheel = TimerWheel::getDefault();
+            if (wheel) {
+                wheelId = wheel->every(interval, [this]() { if (callback) callback(); });
+            }
         }
 
         void stop() {
             running = false;
+            detach();
         }
 
         void reset() {
             elapsed = 0.0f;
             lastTime = std::chrono::steady_clock::now();
+            if (wheel) wheel->restart(wheelId);
         }
 
         void update(float deltaTime) {
-            if (!running) return;
+            if (!running || wheel) return;
 
             elapsed += deltaTime;
             if (elapsed >= interval) {
@@ -419,6 +796,184 @@ namespace MUI {
         size_t coverCount() const { return coverPaths.size(); }
     };
 
+    inline bool operator==(const Song& a, const Song& b) {
+        return a.filePath == b.filePath && a.title == b.title && a.artist == b.artist &&
+            a.album == b.album && a.duration == b.duration && a.bitrate == b.bitrate &&
+            a.year == b.year && a.track == b.track && a.coverPaths == b.coverPaths &&
+            a.embeddedCoverCount == b.embeddedCoverCount;
+    }
+    inline bool operator!=(const Song& a, const Song& b) { return !(a == b); }
+
+    // 不可变歌曲库快照: 播放器、播放列表等视图共享同一实例(shared_ptr<const>)，
+    // 更新时生成新版本(写时复制)。每首歌单独引用计数，新版本只复制变化/新增的歌曲，
+    // 未变化的条目与旧版本共享，旧版本在最后一个持有者释放后销毁。
+    class SongLibrary : public std::enable_shared_from_this<SongLibrary> {
+    public:
+        using Ptr = std::shared_ptr<const SongLibrary>;
+        using Entry = std::shared_ptr<const Song>;
+
+        static Ptr makeEmpty() {
+            static const Ptr emptyLib = std::make_shared<const SongLibrary>(std::vector<Entry>());
+            return emptyLib;
+        }
+
+        static Ptr create(std::vector<Song> songs) {
+            std::vector<Entry> entries;
+            entries.reserve(songs.size());
+            for (auto& song : songs) entries.push_back(std::make_shared<const Song>(std::move(song)));
+            return std::make_shared<const SongLibrary>(std::move(entries));
+        }
+
+        explicit SongLibrary(std::vector<Entry> e) : entries(std::move(e)), version(nextVersion()) {}
+    private:
+        // 路径 -> 槽位。键是路径副本而非引用条目，共享索引的后继版本不会让旧版本的条目延寿
+        using PathIndex = std::unordered_map<std::wstring, uint32_t>;
+        using IndexPtr = std::shared_ptr<const PathIndex>;
+    public:
+        // 槽位布局与索引所属版本相同(仅替换了同路径条目)时共享该索引，不再重建
+        SongLibrary(std::vector<Entry> e, IndexPtr sharedIndex)
+            : entries(std::move(e)), version(nextVersion()), index(std::move(sharedIndex)) {}
+
+        size_t size() const { return entries.size(); }
+        bool empty() const { return entries.empty(); }
+        const Song& operator[](size_t i) const { return *entries[i]; }
+        const Entry& entry(size_t i) const { return entries[i]; }
+        uint64_t getVersion() const { return version; }
+
+        int32_t indexOf(const std::wstring& filePath) const {
+            const PathIndex& index = pathIndex();
+            auto it = index.find(filePath);
+            return it != index.end() ? static_cast<int32_t>(it->second) : -1;
+        }
+
+        // 按扫描结果生成新版本: 内容未变化的歌曲沿用旧条目，只为变化/新增的歌曲分配新条目。
+        // 完全一致时返回自身，调用者可据版本号判断是否需要刷新。
+        Ptr merge(std::vector<Song> scanned) const {
+            const PathIndex& index = pathIndex();
+            std::vector<Entry> next;
+            next.reserve(scanned.size());
+            bool sameLayout = scanned.size() == entries.size();
+            bool changed = !sameLayout;
+            for (size_t i = 0; i < scanned.size(); ++i) {
+                auto it = index.find(scanned[i].filePath);
+                if (it != index.end() && sameContent(*entries[it->second], scanned[i])) {
+                    next.push_back(entries[it->second]);
+                    changed = changed || it->second != i;
+                }
+                else {
+                    next.push_back(std::make_shared<const Song>(std::move(scanned[i])));
+                    changed = true;
+                }
+                sameLayout = sameLayout && it != index.end() && it->second == i;
+            }
+            if (!changed) return shared_from_this();
+            if (sameLayout) return std::make_shared<const SongLibrary>(std::move(next), sharedIndex());
+            return std::make_shared<const SongLibrary>(std::move(next));
+        }
+
+        // 增量修改: upserts 按 filePath 替换已有歌曲或追加到末尾，removals 按 filePath 删除。
+        // 查找只走路径索引(O(变化数))；只有替换时新版本共享同一索引，有增删时新版本在首次查询时重建。
+        Ptr withChanges(std::vector<Song> upserts, const std::vector<std::wstring>& removals = {}) const {
+            const PathIndex& index = pathIndex();
+            std::vector<Entry> next(entries);
+            size_t removed = 0;
+            for (const auto& path : removals) {
+                auto it = index.find(path);
+                if (it != index.end() && next[it->second]) {
+                    next[it->second].reset();
+                    ++removed;
+                }
+            }
+
+            // 本批追加的歌曲，同一路径重复 upsert 时替换而不重复追加(键引用 next 中条目的路径)
+            std::unordered_map<std::wstring_view, uint32_t> appended;
+            for (auto& song : upserts) {
+                auto entry = std::make_shared<const Song>(std::move(song));
+                auto it = index.find(entry->filePath);
+                if (it != index.end() && next[it->second]) {
+                    next[it->second] = std::move(entry);
+                    continue;
+                }
+                uint32_t slot = static_cast<uint32_t>(next.size());
+                auto a = appended.find(entry->filePath);
+                if (a != appended.end()) {
+                    slot = a->second;
+                    appended.erase(a);      // 键引用被替换条目的路径，随条目一起更新
+                    next[slot] = std::move(entry);
+                }
+                else {
+                    next.push_back(std::move(entry));
+                }
+                appended.emplace(next[slot]->filePath, slot);
+            }
+
+            if (removed) next.erase(std::remove(next.begin(), next.end(), nullptr), next.end());
+            if (removed == 0 && appended.empty()) return std::make_shared<const SongLibrary>(std::move(next), sharedIndex());
+            return std::make_shared<const SongLibrary>(std::move(next));
+        }
+
+        // 按 const Song& 遍历
+        class const_iterator {
+        public:
+            explicit const_iterator(std::vector<Entry>::const_iterator i) : it(i) {}
+            const Song& operator*() const { return **it; }
+            const Song* operator->() const { return it->get(); }
+            const_iterator& operator++() { ++it; return *this; }
+            bool operator==(const const_iterator& o) const { return it == o.it; }
+            bool operator!=(const const_iterator& o) const { return it != o.it; }
+        private:
+            std::vector<Entry>::const_iterator it;
+        };
+        const_iterator begin() const { return const_iterator(entries.begin()); }
+        const_iterator end() const { return const_iterator(entries.end()); }
+
+    private:
+        std::vector<Entry> entries;
+        uint64_t version;
+        mutable IndexPtr index;         // 构造时传入(共享)或首次查询时构建一次
+        mutable std::once_flag indexOnce;
+
+        const PathIndex& pathIndex() const {
+            std::call_once(indexOnce, [this]() {
+                if (index) return;
+                auto built = std::make_shared<PathIndex>();
+                built->reserve(entries.size());
+                for (size_t i = 0; i < entries.size(); ++i) built->emplace(entries[i]->filePath, static_cast<uint32_t>(i));
+                index = std::move(built);
+            });
+            return *index;
+        }
+
+        IndexPtr sharedIndex() const {
+            pathIndex();
+            return index;
+        }
+
+        // 路径已由索引匹配，先比较数值字段再比较字符串
+        static bool sameContent(const Song& a, const Song& b) {
+            return a.duration == b.duration && a.bitrate == b.bitrate && a.year == b.year &&
+                a.track == b.track && a.embeddedCoverCount == b.embeddedCoverCount &&
+                a.title == b.title && a.artist == b.artist && a.album == b.album && a.coverPaths == b.coverPaths;
+        }
+
+        static uint64_t nextVersion() {
+            static std::atomic<uint64_t> counter{ 0 };
+            return ++counter;
+        }
+    };
+
+    // 歌曲库发布点: 扫描线程 publish 新版本，UI 线程各视图 latest() 取最新快照(原子交换)
+    class SongLibrarySource {
+    public:
+        void publish(SongLibrary::Ptr lib) {
+            std::atomic_store(&current, lib ? std::move(lib) : SongLibrary::makeEmpty());
+        }
+        SongLibrary::Ptr latest() const { return std::atomic_load(&current); }
+
+    private:
+        SongLibrary::Ptr current = SongLibrary::makeEmpty();
+    };
+
     
 
     // 提取封面  
@@ -927,146 +1482,792 @@ namespace MUI {
     enum class PlaybackState { Stopped, Playing, Paused };
     enum class PlayMode { Normal, Repeat, Shuffle };
 
-    // 播放器数据  
-    struct PlayerData {
-        PlaybackState state = PlaybackState::Stopped;
-        PlayMode mode = PlayMode::Normal;
-        int32_t currentSongIndex = 0;
-        float currentPosition = 0.0f;
-        float currentDuration = 0.0f;
-        int32_t volume = 80;
-        bool isDraggingProgress = false;
-        std::vector<Song> songLibrary;
-        std::vector<int32_t> shuffleOrder;
-    };
-
-    class MPlayer {
+    // 播放队列: 基础顺序(顺序/随机) + "接下来播放"列表 + 有界播放历史。
+    // 基础顺序同时保存 order 与逆映射 position，上一首/下一首为 O(1)，不再线性查找；
+    // 接下来播放是节点池上的双向链表，入队/插队/删除/移动均为 O(1)，句柄带代数，删除后的旧句柄自动失效；
+    // 历史为固定容量的环形缓冲。歌曲库变化时 remap 保留剩余歌曲的相对顺序，不重新洗牌。
+    class PlayQueue {
     public:
-        MPlayer();
-        ~MPlayer();
-
-        // 基本控制  
-        bool init();
-        void cleanup();
-        void playAudio(const std::wstring& filePath);
-        void pauseAudio();
-        void resumeAudio();
-        void stopAudio();
-        void seekAudio(float position);
-        void updateAudioPosition();
-
-        // 歌曲库管理  
-        void initSongLibrary(const std::wstring& MUSIC_FOLDER = L"E:/xmusic");
-        void preSong();
-        void nextSong();
-        void playSongByIndex(int32_t index);
+        struct Handle {
+            uint32_t slot = UINT32_MAX;
+            uint32_t generation = 0;
+            bool valid() const { return slot != UINT32_MAX; }
+        };
 
-        // 获取器  
-        PlaybackState getPlaybackState() const { return playerData.state; }
-        PlayMode getPlayMode() const { return playerData.mode; }
-        int32_t getCurrentSongIndex() const { return playerData.currentSongIndex; }
-        const std::vector<Song>& getSongLibrary() const  { return playerData.songLibrary; }
-        float getCurrentPosition() const { return playerData.currentPosition; }
-        float getCurrentDuration() const { return playerData.currentDuration; }
-        int32_t getVolume() const { return playerData.volume; }
-        const Song* getCurrentSong() const {
-            if (playerData.currentSongIndex >= 0 &&
-                playerData.currentSongIndex < static_cast<int32_t>(playerData.songLibrary.size())) {
-                return &playerData.songLibrary[playerData.currentSongIndex];
+        // ---- 基础顺序 ----
+        // 顺序 0..count-1，清空接下来播放与历史
+        void reset(int32_t count) {
+            count = std::max(count, 0);
+            order.resize(count);
+            position.resize(count);
+            for (int32_t i = 0; i < count; ++i) order[i] = position[i] = i;
+            shuffled = false;
+            anchor = -1;
+            clearUpNext();
+            clearHistory();
+        }
+
+        // 洗牌(Fisher-Yates)，first 放在首位；接下来播放与历史保持不变
+        void shuffle(int32_t first) {
+            const int32_t n = size();
+            for (int32_t i = 0; i < n; ++i) order[i] = i;
+            int32_t begin = 0;
+            if (first >= 0 && first < n) {
+                std::swap(order[0], order[first]);
+                begin = 1;
             }
-            return nullptr;
+            for (int32_t i = n - 1; i > begin; --i) {
+                std::uniform_int_distribution<int32_t> dist(begin, i);
+                std::swap(order[i], order[dist(rng)]);
+            }
+            rebuildPositions();
+            shuffled = true;
         }
-        void setSongLibrary(const std::vector<Song>& songs);
 
-        // 设置器  
-        void setVolume(float volume) {
-            playerData.volume = static_cast<int32_t>(std::clamp(volume, 0.0f, 100.0f));
-            if (soundInitialized) {
-                ma_sound_set_volume(&currentSound, playerData.volume / 100.0f);
-            }
+        // 恢复顺序 0..n-1，接下来播放与历史保持不变
+        void unshuffle() {
+            for (int32_t i = 0; i < size(); ++i) order[i] = position[i] = i;
+            shuffled = false;
         }
 
-        void setPlayMode(PlayMode mode) {
-            if (playerData.mode != mode) {
-                playerData.mode = mode;
-                if (mode == PlayMode::Shuffle) {
-                    generateShuffleOrder();
+        // 歌曲库变化: oldToNew[i] 为旧索引 i 的新索引(-1 表示已删除)。
+        // 已洗牌时剩余歌曲保持原有相对顺序，新增歌曲插入随机位置；否则恢复为新库的顺序。
+        // 接下来播放与历史中被删除的歌曲一并移除。
+        void remap(const std::vector<int32_t>& oldToNew, int32_t newCount) {
+            auto mapIndex = [&](int32_t i) {
+                return (i >= 0 && i < static_cast<int32_t>(oldToNew.size())) ? oldToNew[i] : -1;
+            };
+
+            // 锚点被删除时，落到基础顺序中其后第一首仍存在的歌曲
+            int32_t newAnchor = -1;
+            if (anchor >= 0 && anchor < size()) {
+                for (int32_t pos = position[anchor]; pos < size() && newAnchor < 0; ++pos) {
+                    newAnchor = mapIndex(order[pos]);
                 }
             }
-        }
 
-        // 检查是否播放结束  
-        bool isPlaybackFinished() const {
-            if (!soundInitialized || playerData.state != PlaybackState::Playing) {
-                return false;
+            if (shuffled) {
+                std::vector<uint8_t> seen(std::max(newCount, 0), 0);
+                std::vector<int32_t> kept;
+                kept.reserve(newCount);
+                for (int32_t song : order) {
+                    int32_t mapped = mapIndex(song);
+                    if (mapped >= 0 && mapped < newCount && !seen[mapped]) {
+                        seen[mapped] = 1;
+                        kept.push_back(mapped);
+                    }
+                }
+                // 新增歌曲: 随机选插入点(排序后与保留序列一次归并，O(n + k log k))
+                std::vector<std::pair<int32_t, int32_t>> added;
+                std::uniform_int_distribution<int32_t> dist(0, static_cast<int32_t>(kept.size()));
+                for (int32_t i = 0; i < newCount; ++i) {
+                    if (!seen[i]) added.emplace_back(dist(rng), i);
+                }
+                std::sort(added.begin(), added.end());
+                order.clear();
+                order.reserve(newCount);
+                size_t a = 0;
+                for (int32_t k = 0; k <= static_cast<int32_t>(kept.size()); ++k) {
+                    while (a < added.size() && added[a].first == k) order.push_back(added[a++].second);
+                    if (k < static_cast<int32_t>(kept.size())) order.push_back(kept[k]);
+                }
+                position.resize(newCount);
+                rebuildPositions();
+            }
+            else {
+                order.resize(std::max(newCount, 0));
+                position.resize(order.size());
+                for (int32_t i = 0; i < size(); ++i) order[i] = position[i] = i;
             }
-            return !ma_sound_is_playing(&currentSound);
+            anchor = newAnchor;
+
+            for (uint32_t slot = upHead; slot != npos;) {
+                uint32_t next = nodes[slot].next;
+                int32_t mapped = mapIndex(nodes[slot].song);
+                if (mapped < 0) unlinkAndFree(slot);
+                else nodes[slot].song = mapped;
+                slot = next;
+            }
+
+            std::vector<int32_t> kept;
+            kept.reserve(historyCount);
+            for (size_t i = 0; i < historyCount; ++i) {
+                int32_t mapped = mapIndex(history[(historyHead + i) % history.size()]);
+                if (mapped >= 0) kept.push_back(mapped);
+            }
+            clearHistory();
+            for (int32_t song : kept) pushHistory(song);
         }
 
-    private:
-        ma_engine engine;
-        ma_sound currentSound;
-        PlayerData playerData;
-        bool engineInitialized = false;
-        bool soundInitialized = false;
+        int32_t size() const { return static_cast<int32_t>(order.size()); }
+        bool isShuffled() const { return shuffled; }
+        int32_t orderAt(int32_t pos) const { return (pos >= 0 && pos < size()) ? order[pos] : -1; }
+        int32_t positionOf(int32_t index) const { return (index >= 0 && index < size()) ? position[index] : -1; }
 
-        void generateShuffleOrder();
-        int32_t getNextSongIndex() const;
-        int32_t getPrevSongIndex() const;
-    };
+        // 基础顺序中的当前位置(从接下来播放中播放的歌曲不改变它)
+        void setAnchor(int32_t index) { anchor = (index >= 0 && index < size()) ? index : -1; }
+        int32_t getAnchor() const { return anchor; }
 
-    // 实现部分  
-    MPlayer::MPlayer() {
-        // 构造函数保持简单  
-    }
+        // ---- 导航 ----
+        // 下一首: 接下来播放优先，其次为基础顺序中锚点之后的歌曲；wrap 为真时末尾回到开头
+        int32_t peekNext(bool wrap) const {
+            if (upHead != npos) return nodes[upHead].song;
+            if (order.empty()) return -1;
+            int32_t pos = (anchor >= 0) ? position[anchor] + 1 : 0;
+            if (pos < size()) return order[pos];
+            return wrap ? order[0] : -1;
+        }
 
-    MPlayer::~MPlayer() {
-        cleanup();
-    }
+        // 上一首: 历史优先，其次为基础顺序中锚点之前的歌曲
+        int32_t peekPrev(bool wrap) const {
+            if (historyCount > 0) return historyBack();
+            if (order.empty() || anchor < 0) return -1;
+            int32_t pos = position[anchor] - 1;
+            if (pos >= 0) return order[pos];
+            return wrap ? order.back() : -1;
+        }
 
-    bool MPlayer::init() {
-        ma_result result = ma_engine_init(NULL, &engine);
-        if (result != MA_SUCCESS) {
-            std::wcout << L"Failed to initialize audio engine" << std::endl;
-            return false;
+        // 从 current 前进到 next: current 记入历史；next 来自接下来播放时出队，否则移动锚点
+        void advanceTo(int32_t current, int32_t next) {
+            if (current >= 0 && current != next) pushHistory(current);
+            if (upHead != npos && nodes[upHead].song == next) unlinkAndFree(upHead);
+            else setAnchor(next);
         }
-        engineInitialized = true;
-        return true;
-    }
 
-    void MPlayer::cleanup() {
-        if (soundInitialized) {
-            ma_sound_uninit(&currentSound);
-            soundInitialized = false;
+        // 后退到 prev: prev 来自历史时出栈，锚点移到 prev
+        void retreatTo(int32_t prev) {
+            if (historyCount > 0 && historyBack() == prev) popHistory();
+            setAnchor(prev);
         }
-        if (engineInitialized) {
-            ma_engine_uninit(&engine);
-            engineInitialized = false;
+
+        // ---- 接下来播放 ----
+        Handle enqueue(int32_t song) { return insertAfter(upTail, song); }     // 追加到末尾
+        Handle playNext(int32_t song) { return insertAfter(npos, song); }      // 插到最前
+
+        bool remove(Handle h) {
+            if (!isLive(h)) return false;
+            unlinkAndFree(h.slot);
+            return true;
         }
-    }
 
-    void MPlayer::playAudio(const std::wstring& filePath) {
-        if (soundInitialized) {
-            ma_sound_stop(&currentSound);
-            ma_sound_uninit(&currentSound);
-            soundInitialized = false;
+        // 把 h 移到 after 之后；after 无效时移到最前
+        bool moveAfter(Handle h, Handle after) {
+            if (!isLive(h)) return false;
+            uint32_t afterSlot = isLive(after) ? after.slot : npos;
+            if (afterSlot == h.slot) return false;
+            unlink(h.slot);
+            link(h.slot, afterSlot);
+            return true;
         }
+        bool moveToFront(Handle h) { return moveAfter(h, Handle()); }
 
-        // 统一路径分隔符为正斜杠  
-        std::wstring normalizedPath = filePath;
-        std::replace(normalizedPath.begin(), normalizedPath.end(), L'\\', L'/');
+        int32_t songOf(Handle h) const { return isLive(h) ? nodes[h.slot].song : -1; }
+        Handle upNextFront() const { return handleOf(upHead); }
+        Handle upNextBack() const { return handleOf(upTail); }
+        Handle upNextAfter(Handle h) const { return isLive(h) ? handleOf(nodes[h.slot].next) : Handle(); }
+        size_t upNextSize() const { return upCount; }
+
+        void clearUpNext() {
+            while (upHead != npos) unlinkAndFree(upHead);
+        }
+
+        template <typename Fn>  // fn(Handle, int32_t song)
+        void forEachUpNext(Fn&& fn) const {
+            for (uint32_t slot = upHead; slot != npos; slot = nodes[slot].next) fn(handleOf(slot), nodes[slot].song);
+        }
+
+        // ---- 播放历史 ----
+        void setHistoryCapacity(size_t capacity) {
+            std::vector<int32_t> kept;
+            for (size_t i = 0; i < historyCount; ++i) kept.push_back(history[(historyHead + i) % history.size()]);
+            history.assign(std::max<size_t>(capacity, 1), -1);
+            clearHistory();
+            for (int32_t song : kept) pushHistory(song);
+        }
+
+        void pushHistory(int32_t song) {
+            size_t tail = (historyHead + historyCount) % history.size();
+            history[tail] = song;
+            if (historyCount < history.size()) ++historyCount;
+            else historyHead = (historyHead + 1) % history.size();     // 满时覆盖最旧的一条
+        }
+
+        int32_t popHistory() {
+            if (historyCount == 0) return -1;
+            int32_t song = historyBack();
+            --historyCount;
+            return song;
+        }
+
+        int32_t historyBack() const {
+            return historyCount ? history[(historyHead + historyCount - 1) % history.size()] : -1;
+        }
+        size_t historySize() const { return historyCount; }
+        void clearHistory() { historyHead = 0; historyCount = 0; }
+
+    private:
+        static constexpr uint32_t npos = UINT32_MAX;
+
+        struct Node {
+            int32_t song = -1;
+            uint32_t prev = npos;
+            uint32_t next = npos;
+            uint32_t generation = 0;
+        };
+
+        std::vector<int32_t> order;         // 位置 -> 歌曲索引
+        std::vector<int32_t> position;      // 歌曲索引 -> 位置
+        bool shuffled = false;
+        int32_t anchor = -1;
+        std::mt19937 rng{ std::random_device{}() };
+
+        std::vector<Node> nodes;
+        uint32_t freeHead = npos;           // 空闲节点经 next 串成单链表
+        uint32_t upHead = npos;
+        uint32_t upTail = npos;
+        size_t upCount = 0;
+
+        std::vector<int32_t> history = std::vector<int32_t>(200, -1);
+        size_t historyHead = 0;
+        size_t historyCount = 0;
+
+        void rebuildPositions() {
+            for (int32_t pos = 0; pos < size(); ++pos) position[order[pos]] = pos;
+        }
+
+        bool isLive(Handle h) const {
+            return h.slot < nodes.size() && nodes[h.slot].generation == h.generation && nodes[h.slot].song >= 0;
+        }
+
+        Handle handleOf(uint32_t slot) const {
+            Handle h;
+            if (slot != npos) { h.slot = slot; h.generation = nodes[slot].generation; }
+            return h;
+        }
+
+        Handle insertAfter(uint32_t afterSlot, int32_t song) {
+            if (song < 0) return Handle();
+            uint32_t slot;
+            if (freeHead != npos) {
+                slot = freeHead;
+                freeHead = nodes[slot].next;
+            }
+            else {
+                slot = static_cast<uint32_t>(nodes.size());
+                nodes.emplace_back();
+            }
+            nodes[slot].song = song;
+            link(slot, afterSlot);
+            return handleOf(slot);
+        }
+
+        // 把 slot 接到 afterSlot 之后(afterSlot 为 npos 时接到最前)
+        void link(uint32_t slot, uint32_t afterSlot) {
+            Node& n = nodes[slot];
+            n.prev = afterSlot;
+            n.next = (afterSlot == npos) ? upHead : nodes[afterSlot].next;
+            if (n.prev != npos) nodes[n.prev].next = slot; else upHead = slot;
+            if (n.next != npos) nodes[n.next].prev = slot; else upTail = slot;
+            ++upCount;
+        }
+
+        void unlink(uint32_t slot) {
+            Node& n = nodes[slot];
+            if (n.prev != npos) nodes[n.prev].next = n.next; else upHead = n.next;
+            if (n.next != npos) nodes[n.next].prev = n.prev; else upTail = n.prev;
+            --upCount;
+        }
+
+        void unlinkAndFree(uint32_t slot) {
+            unlink(slot);
+            Node& n = nodes[slot];
+            n.song = -1;
+            ++n.generation;
+            n.next = freeHead;
+            freeHead = slot;
+        }
+    };
+
+    // 播放时钟: 音频线程每处理一块发布 (引擎采样帧, 稳定时钟时间戳)，
+    // UI 线程在开始/切歌/跳转/暂停时发布曲目映射 (曲目起点的引擎时刻, 文件采样率)。
+    // 两份记录各自只有一个写线程，经序列锁(seqlock)发布；读者不加锁，可在任意线程、任意时刻
+    // 插值出平滑且单调的播放位置(按文件采样率换算，非 48kHz 文件不漂移)。
+    // 回调时刻混出的块要等设备缓冲中已排队的数据播完才被听到，发布时按输出延迟回退引擎帧，
+    // 时钟给出的是此刻正在发声的位置而非正在混音的位置。
+    class PlaybackClock {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        // 设备输出延迟(引擎采样帧): 混音到发声之间的排队数据量，设备启动后设置
+        void setOutputLatency(uint32_t engineFrames) { outputLatency.store(engineFrames, std::memory_order_relaxed); }
+        uint32_t getOutputLatency() const { return outputLatency.load(std::memory_order_relaxed); }
+
+        // 音频线程: 刚处理完引擎时刻 [engineFrame, engineFrame + frameCount) 的一块
+        void publishDevice(uint64_t engineFrame, uint32_t frameCount, uint32_t engineRate) {
+            DeviceStamp d;
+            d.engineFrame = engineFrame;
+            d.latency = outputLatency.load(std::memory_order_relaxed);
+            d.frameCount = frameCount;
+            d.engineRate = engineRate;
+            d.timeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+            device.store(d);
+        }
+
+        // UI 线程: 播放中，曲目第 0 帧对应引擎时刻 origin，从源帧 startFrame 开始
+        void publishPlaying(uint64_t origin, uint64_t startFrame, uint32_t sourceRate, uint32_t engineRate, uint64_t lengthFrames) {
+            track.store(TrackMap{ State::Playing, sourceRate, engineRate, origin, startFrame, lengthFrames });
+        }
+        // UI 线程: 暂停在源帧 frame
+        void publishPaused(uint64_t frame, uint32_t sourceRate, uint64_t lengthFrames) {
+            track.store(TrackMap{ State::Paused, sourceRate, 0, 0, frame, lengthFrames });
+        }
+        void publishStopped() { track.store(TrackMap{}); }
+
+        // 时刻 t 的播放位置(文件采样帧，含小数)
+        double frameAt(Clock::time_point t) const { return frameOf(track.load(), t); }
+
+        // 时刻 t 的播放位置(秒)
+        double positionAt(Clock::time_point t) const {
+            TrackMap tr = track.load();
+            return tr.sourceRate ? frameOf(tr, t) / tr.sourceRate : 0.0;
+        }
+        double position() const { return positionAt(Clock::now()); }
+        uint32_t getSourceRate() const { return track.load().sourceRate; }
+
+    private:
+        enum class State : uint32_t { Stopped, Playing, Paused };
+
+        struct DeviceStamp {
+            uint64_t engineFrame = 0;
+            uint32_t frameCount = 0;
+            uint32_t engineRate = 0;
+            int64_t timeNs = 0;
+            uint32_t latency = 0;       // 此刻发声的是 engineFrame - latency
+        };
+
+        struct TrackMap {
+            State state = State::Stopped;
+            uint32_t sourceRate = 0;
+            uint32_t engineRate = 0;
+            uint64_t origin = 0;
+            uint64_t startFrame = 0;
+            uint64_t lengthFrames = 0;
+        };
+
+        double frameOf(const TrackMap& tr, Clock::time_point t) const {
+            if (tr.state == State::Stopped || tr.sourceRate == 0) return 0.0;
+            if (tr.state == State::Paused) return static_cast<double>(tr.startFrame);
+
+            DeviceStamp d = device.load();
+            if (d.engineRate == 0 || tr.engineRate == 0) return static_cast<double>(tr.startFrame);  // 设备尚未回调
+
+            // 块内按经过时间插值，并限制在块内: 下一块发布的起点不小于本块插值的上限，保证单调
+            int64_t nowNs = std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+            double elapsed = static_cast<double>(nowNs - d.timeNs) * 1e-9 * d.engineRate;
+            elapsed = std::clamp(elapsed, 0.0, static_cast<double>(d.frameCount));
+            double engineNow = static_cast<double>(d.engineFrame) - d.latency + elapsed;   // 可为负(启动之初)
+
+            double frame = (engineNow - static_cast<double>(tr.origin)) * tr.sourceRate / tr.engineRate;
+            frame = std::max(frame, static_cast<double>(tr.startFrame));   // 排定的开始时刻之前停在起点
+            if (tr.lengthFrames > 0) frame = std::min(frame, static_cast<double>(tr.lengthFrames));
+            return frame;
+        }
+
+        // 单写者序列锁: 写者从不等待；读者在写入期间或被覆盖时重读
+        template <typename T>
+        class SeqLock {
+            static_assert(std::is_trivially_copyable<T>::value, "SeqLock requires a trivially copyable type");
+            static constexpr size_t Words = (sizeof(T) + 7) / 8;
+        public:
+            SeqLock() { store(T{}); }
+
+            void store(const T& value) {
+                uint64_t w[Words] = {};
+                std::memcpy(w, &value, sizeof(T));
+                uint32_t s = seq.load(std::memory_order_relaxed);
+                seq.store(s + 1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+                for (size_t i = 0; i < Words; ++i) words[i].store(w[i], std::memory_order_relaxed);
+                seq.store(s + 2, std::memory_order_release);
+            }
+
+            T load() const {
+                uint64_t w[Words];
+                uint32_t s1, s2;
+                do {
+                    s1 = seq.load(std::memory_order_acquire);
+                    for (size_t i = 0; i < Words; ++i) w[i] = words[i].load(std::memory_order_relaxed);
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    s2 = seq.load(std::memory_order_relaxed);
+                } while ((s1 & 1) || s1 != s2);
+                T value;
+                std::memcpy(&value, w, sizeof(T));
+                return value;
+            }
+
+        private:
+            std::atomic<uint32_t> seq{ 0 };
+            std::atomic<uint64_t> words[Words];
+        };
+
+        SeqLock<DeviceStamp> device;
+        SeqLock<TrackMap> track;
+        std::atomic<uint32_t> outputLatency{ 0 };
+    };
+
+    // 均衡器节点: 接在所有曲目与引擎端点之间，在音频线程中处理混音后的整路信号
+    struct EqualizerNode {
+        ma_node_base base;      // 必须为首成员(miniaudio 以 ma_node* 访问)
+        meq::Equalizer eq;
+
+        static void onProcess(ma_node* node, const float** framesIn, ma_uint32* frameCountIn,
+            float** framesOut, ma_uint32* frameCountOut) {
+            (void)frameCountIn;
+            static_cast<EqualizerNode*>(node)->eq.process(framesIn[0], framesOut[0], *frameCountOut);
+        }
+
+        static const ma_node_vtable* vtable() {
+            // 1 入 1 出，输入输出帧数相同
+            static const ma_node_vtable vt = { &EqualizerNode::onProcess, NULL, 1, 1, 0 };
+            return &vt;
+        }
+    };
+
+    // 播放器数据  
+    struct PlayerData {
+        PlaybackState state = PlaybackState::Stopped;
+        PlayMode mode = PlayMode::Normal;
+        int32_t currentSongIndex = 0;
+        float currentPosition = 0.0f;
+        float currentDuration = 0.0f;
+        int32_t volume = 80;
+        bool isDraggingProgress = false;
+        SongLibrary::Ptr songLibrary = SongLibrary::makeEmpty();  // 共享的不可变快照，永不为空指针
+        PlayQueue queue;    // 播放顺序、接下来播放与历史
+    };
+
+    class MPlayer {
+    public:
+        MPlayer();
+        ~MPlayer();
+
+        // 基本控制  
+        // noDevice: 不打开音频设备(固定 48kHz 立体声)，由调用方经 readFrames 拉取输出，供离线测试
+        bool init(bool noDevice = false);
+        void cleanup();
+        void playAudio(const std::wstring& filePath);
+        void pauseAudio();
+        void resumeAudio();
+        void stopAudio();
+        void seekAudio(float position);
+        void updateAudioPosition();
+        // 仅 noDevice 模式: 从引擎拉取混音后的 f32 交错 PCM，返回实际帧数(同样发布播放时钟)
+        ma_uint64 readFrames(float* out, ma_uint64 frameCount);
+
+        // 歌曲库管理  
+        void initSongLibrary(const std::wstring& MUSIC_FOLDER = L"E:/xmusic");
+        void preSong();
+        void nextSong();
+        void playSongByIndex(int32_t index);
+
+        // 获取器  
+        PlaybackState getPlaybackState() const { return playerData.state; }
+        PlayMode getPlayMode() const { return playerData.mode; }
+        int32_t getCurrentSongIndex() const { return playerData.currentSongIndex; }
+        const SongLibrary& getSongLibrary() const  { return *playerData.songLibrary; }
+        SongLibrary::Ptr getLibrarySnapshot() const { return playerData.songLibrary; }
+        float getCurrentPosition() const { return playerData.currentPosition; }
+        // 任意线程、任意时刻的插值播放位置(秒)，亚毫秒精度，歌词/进度条可直接查询
+        double getPlaybackPosition() const { return clock.position(); }
+        const PlaybackClock& getClock() const { return clock; }
+        float getCurrentDuration() const { return playerData.currentDuration; }
+        int32_t getVolume() const { return playerData.volume; }
+        const Song* getCurrentSong() const {
+            if (playerData.currentSongIndex >= 0 &&
+                playerData.currentSongIndex < static_cast<int32_t>(playerData.songLibrary->size())) {
+                return &(*playerData.songLibrary)[playerData.currentSongIndex];
+            }
+            return nullptr;
+        }
+        void setSongLibrary(const std::vector<Song>& songs);
+        // 切换到新版本快照(不复制)；正在播放的歌曲仍在新版本中时继续播放并更新索引
+        void setSongLibrary(SongLibrary::Ptr library);
+
+        // 设置器  
+        void setVolume(float volume) {
+            playerData.volume = static_cast<int32_t>(std::clamp(volume, 0.0f, 100.0f));
+            if (soundInitialized) {
+                ma_sound_set_volume(currentSound.get(), playerData.volume / 100.0f * currentGain);
+            }
+            if (nextInitialized) {
+                ma_sound_set_volume(nextSound.get(), playerData.volume / 100.0f * nextGain);
+            }
+        }
+
+        // 响度均衡: 歌曲库在后台低优先级线程中分析(结果缓存到 data/loudness.cache)，
+        // 开始播放某首时按缓存的 ReplayGain 增益设置一次音量，播放过程中没有额外开销
+        void setVolumeNormalization(bool enable) {
+            normalizeLoudness = enable;
+            const Song* song = getCurrentSong();
+            if (soundInitialized && song) currentGain = gainOf(song->filePath);
+            releaseNext();
+            setVolume(static_cast<float>(playerData.volume));
+        }
+        bool isVolumeNormalization() const { return normalizeLoudness; }
+        mloud::Analyzer& getLoudnessAnalyzer() { return loudness; }
+
+        // 文件读取统计(打开/读/跳转次数、系统调用与字节数)，可按播放时长换算为每秒开销
+        mvfs::Stats getIoStats() const { return vfs.getStats(); }
+
+        // 无缝播放: 当前曲目剩余 preloadSeconds 秒内在后台打开下一首(由播放模式决定)，
+        // 并在音频引擎内按采样帧排定其开始时刻；crossfadeSeconds > 0 时两首交叉淡入淡出。
+        void setGapless(bool enable) { gapless = enable; if (!enable) releaseNext(); }
+        void setCrossfade(float seconds) { crossfadeSeconds = std::max(0.0f, seconds); releaseNext(); }
+        void setPreloadSeconds(float seconds) { preloadSeconds = std::max(1.0f, seconds); }
+        // 无缝切换到下一首时回调(参数为新的歌曲索引)，手动切歌不触发
+        std::function<void(int32_t)> onTrackChanged;
+
+        void setPlayMode(PlayMode mode) {
+            if (playerData.mode != mode) {
+                releaseNext();
+                playerData.mode = mode;
+                generateShuffleOrder();
+            }
+        }
+
+        // 均衡器: 参数可在任意线程无锁调整，默认关闭(关闭时平滑回 0dB 后旁路)
+        meq::Equalizer& getEqualizer() { return eqNode->eq; }
+        bool hasEqualizer() const { return eqInitialized; }
+
+        // 播放队列: 接下来播放优先于播放模式决定的顺序，上一首优先回到播放历史
+        const PlayQueue& getQueue() const { return playerData.queue; }
+        PlayQueue::Handle enqueueSong(int32_t index) { releaseNext(); return playerData.queue.enqueue(validIndex(index)); }
+        PlayQueue::Handle playNextSong(int32_t index) { releaseNext(); return playerData.queue.playNext(validIndex(index)); }
+        bool removeQueued(PlayQueue::Handle h) { releaseNext(); return playerData.queue.remove(h); }
+        bool moveQueuedAfter(PlayQueue::Handle h, PlayQueue::Handle after) { releaseNext(); return playerData.queue.moveAfter(h, after); }
+        void clearQueued() { releaseNext(); playerData.queue.clearUpNext(); }
+
+        // 检查是否播放结束  
+        bool isPlaybackFinished() const {
+            if (!soundInitialized || playerData.state != PlaybackState::Playing) {
+                return false;
+            }
+            if (nextScheduled) return false;    // 下一首已排定，由 updateAudioPosition 无缝切换
+            // 播放/继续/跳转都排定在稍后的引擎时刻开始，此前 ma_sound_is_playing 为 false
+            if (ma_engine_get_time_in_pcm_frames(&engine) < currentStartFrame) return false;
+            return !ma_sound_is_playing(currentSound.get());
+        }
+
+    private:
+        ma_engine engine;
+        // ma_sound 不可移动，放在堆上以便切歌时交换所有权
+        std::unique_ptr<ma_sound> currentSound = std::make_unique<ma_sound>();
+        std::unique_ptr<ma_sound> nextSound = std::make_unique<ma_sound>();
+        std::unique_ptr<ma_sound> retiringSound = std::make_unique<ma_sound>();  // 交叉淡出中的上一首
+        PlayerData playerData;
+        PlaybackClock clock;
+        std::unique_ptr<EqualizerNode> eqNode = std::make_unique<EqualizerNode>();
+        mvfs::MappedVfs vfs;                // 须先于 loudness 声明: 分析线程在 loudness 析构时才退出
+        mloud::Analyzer loudness;
+        bool normalizeLoudness = true;
+        float currentGain = 1.0f;           // 当前/下一首的响度增益(线性)
+        float nextGain = 1.0f;
+        bool eqInitialized = false;
+        bool engineInitialized = false;
+        bool soundInitialized = false;
+
+        // 无缝播放状态(时间均为引擎全局采样帧)
+        bool gapless = true;
+        float crossfadeSeconds = 0.0f;
+        float preloadSeconds = 10.0f;
+        bool nextInitialized = false;
+        bool nextScheduled = false;
+        bool retiringInitialized = false;
+        int32_t nextSongIndex = -1;
+        ma_uint64 currentOrigin = 0;        // 当前曲目第 0 帧对应的引擎时刻
+        ma_uint64 currentStartFrame = 0;    // 当前曲目排定开始发声的引擎时刻
+        ma_uint64 nextStartFrame = 0;
+        ma_uint64 retireFrame = 0;
+
+        void startCurrentAt(ma_uint64 sourceFrame);
+        ma_uint32 sourceRateOf(ma_sound* sound);
+        bool initEqualizer();
+        float gainOf(const std::wstring& filePath) const {
+            return normalizeLoudness ? loudness.gainFor(std::filesystem::path(filePath)) : 1.0f;
+        }
+        void analyzeLibrary();
+        void routeSound(ma_sound* sound);
+        void publishPaused(ma_uint64 sourceFrame);
+        static void onEngineProcess(void* userData, float* framesOut, ma_uint64 frameCount);
+        bool engineFramesOf(ma_sound* sound, ma_uint64 sourceFrames, ma_uint64& out);
+        void prepareNext();
+        void scheduleNext();
+        void promoteNext();
+        void releaseNext();
+
+        void startSong(int32_t index);
+        int32_t validIndex(int32_t index) const {
+            return (index >= 0 && index < static_cast<int32_t>(playerData.songLibrary->size())) ? index : -1;
+        }
+        void generateShuffleOrder();
+        int32_t getNextSongIndex() const;
+        int32_t getPrevSongIndex() const;
+    };
+
+    // 实现部分  
+    MPlayer::MPlayer() {
+        // 构造函数保持简单  
+    }
+
+    MPlayer::~MPlayer() {
+        cleanup();
+    }
+
+    bool MPlayer::init(bool noDevice) {
+        ma_engine_config config = ma_engine_config_init();
+        if (noDevice) {
+            config.noDevice = MA_TRUE;
+            config.channels = 2;
+            config.sampleRate = 48000;
+        }
+        config.onProcess = &MPlayer::onEngineProcess;   // 音频线程每块回调，发布播放时钟
+        config.pProcessUserData = this;
+        config.pResourceManagerVFS = vfs.get();         // 流式/预解码的所有文件都经内存映射读取
+        loudness.setVfs(vfs.get());
+        loudness.onFinished = [](const mloud::Analyzer::Stats& s) {
+            ODD(L"响度分析完成: 分析 %llu 首, 缓存命中 %llu, 失败 %llu, 音频 %.2f 小时, 耗时 %.1f 秒, %.2f 小时/分钟\n",
+                static_cast<unsigned long long>(s.analyzed), static_cast<unsigned long long>(s.cached),
+                static_cast<unsigned long long>(s.failed), s.audioSeconds / 3600.0, s.wallSeconds, s.hoursPerMinute());
+        };
+        ma_result result = ma_engine_init(&config, &engine);
+        if (result != MA_SUCCESS) {
+            std::wcout << L"Failed to initialize audio engine" << std::endl;
+            return false;
+        }
+        engineInitialized = true;
+
+        // 输出延迟: 本块之前设备缓冲中还排着 (周期数 - 1) 个周期，按设备内部采样率换算为引擎帧
+        if (ma_device* device = ma_engine_get_device(&engine)) {
+            ma_uint32 period = device->playback.internalPeriodSizeInFrames;
+            ma_uint32 periods = std::max<ma_uint32>(2, device->playback.internalPeriods);
+            ma_uint32 deviceRate = device->playback.internalSampleRate;
+            ma_uint32 engineRate = ma_engine_get_sample_rate(&engine);
+            if (period > 0 && deviceRate > 0) {
+                uint64_t frames = static_cast<uint64_t>(period) * (periods - 1) * engineRate / deviceRate;
+                clock.setOutputLatency(static_cast<uint32_t>(frames));
+            }
+        }
+
+        if (!initEqualizer()) {
+            ODD(L"均衡器节点初始化失败，曲目直接输出到引擎端点\n");
+        }
+        return true;
+    }
+
+    ma_uint64 MPlayer::readFrames(float* out, ma_uint64 frameCount) {
+        if (!engineInitialized) return 0;
+        ma_uint64 read = 0;
+        ma_engine_read_pcm_frames(&engine, out, frameCount, &read);
+        return read;
+    }
+
+    bool MPlayer::initEqualizer() {
+        ma_uint32 channels = ma_engine_get_channels(&engine);
+        if (!eqNode->eq.init(ma_engine_get_sample_rate(&engine), channels, 10)) return false;
+
+        ma_node_config config = ma_node_config_init();
+        config.vtable = EqualizerNode::vtable();
+        config.pInputChannels = &channels;
+        config.pOutputChannels = &channels;
+        if (ma_node_init(ma_engine_get_node_graph(&engine), &config, NULL, eqNode.get()) != MA_SUCCESS) return false;
+        if (ma_node_attach_output_bus(eqNode.get(), 0, ma_engine_get_endpoint(&engine), 0) != MA_SUCCESS) {
+            ma_node_uninit(eqNode.get(), NULL);
+            return false;
+        }
+        eqInitialized = true;
+        return true;
+    }
+
+    // 入队整个歌曲库(立即返回)；已分析且文件未变化的曲目由工作线程按缓存跳过
+    void MPlayer::analyzeLibrary() {
+        std::vector<std::filesystem::path> files;
+        files.reserve(playerData.songLibrary->size());
+        for (const Song& song : *playerData.songLibrary) files.emplace_back(song.filePath);
+        if (!files.empty()) loudness.analyze(files);
+    }
+
+    // 新初始化的曲目默认连到端点，改接到均衡器节点
+    void MPlayer::routeSound(ma_sound* sound) {
+        if (eqInitialized) ma_node_attach_output_bus(sound, 0, eqNode.get(), 0);
+    }
+
+    // 音频线程: 引擎刚输出一块，发布这块对应的引擎时刻与当前时间戳(不加锁、不分配)
+    void MPlayer::onEngineProcess(void* userData, float* framesOut, ma_uint64 frameCount) {
+        (void)framesOut;
+        MPlayer* self = static_cast<MPlayer*>(userData);
+        ma_uint64 end = ma_engine_get_time_in_pcm_frames(&self->engine);
+        self->clock.publishDevice(end - std::min(end, frameCount), static_cast<uint32_t>(frameCount),
+            ma_engine_get_sample_rate(&self->engine));
+    }
+
+    ma_uint32 MPlayer::sourceRateOf(ma_sound* sound) {
+        ma_uint32 rate = 0;
+        if (ma_sound_get_data_format(sound, NULL, NULL, &rate, NULL, 0) != MA_SUCCESS || rate == 0) {
+            rate = ma_engine_get_sample_rate(&engine);
+        }
+        return rate;
+    }
+
+    void MPlayer::publishPaused(ma_uint64 sourceFrame) {
+        ma_uint64 length = 0;
+        ma_sound_get_length_in_pcm_frames(currentSound.get(), &length);
+        ma_uint32 rate = sourceRateOf(currentSound.get());
+        clock.publishPaused(sourceFrame, rate, length);
+        playerData.currentPosition = static_cast<float>(static_cast<double>(sourceFrame) / rate);
+    }
+
+    void MPlayer::cleanup() {
+        loudness.stop();
+        releaseNext();
+        if (soundInitialized) {
+            ma_sound_uninit(currentSound.get());
+            soundInitialized = false;
+        }
+        if (eqInitialized) {
+            ma_node_uninit(eqNode.get(), NULL);
+            eqInitialized = false;
+        }
+        if (engineInitialized) {
+            ma_engine_uninit(&engine);
+            engineInitialized = false;
+        }
+    }
+
+    void MPlayer::playAudio(const std::wstring& filePath) {
+        releaseNext();
+        if (soundInitialized) {
+            ma_sound_stop(currentSound.get());
+            ma_sound_uninit(currentSound.get());
+            soundInitialized = false;
+        }
+
+        // 统一路径分隔符为正斜杠  
+        std::wstring normalizedPath = filePath;
+        std::replace(normalizedPath.begin(), normalizedPath.end(), L'\\', L'/');
 
         ma_uint32 flags = MA_SOUND_FLAG_STREAM | MA_SOUND_FLAG_ASYNC |
             MA_SOUND_FLAG_WAIT_INIT | MA_SOUND_FLAG_NO_SPATIALIZATION;
 
         // 直接使用宽字符版本的函数  
-        ma_result result = ma_sound_init_from_file_w(&engine, normalizedPath.c_str(), flags, NULL, NULL, &currentSound);
+        ma_result result = ma_sound_init_from_file_w(&engine, normalizedPath.c_str(), flags, NULL, NULL, currentSound.get());
 
         if (result == MA_SUCCESS) {
             soundInitialized = true;
-            ma_sound_get_length_in_seconds(&currentSound, &playerData.currentDuration);
-            ma_sound_set_volume(&currentSound, playerData.volume / 100.0f);
-            ma_sound_start(&currentSound);
+            routeSound(currentSound.get());
+            ma_sound_get_length_in_seconds(currentSound.get(), &playerData.currentDuration);
+            currentGain = gainOf(filePath);
+            ma_sound_set_volume(currentSound.get(), playerData.volume / 100.0f * currentGain);
+            startCurrentAt(0);
             playerData.state = PlaybackState::Playing;
             playerData.currentPosition = 0.0f;
         }
@@ -1078,27 +2279,33 @@ namespace MUI {
 
     void MPlayer::pauseAudio() {
         if (soundInitialized && playerData.state == PlaybackState::Playing) {
-            updateAudioPosition();
-            ma_sound_stop(&currentSound);
+            releaseNext();
+            ma_sound_stop(currentSound.get());
+            ma_uint64 cursor = 0;
+            ma_sound_get_cursor_in_pcm_frames(currentSound.get(), &cursor);
+            publishPaused(cursor);
             playerData.state = PlaybackState::Paused;
         }
     }
 
     void MPlayer::resumeAudio() {
         if (soundInitialized && playerData.state == PlaybackState::Paused) {
-            ma_sound_seek_to_pcm_frame(&currentSound,
-                static_cast<ma_uint64>(playerData.currentPosition * ma_engine_get_sample_rate(&engine)));
-            ma_sound_start(&currentSound);
+            // 从暂停时的源帧原样继续，不经秒数往返换算
+            ma_uint64 frame = 0;
+            ma_sound_get_cursor_in_pcm_frames(currentSound.get(), &frame);
+            startCurrentAt(frame);
             playerData.state = PlaybackState::Playing;
         }
     }
 
     void MPlayer::stopAudio() {
+        releaseNext();
         if (soundInitialized) {
-            ma_sound_stop(&currentSound);
-            ma_sound_uninit(&currentSound);
+            ma_sound_stop(currentSound.get());
+            ma_sound_uninit(currentSound.get());
             soundInitialized = false;
         }
+        clock.publishStopped();
         playerData.state = PlaybackState::Stopped;
         playerData.currentPosition = 0.0f;
         playerData.currentDuration = 0.0f;
@@ -1107,24 +2314,46 @@ namespace MUI {
     void MPlayer::seekAudio(float position) {
         if (soundInitialized &&
             (playerData.state == PlaybackState::Playing || playerData.state == PlaybackState::Paused)) {
-            ma_uint64 targetFrame = static_cast<ma_uint64>(position * ma_engine_get_sample_rate(&engine));
-            ma_sound_seek_to_pcm_frame(&currentSound, targetFrame);
-            playerData.currentPosition = position;
+            // 按文件采样率换算(引擎采样率与文件不同时避免漂移)
+            ma_uint64 targetFrame = static_cast<ma_uint64>(std::max(0.0f, position) * sourceRateOf(currentSound.get()) + 0.5);
+            releaseNext();
+            ma_sound_seek_to_pcm_frame(currentSound.get(), targetFrame);
+            // 播放中重新排定开始时刻，保证之后计算出的曲目结束帧准确
+            if (playerData.state == PlaybackState::Playing) {
+                ma_sound_stop(currentSound.get());
+                startCurrentAt(targetFrame);
+                playerData.currentPosition = position;
+            }
+            else {
+                publishPaused(targetFrame);
+            }
         }
     }
 
     void MPlayer::updateAudioPosition() {
-        if (soundInitialized && playerData.state == PlaybackState::Playing) {
-            ma_uint64 cursor;
-            if (ma_sound_get_cursor_in_pcm_frames(&currentSound, &cursor) == MA_SUCCESS) {
-                playerData.currentPosition = static_cast<float>(cursor) / ma_engine_get_sample_rate(&engine);
+        if (soundInitialized && playerData.state == PlaybackState::Playing && gapless) {
+            ma_uint64 now = ma_engine_get_time_in_pcm_frames(&engine);
+            if (retiringInitialized && now >= retireFrame) {
+                ma_sound_uninit(retiringSound.get());
+                retiringInitialized = false;
+            }
+            if (nextScheduled && now >= nextStartFrame) {
+                promoteNext();
             }
+            else {
+                prepareNext();
+                scheduleNext();
+            }
+        }
+
+        if (soundInitialized && playerData.state == PlaybackState::Playing) {
+            playerData.currentPosition = static_cast<float>(clock.position());
         }
     }
 
     void MPlayer::initSongLibrary(const std::wstring& MUSIC_FOLDER) {
         try {
-            playerData.songLibrary.clear();
+            std::vector<Song> songs;
             std::wstring exeDir = MUI::getExecutableDirectory();
 
             for (const auto& entry : fs::directory_iterator(MUSIC_FOLDER)) {
@@ -1143,11 +2372,16 @@ namespace MUI {
                             }
                         }
 
-                        playerData.songLibrary.push_back(song);
+                        songs.push_back(std::move(song));
                     }
                 }
             }
 
+            playerData.songLibrary = SongLibrary::create(std::move(songs));
+            loudness.setCacheFile(std::filesystem::path(exeDir + L"/data/loudness.cache"));
+            analyzeLibrary();
+            playerData.queue.reset(static_cast<int32_t>(playerData.songLibrary->size()));
+            playerData.queue.setAnchor(playerData.currentSongIndex);
             generateShuffleOrder();
         }
         catch (const fs::filesystem_error& e) {
@@ -1166,7 +2400,7 @@ namespace MUI {
         }
 
         // 更新歌曲库
-        playerData.songLibrary = songs;
+        playerData.songLibrary = SongLibrary::create(songs);
 
         // 重置当前播放状态
         playerData.currentSongIndex = 0;
@@ -1174,100 +2408,233 @@ namespace MUI {
         playerData.currentDuration = 0.0f;
 
         // 如果新歌库不为空，更新当前歌曲的时长信息
-        if (!playerData.songLibrary.empty()) {
+        if (!playerData.songLibrary->empty()) {
             const Song* currentSong = getCurrentSong();
             if (currentSong) {
                 playerData.currentDuration = currentSong->duration;
             }
         }
 
-        // 重新生成随机播放顺序（如果需要）
-        if (playerData.mode == PlayMode::Shuffle) {
-            generateShuffleOrder();
-        }
-        else {
-            // 清空随机播放顺序
-            playerData.shuffleOrder.clear();
-        }
+        analyzeLibrary();
 
-        ODD(L"已设置歌曲库，共 %zu 首歌曲\n", playerData.songLibrary.size());
+        // 整体替换: 重建播放队列（随机模式下重新洗牌）
+        playerData.queue.reset(static_cast<int32_t>(playerData.songLibrary->size()));
+        playerData.queue.setAnchor(playerData.currentSongIndex);
+        generateShuffleOrder();
+
+        ODD(L"已设置歌曲库，共 %zu 首歌曲\n", playerData.songLibrary->size());
     }
 
-    void MPlayer::playSongByIndex(int32_t index) {
-        if (index >= 0 && index < static_cast<int32_t>(playerData.songLibrary.size())) {
-            playerData.currentSongIndex = index;
-            playAudio(playerData.songLibrary[index].filePath);
+    // 在稍后的确定引擎时刻开始播放当前曲目(sourceFrame 为起始源帧)，记录其第 0 帧的引擎时刻
+    void MPlayer::startCurrentAt(ma_uint64 sourceFrame) {
+        ma_uint32 rate = ma_engine_get_sample_rate(&engine);
+        ma_uint64 start = ma_engine_get_time_in_pcm_frames(&engine) + rate / 50;  // 留 20ms 余量，避免开始时刻已过去
+        ma_uint64 offset = 0;
+        engineFramesOf(currentSound.get(), sourceFrame, offset);
+        currentOrigin = start - std::min(offset, start);
+        currentStartFrame = start;
+        ma_sound_set_stop_time_in_pcm_frames(currentSound.get(), ~(ma_uint64)0);
+        ma_sound_set_start_time_in_pcm_frames(currentSound.get(), start);
+        ma_sound_start(currentSound.get());
+
+        ma_uint64 length = 0;
+        ma_sound_get_length_in_pcm_frames(currentSound.get(), &length);
+        clock.publishPlaying(currentOrigin, sourceFrame, sourceRateOf(currentSound.get()), rate, length);
+    }
+
+    // 源采样帧 -> 引擎采样帧(两者采样率相同时精确相等)
+    bool MPlayer::engineFramesOf(ma_sound* sound, ma_uint64 sourceFrames, ma_uint64& out) {
+        ma_uint32 srcRate = 0;
+        if (ma_sound_get_data_format(sound, NULL, NULL, &srcRate, NULL, 0) != MA_SUCCESS || srcRate == 0) {
+            return false;
         }
+        ma_uint32 engineRate = ma_engine_get_sample_rate(&engine);
+        out = (srcRate == engineRate) ? sourceFrames : (sourceFrames * engineRate + srcRate / 2) / srcRate;
+        return true;
     }
 
-    void MPlayer::generateShuffleOrder() {
-        playerData.shuffleOrder.clear();
-        if (playerData.songLibrary.empty()) return;
+    // 当前曲目进入预加载窗口后，异步打开下一首(不等待解码器就绪，不阻塞 UI 线程)
+    void MPlayer::prepareNext() {
+        if (nextInitialized || retiringInitialized) return;
+        if (playerData.currentDuration - playerData.currentPosition > preloadSeconds) return;
+
+        int32_t index = getNextSongIndex();
+        if (index < 0) return;
 
-        for (int32_t i = 0; i < static_cast<int32_t>(playerData.songLibrary.size()); ++i) {
-            playerData.shuffleOrder.push_back(i);
+        std::wstring path = (*playerData.songLibrary)[index].filePath;
+        std::replace(path.begin(), path.end(), L'\\', L'/');
+        ma_uint32 flags = MA_SOUND_FLAG_STREAM | MA_SOUND_FLAG_ASYNC | MA_SOUND_FLAG_NO_SPATIALIZATION;
+        if (ma_sound_init_from_file_w(&engine, path.c_str(), flags, NULL, NULL, nextSound.get()) != MA_SUCCESS) {
+            nextSongIndex = -1;
+            return;
         }
+        nextGain = gainOf((*playerData.songLibrary)[index].filePath);
+        ma_sound_set_volume(nextSound.get(), playerData.volume / 100.0f * nextGain);
+        routeSound(nextSound.get());
+        nextInitialized = true;
+        nextSongIndex = index;
+    }
 
-        std::random_device rd;
-        std::mt19937 g(rd());
-        std::shuffle(playerData.shuffleOrder.begin(), playerData.shuffleOrder.end(), g);
+    // 下一首就绪后排定: 无交叉淡化时开始帧 = 当前曲目结束帧，做到零采样间隙
+    void MPlayer::scheduleNext() {
+        if (!nextInitialized || nextScheduled) return;
+
+        ma_uint64 length = 0, endOffset = 0, probe = 0;
+        if (ma_sound_get_length_in_pcm_frames(currentSound.get(), &length) != MA_SUCCESS || length == 0) return;
+        if (!engineFramesOf(currentSound.get(), length, endOffset)) return;
+        if (!engineFramesOf(nextSound.get(), 0, probe)) return;     // 异步打开尚未完成
+
+        ma_uint64 endFrame = currentOrigin + endOffset;
+        ma_uint64 fade = static_cast<ma_uint64>(crossfadeSeconds * ma_engine_get_sample_rate(&engine));
+        fade = std::min(fade, endOffset / 2);
+        ma_uint64 start = endFrame - fade;
+        if (start <= ma_engine_get_time_in_pcm_frames(&engine)) return;  // 来不及排定，按普通方式切歌
+
+        ma_sound_set_start_time_in_pcm_frames(nextSound.get(), start);
+        if (fade > 0) {
+            // 需要 miniaudio 0.11.22+: 在指定引擎时刻开始淡入/淡出
+            ma_sound_set_fade_start_in_pcm_frames(nextSound.get(), 0.0f, 1.0f, fade, start);
+            ma_sound_set_stop_time_with_fade_in_pcm_frames(currentSound.get(), endFrame, fade);
+        }
+        ma_sound_start(nextSound.get());
+        nextStartFrame = start;
+        retireFrame = endFrame;
+        nextScheduled = true;
+    }
 
-        if (playerData.mode == PlayMode::Shuffle) {
-            auto it = std::find(playerData.shuffleOrder.begin(), playerData.shuffleOrder.end(), playerData.currentSongIndex);
-            if (it != playerData.shuffleOrder.end()) {
-                std::swap(playerData.shuffleOrder[0], *it);
-            }
-        }
+    // 下一首已在引擎中开始: 交换所有权，上一首留到结束帧后再释放
+    void MPlayer::promoteNext() {
+        std::swap(retiringSound, currentSound);
+        std::swap(currentSound, nextSound);
+        currentGain = nextGain;
+        retiringInitialized = true;
+        nextInitialized = false;
+        nextScheduled = false;
+        currentOrigin = nextStartFrame;
+        currentStartFrame = nextStartFrame;
+
+        int32_t index = nextSongIndex;
+        nextSongIndex = -1;
+        playerData.currentPosition = 0.0f;
+        ma_sound_get_length_in_seconds(currentSound.get(), &playerData.currentDuration);
+        ma_uint64 length = 0;
+        ma_sound_get_length_in_pcm_frames(currentSound.get(), &length);
+        clock.publishPlaying(currentOrigin, 0, sourceRateOf(currentSound.get()),
+            ma_engine_get_sample_rate(&engine), length);
+        int32_t previous = playerData.currentSongIndex;
+        playerData.queue.advanceTo(previous, index);
+        playerData.currentSongIndex = index;
+        if (playerData.mode == PlayMode::Shuffle && index == playerData.queue.orderAt(0) &&
+            playerData.queue.getAnchor() == index) {
+            generateShuffleOrder();     // 随机顺序播完一轮，重新洗牌
+        }
+        if (onTrackChanged) onTrackChanged(index);
     }
 
-    int32_t MPlayer::getNextSongIndex() const {
-        if (playerData.songLibrary.empty()) return -1;
+    // 取消已准备/已排定的下一首与仍在淡出的上一首(切歌、暂停、跳转、模式变化时)
+    void MPlayer::releaseNext() {
+        if (nextScheduled && soundInitialized) {
+            // 撤销排定的淡出与停止
+            ma_sound_set_stop_time_in_pcm_frames(currentSound.get(), ~(ma_uint64)0);
+            ma_sound_set_fade_in_pcm_frames(currentSound.get(), 1.0f, 1.0f, 0);
+        }
+        if (retiringInitialized) {
+            ma_sound_stop(retiringSound.get());
+            ma_sound_uninit(retiringSound.get());
+            retiringInitialized = false;
+        }
+        if (nextInitialized) {
+            ma_sound_stop(nextSound.get());
+            ma_sound_uninit(nextSound.get());
+            nextInitialized = false;
+        }
+        nextScheduled = false;
+        nextSongIndex = -1;
+    }
 
-        switch (playerData.mode) {
-        case PlayMode::Normal:
-            return (playerData.currentSongIndex + 1 < static_cast<int32_t>(playerData.songLibrary.size()))
-                ? playerData.currentSongIndex + 1 : -1;
+    void MPlayer::setSongLibrary(SongLibrary::Ptr library) {
+        if (!library) library = SongLibrary::makeEmpty();
+        if (library == playerData.songLibrary) return;
 
-        case PlayMode::Repeat:
-            return (playerData.currentSongIndex + 1) % static_cast<int32_t>(playerData.songLibrary.size());
+        releaseNext();
 
-        case PlayMode::Shuffle:
-            if (playerData.shuffleOrder.empty()) return -1;
-            auto it = std::find(playerData.shuffleOrder.begin(), playerData.shuffleOrder.end(), playerData.currentSongIndex);
-            if (it == playerData.shuffleOrder.end()) return playerData.shuffleOrder[0];
+        // 旧索引 -> 新索引(按 filePath)，播放队列据此保留原有顺序、接下来播放与历史
+        std::unordered_map<std::wstring, int32_t> newIndex;
+        newIndex.reserve(library->size());
+        for (size_t i = 0; i < library->size(); ++i) {
+            newIndex.emplace((*library)[i].filePath, static_cast<int32_t>(i));
+        }
+        std::vector<int32_t> oldToNew(playerData.songLibrary->size(), -1);
+        for (size_t i = 0; i < oldToNew.size(); ++i) {
+            auto it = newIndex.find((*playerData.songLibrary)[i].filePath);
+            if (it != newIndex.end()) oldToNew[i] = it->second;
+        }
+        playerData.queue.remap(oldToNew, static_cast<int32_t>(library->size()));
 
-            int32_t nextIndex = static_cast<int32_t>(std::distance(playerData.shuffleOrder.begin(), it)) + 1;
-            return (nextIndex < static_cast<int32_t>(playerData.shuffleOrder.size()))
-                ? playerData.shuffleOrder[nextIndex] : playerData.shuffleOrder[0];
+        const Song* current = getCurrentSong();
+        int32_t remapped = current ? oldToNew[playerData.currentSongIndex] : -1;
+        if (remapped < 0) {
+            // 当前歌曲已不存在: 与整体替换相同，停止并从头开始
+            if (soundInitialized) stopAudio();
+            playerData.currentPosition = 0.0f;
+            playerData.currentDuration = library->empty() ? 0.0f : (*library)[0].duration;
+            remapped = 0;
+            playerData.queue.setAnchor(remapped);
         }
-        return -1;
+        playerData.currentSongIndex = remapped;
+        playerData.songLibrary = std::move(library);
+        analyzeLibrary();
+
+        ODD(L"歌曲库切换到版本 %llu，共 %zu 首歌曲\n",
+            (unsigned long long)playerData.songLibrary->getVersion(), playerData.songLibrary->size());
     }
 
-    int32_t MPlayer::getPrevSongIndex() const {
-        if (playerData.songLibrary.empty()) return -1;
+    // 用户选择的歌曲: 当前歌曲记入历史，基础顺序从所选歌曲继续
+    void MPlayer::playSongByIndex(int32_t index) {
+        if (validIndex(index) < 0) return;
+        if (soundInitialized && index != playerData.currentSongIndex) {
+            playerData.queue.pushHistory(playerData.currentSongIndex);
+        }
+        playerData.queue.setAnchor(index);
+        startSong(index);
+    }
 
-        switch (playerData.mode) {
-        case PlayMode::Normal:
-            return (playerData.currentSongIndex > 0) ? playerData.currentSongIndex - 1 : -1;
+    void MPlayer::startSong(int32_t index) {
+        playerData.currentSongIndex = index;
+        playAudio((*playerData.songLibrary)[index].filePath);
+    }
 
-        case PlayMode::Repeat:
-            return (playerData.currentSongIndex - 1 + static_cast<int32_t>(playerData.songLibrary.size())) % static_cast<int32_t>(playerData.songLibrary.size());
+    // 仅重排基础顺序(O(n))，接下来播放与历史保持不变
+    void MPlayer::generateShuffleOrder() {
+        PlayQueue& queue = playerData.queue;
+        if (queue.size() != static_cast<int32_t>(playerData.songLibrary->size())) {
+            queue.reset(static_cast<int32_t>(playerData.songLibrary->size()));
+            queue.setAnchor(playerData.currentSongIndex);
+        }
+        if (playerData.mode == PlayMode::Shuffle) {
+            queue.shuffle(validIndex(playerData.currentSongIndex));
+        }
+        else {
+            queue.unshuffle();
+        }
+    }
 
-        case PlayMode::Shuffle:
-            if (playerData.shuffleOrder.empty()) return -1;
-            auto it = std::find(playerData.shuffleOrder.begin(), playerData.shuffleOrder.end(), playerData.currentSongIndex);
-            if (it == playerData.shuffleOrder.end()) return playerData.shuffleOrder[0];
+    int32_t MPlayer::getNextSongIndex() const {
+        if (playerData.songLibrary->empty()) return -1;
+        return playerData.queue.peekNext(playerData.mode != PlayMode::Normal);
+    }
 
-            int32_t prevIndex = static_cast<int32_t>(std::distance(playerData.shuffleOrder.begin(), it)) - 1;
-            return (prevIndex >= 0) ? playerData.shuffleOrder[prevIndex] : playerData.shuffleOrder.back();
-        }
-        return -1;
+    int32_t MPlayer::getPrevSongIndex() const {
+        if (playerData.songLibrary->empty()) return -1;
+        return playerData.queue.peekPrev(playerData.mode != PlayMode::Normal);
     }
 
     void MPlayer::preSong() {
         int32_t prevIndex = getPrevSongIndex();
         if (prevIndex >= 0) {
-            playSongByIndex(prevIndex);
+            releaseNext();
+            playerData.queue.retreatTo(prevIndex);
+            startSong(prevIndex);
         }
         else {
             stopAudio();
@@ -1277,9 +2644,12 @@ namespace MUI {
     void MPlayer::nextSong() {
         int32_t nextIndex = getNextSongIndex();
         if (nextIndex >= 0) {
-            playSongByIndex(nextIndex);
-            if (playerData.mode == PlayMode::Shuffle && nextIndex == playerData.shuffleOrder[0]) {
-                generateShuffleOrder();
+            releaseNext();
+            playerData.queue.advanceTo(playerData.currentSongIndex, nextIndex);
+            startSong(nextIndex);
+            if (playerData.mode == PlayMode::Shuffle && nextIndex == playerData.queue.orderAt(0) &&
+                playerData.queue.getAnchor() == nextIndex) {
+                generateShuffleOrder();     // 随机顺序播完一轮，重新洗牌
             }
         }
         else {
@@ -1288,9 +2658,451 @@ namespace MUI {
     }
 }
 
+// FrameArena 类  
+namespace MUI {
+
+    // 帧内单调分配器: 构建场景时的临时字符串/数组从一块预留缓冲顺序分配，
+    // UIManager::buildFrame 开始时整体复位。某帧溢出预留缓冲时向堆申请，
+    // 下次复位按峰值扩大预留，稳定后每帧不再触发堆分配。
+    // 每个线程一个实例(get())；分配结果只能在本帧内使用，不可存入跨帧的成员。
+    // 注意: ThorVG 的 Paint 由库内部分配，不经过本分配器。
+    class FrameArena : public std::pmr::memory_resource {
+    public:
+        struct Stats {
+            uint32_t allocations = 0;       // 本帧分配次数
+            uint32_t upstreamBlocks = 0;    // 本帧因溢出向堆申请的块数
+            size_t bytes = 0;               // 本帧分配字节数
+            size_t capacity = 0;            // 预留缓冲大小
+        };
+
+        // 关闭后每次分配直接转交 new/delete(对比基准用)，在下一次 reset() 时生效
+        static inline bool enabled = true;
+
+        explicit FrameArena(size_t initialBytes = 64 * 1024) : buffer(initialBytes) {
+            mono.emplace(buffer.data(), buffer.size(), &upstream);
+        }
+
+        FrameArena(const FrameArena&) = delete;
+        FrameArena& operator=(const FrameArena&) = delete;
+
+        static FrameArena& get() {
+            thread_local FrameArena arena;
+            return arena;
+        }
+
+        // 帧边界: 释放本帧全部分配；上一帧溢出则扩大预留缓冲
+        void reset() {
+            last = current;
+            last.capacity = buffer.size();
+            mono.reset();
+            if (current.upstreamBlocks > 0) {
+                size_t want = std::max(buffer.size() * 2, current.bytes + current.bytes / 4);
+                std::vector<std::byte>(want).swap(buffer);
+            }
+            mono.emplace(buffer.data(), buffer.size(), &upstream);
+            current = Stats();
+            upstream.blocks = 0;
+            active = enabled;
+        }
+
+        // 上一完整帧的统计
+        Stats lastFrame() const { return last; }
+
+    protected:
+        void* do_allocate(size_t bytes, size_t align) override {
+            ++current.allocations;
+            current.bytes += bytes;
+            if (!active) return std::pmr::new_delete_resource()->allocate(bytes, align);
+            void* p = mono->allocate(bytes, align);
+            current.upstreamBlocks = upstream.blocks;
+            return p;
+        }
+
+        void do_deallocate(void* p, size_t bytes, size_t align) override {
+            // 单调: 复位时统一释放；关闭时逐个归还(帧内临时分配不会跨越 reset)
+            if (!active) std::pmr::new_delete_resource()->deallocate(p, bytes, align);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+
+    private:
+        // 溢出时的上游资源，只计数后转交 new/delete
+        struct Upstream : std::pmr::memory_resource {
+            uint32_t blocks = 0;
+            void* do_allocate(size_t bytes, size_t align) override {
+                ++blocks;
+                return std::pmr::new_delete_resource()->allocate(bytes, align);
+            }
+            void do_deallocate(void* p, size_t bytes, size_t align) override {
+                std::pmr::new_delete_resource()->deallocate(p, bytes, align);
+            }
+            bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+                return this == &other;
+            }
+        };
+
+        std::vector<std::byte> buffer;
+        Upstream upstream;
+        std::optional<std::pmr::monotonic_buffer_resource> mono;
+        Stats current;
+        Stats last;
+        bool active = enabled;
+    };
+
+    // 帧内临时容器
+    using FrameString = std::pmr::string;
+    template<typename T>
+    using FrameVector = std::pmr::vector<T>;
+}
+
+// ShapeBatch 类  
+namespace MUI {
+
+    // 同样式图元合批: 同一帧内填充/描边完全相同的矩形与线段合并为一个多轮廓 Shape,
+    // 大幅减少 ThorVG 每帧需处理的 Paint 数量。
+    // 注意: 合批会改变同一批次内图元与其他 Paint 之间的先后次序，
+    //       只应把互不重叠、且位于同一层级的图元放进同一批次，在需要的层级处 flush。
+    class ShapeBatch {
+    public:
+        // 整帧统计(由 UIManager 每帧清零)
+        static inline uint32_t framePrimitives = 0;   // 进入批次的图元数
+        static inline uint32_t frameShapes = 0;       // 实际生成的 Shape 数
+        // 关闭后每个图元各生成一个 Shape(次序不变)，用于与合批对比
+        static inline bool enabled = true;
+
+        void addRect(float x, float y, float w, float h, float radius, Color fill) {
+            addRect(x, y, w, h, radius, fill, Color(0, 0, 0, 0), 0.0f);
+        }
+
+        void addRect(float x, float y, float w, float h, float radius,
+            Color fill, Color stroke, float strokeWidth) {
+            if (w <= 0.0f || h <= 0.0f) return;
+            Bucket& b = bucket(fill, stroke, strokeWidth, false);
+            b.shape->appendRect(x, y, w, h, radius, radius);
+            ++framePrimitives;
+        }
+
+        void addLine(float x1, float y1, float x2, float y2, Color color, float width) {
+            if (width <= 0.0f || color.a == 0) return;
+            Bucket& b = bucket(Color(0, 0, 0, 0), color, width, true);
+            b.shape->moveTo(x1, y1);
+            b.shape->lineTo(x2, y2);
+            ++framePrimitives;
+        }
+
+        bool empty() const { return buckets.empty(); }
+
+        // 按样式首次出现的顺序推入父场景，并清空批次
+        void flush(tvg::Scene* parent) {
+            for (auto& b : buckets) {
+                if (parent) parent->push(b.shape);
+                else b.shape->unref();
+            }
+            buckets.clear();
+        }
+
+        ~ShapeBatch() { flush(nullptr); }
+
+    private:
+        struct Bucket {
+            uint32_t fill;
+            uint32_t stroke;
+            float strokeWidth;
+            bool line;
+            tvg::Shape* shape;
+        };
+
+        // 一帧内的样式种类很少，线性查找即可
+        std::vector<Bucket> buckets;
+
+        static uint32_t pack(Color c) {
+            return (uint32_t(c.r) << 24) | (uint32_t(c.g) << 16) | (uint32_t(c.b) << 8) | c.a;
+        }
+
+        Bucket& bucket(Color fill, Color stroke, float strokeWidth, bool line) {
+            uint32_t f = pack(fill);
+            uint32_t s = strokeWidth > 0.0f ? pack(stroke) : 0;
+            if (s == 0) strokeWidth = 0.0f;
+
+            for (auto& b : buckets) {
+                if (enabled && b.fill == f && b.stroke == s && b.strokeWidth == strokeWidth && b.line == line) {
+                    return b;
+                }
+            }
+
+            auto shape = tvg::Shape::gen();
+            if (!line) shape->fill(fill.r, fill.g, fill.b, fill.a);
+            if (strokeWidth > 0.0f) {
+                shape->strokeFill(stroke.r, stroke.g, stroke.b, stroke.a);
+                shape->strokeWidth(strokeWidth);
+            }
+            ++frameShapes;
+            buckets.push_back({ f, s, strokeWidth, line, shape });
+            return buckets.back();
+        }
+    };
+}
+
+// TextureCache 类  
+namespace MUI {
+
+    // ThorVG 文本引擎锁: 字体加载器惰性构建并缓存字形轮廓，该缓存没有内部同步。
+    // 会构建字形的操作(画布 update 文本 Paint、getGlyphInfo、离屏光栅化、字体加载/卸载)须持有此锁，
+    // 渲染线程模式下 UI 线程的测量/离屏光栅化由此与渲染线程的 update 串行。
+    // 仅生成 Text 并设置 font/text/size 等属性不构建字形，构建场景时无需加锁。
+    inline std::mutex& textEngineMutex() {
+        static std::mutex m;
+        return m;
+    }
+
+    // 程序化纹理缓存: 按生成参数(类型/尺寸/颜色/衰减)缓存位图，每组参数只生成一次。
+    // 缓存保存一份已加载的原型 Picture，acquire() 返回它的 duplicate()，副本与原型共享像素数据(不复制)。
+    // 逐帧绘制的元素为每个光晕持有一个 Instance，复用其中已 ref 的副本，每帧只设置尺寸/平移等变换。
+    // 仅在 UI 线程(构建场景时)使用；淘汰原型不影响仍在场景中或被 Instance 持有的副本。
+    class TextureCache {
+    public:
+        enum class Type : uint8_t {
+            RadialGlow,     // 中心颜色 -> 边缘透明的径向光晕，alpha = (1 - d/maxr)^falloff
+        };
+
+        struct Key {
+            Type type = Type::RadialGlow;
+            uint16_t width = 0;
+            uint16_t height = 0;
+            Color color;
+            float falloff = 2.0f;
+
+            bool operator==(const Key& o) const {
+                return type == o.type && width == o.width && height == o.height &&
+                    color.r == o.color.r && color.g == o.color.g && color.b == o.color.b &&
+                    color.a == o.color.a && falloff == o.falloff;
+            }
+        };
+
+        // 单个纹理实例: 持有引用的副本小池，逐帧复用同一 Picture 以保留其渲染数据(GL 纹理不重复上传)；
+        // 一个 Picture 同时只能挂在一个场景下，故池中留出上一帧快照仍占用的份额
+        class Instance {
+        public:
+            Instance() = default;
+            Instance(const Instance&) = delete;
+            Instance& operator=(const Instance&) = delete;
+            ~Instance() { release(); }
+
+            // 返回本帧可 push 的 Picture(调用者不持有)，参数变化时换用新纹理；失败返回 nullptr
+            tvg::Picture* get(TextureCache& cache, const Key& k) {
+                if (!hasKey || !(key == k)) {
+                    release();
+                    key = k;
+                    hasKey = true;
+                }
+                std::lock_guard<std::mutex> lock(textEngineMutex());   // parent()/引用计数与渲染线程释放旧场景互斥
+                for (auto* pic : pool) {
+                    if (!pic->parent()) return pic;
+                }
+                auto pic = cache.acquire(key);
+                if (pic && pool.size() < PICTURES_PER_INSTANCE) {
+                    pic->ref();
+                    pool.push_back(pic);
+                }
+                return pic;
+            }
+
+            // 放弃本地引用，仍在场景中的副本随场景销毁
+            void release() {
+                std::lock_guard<std::mutex> lock(textEngineMutex());
+                for (auto* pic : pool) pic->unref();
+                pool.clear();
+                hasKey = false;
+            }
+
+        private:
+            static constexpr size_t PICTURES_PER_INSTANCE = 3;   // 构建中 + 渲染线程持有 + 画布中尚未替换的帧
+            std::vector<tvg::Picture*> pool;
+            Key key;
+            bool hasKey = false;
+        };
+
+        ~TextureCache() { clear(); }
+
+        // 默认实例是函数内静态对象，析构晚于 tvg::Initializer::term()；
+        // Application::run() 退出时先 clear() 释放原型，析构时已无 Paint 可释放
+        static TextureCache& getDefault() {
+            static TextureCache cache;
+            return cache;
+        }
+
+        // 返回调用者持有的新 Picture(共享缓存像素)，失败返回 nullptr
+        tvg::Picture* acquire(const Key& key) {
+            Entry* e = find(key);
+            if (!e) return nullptr;
+            e->lastUsed = ++useCounter;
+            return static_cast<tvg::Picture*>(e->proto->duplicate());
+        }
+
+        static Key radialGlowKey(int w, int h, const Color& c, float falloff = 2.0f) {
+            Key key;
+            key.type = Type::RadialGlow;
+            key.width = static_cast<uint16_t>(std::clamp(w, 1, 4096));
+            key.height = static_cast<uint16_t>(std::clamp(h, 1, 4096));
+            key.color = c;
+            key.falloff = falloff;
+            return key;
+        }
+
+        tvg::Picture* radialGlow(int w, int h, const Color& c, float falloff = 2.0f) {
+            return acquire(radialGlowKey(w, h, c, falloff));
+        }
+
+        // 逐帧绘制用: 复用 inst 持有的 Picture，返回值由 inst 管理
+        tvg::Picture* radialGlow(Instance& inst, int w, int h, const Color& c, float falloff = 2.0f) {
+            return inst.get(*this, radialGlowKey(w, h, c, falloff));
+        }
+
+        void setCapacity(size_t n) { capacity = std::max<size_t>(1, n); trim(); }
+        size_t size() const { return entries.size(); }
+        uint32_t generatedCount() const { return generated; }
+
+        void clear() {
+            for (auto& kv : entries) kv.second.proto->unref();
+            entries.clear();
+        }
+
+        // 生成 ABGR8888S (非预乘) 像素，由 ThorVG 加载时预乘；也供需要直接访问位图的场合使用
+        static void generate(const Key& key, std::vector<uint32_t>& out) {
+            const int w = key.width, h = key.height;
+            out.resize(static_cast<size_t>(w) * h);
+            if (key.type == Type::RadialGlow) {
+                const uint32_t rgb = (static_cast<uint32_t>(key.color.b) << 16) |
+                    (static_cast<uint32_t>(key.color.g) << 8) | key.color.r;
+                float cx = w * 0.5f;
+                float cy = h * 0.5f;
+                float invMaxr = 1.0f / std::sqrt(cx * cx + cy * cy);
+                for (int y = 0; y < h; ++y) {
+                    float dy = y - cy;
+                    for (int x = 0; x < w; ++x) {
+                        float dx = x - cx;
+                        float t = std::clamp(1.0f - std::sqrt(dx * dx + dy * dy) * invMaxr, 0.0f, 1.0f);
+                        float alpha = (key.falloff == 2.0f) ? t * t : std::pow(t, key.falloff);
+                        uint32_t a = static_cast<uint32_t>(alpha * key.color.a + 0.5f);
+                        out[static_cast<size_t>(y) * w + x] = (a << 24) | rgb;
+                    }
+                }
+            }
+        }
+
+    private:
+        struct KeyHash {
+            size_t operator()(const Key& k) const {
+                uint64_t v = (static_cast<uint64_t>(k.type) << 56) ^
+                    (static_cast<uint64_t>(k.width) << 40) ^ (static_cast<uint64_t>(k.height) << 24) ^
+                    (static_cast<uint64_t>(k.color.r) << 24 | k.color.g << 16 | k.color.b << 8 | k.color.a);
+                uint32_t f;
+                memcpy(&f, &k.falloff, sizeof(f));
+                return std::hash<uint64_t>()(v * 0x9E3779B97F4A7C15ull ^ f);
+            }
+        };
+
+        struct Entry {
+            tvg::Picture* proto = nullptr;  // 已 ref()，像素由 ThorVG 持有(copy=true)并在副本间共享
+            uint64_t lastUsed = 0;
+        };
+
+        std::unordered_map<Key, Entry, KeyHash> entries;
+        size_t capacity = 32;
+        uint64_t useCounter = 0;
+        uint32_t generated = 0;
+        std::vector<uint32_t> scratch;      // 生成用临时缓冲(复用容量)
+
+        Entry* find(const Key& key) {
+            auto it = entries.find(key);
+            if (it != entries.end()) return &it->second;
+
+            generate(key, scratch);
+            auto pic = tvg::Picture::gen();
+            if (pic->load(scratch.data(), key.width, key.height, tvg::ColorSpace::ABGR8888S, true)
+                != tvg::Result::Success) {
+                ODD(L"[TextureCache] 纹理加载失败 %ux%u\n", key.width, key.height);
+                pic->unref();
+                return nullptr;
+            }
+            pic->ref();
+            ++generated;
+            trim(1);
+            return &entries.emplace(key, Entry{ pic, 0 }).first->second;
+        }
+
+        // 淘汰最久未使用的原型，为即将插入的 reserve 个条目腾出空间
+        void trim(size_t reserve = 0) {
+            while (!entries.empty() && entries.size() + reserve > capacity) {
+                auto victim = entries.begin();
+                for (auto it = entries.begin(); it != entries.end(); ++it) {
+                    if (it->second.lastUsed < victim->second.lastUsed) victim = it;
+                }
+                victim->second.proto->unref();
+                entries.erase(victim);
+            }
+        }
+    };
+}
+
 // UIElement 类  
 namespace MUI {
 
+    // 图层缓存: 子树光栅化到离屏位图后，每帧只需合成该位图
+    struct LayerCache {
+        std::vector<uint32_t> pixels;   // ABGR8888S (非预乘) 像素
+        std::vector<uint32_t> retired;  // 上一代像素: 渲染线程可能仍在光栅化引用它的上一帧
+        uint32_t width = 0;
+        uint32_t height = 0;
+        float originX = 0.0f;           // 位图左上角对应的画布坐标
+        float originY = 0.0f;
+        Rect cachedRect;                // 生成缓存时的元素矩形，发生变化即重建
+        bool dirty = true;
+        bool unavailable = false;       // 离屏光栅化失败过(如未编译软件渲染引擎)，之后直接渲染
+
+        void release() {
+            std::vector<uint32_t>().swap(pixels);
+            std::vector<uint32_t>().swap(retired);
+            width = height = 0;
+            dirty = true;
+        }
+    };
+
+    // 离屏光栅化: 把 paint(接管所有权)用软件渲染器绘制到新分配的 w×h ABGR8888S 缓冲
+    // 成功时与 out 交换，out 原有内容随之释放；失败(如未编译软件渲染引擎)返回 false
+    inline bool rasterizeOffscreen(tvg::Paint* paint, uint32_t w, uint32_t h, std::vector<uint32_t>& out) {
+        if (!paint) return false;
+        if (w == 0 || h == 0) {
+            paint->unref();
+            return false;
+        }
+
+        std::unique_ptr<tvg::SwCanvas> sw(tvg::SwCanvas::gen());
+        if (!sw) {
+            paint->unref();
+            return false;
+        }
+
+        // 先分配新缓冲，保证像素地址变化，避免 ThorVG 按地址命中旧纹理
+        std::vector<uint32_t> buffer(static_cast<size_t>(w) * h, 0);
+        if (sw->target(buffer.data(), w, w, h, tvg::ColorSpace::ABGR8888S) != tvg::Result::Success) {
+            paint->unref();
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(textEngineMutex());
+        sw->push(paint);
+        const bool drawn = sw->draw(true) == tvg::Result::Success;
+        if (drawn) sw->sync();
+        sw.reset();     // 连同 paint 在锁内释放
+        if (!drawn) return false;
+
+        out.swap(buffer);
+        return true;
+    }
+
     class UIElement {
     public:
         Rect rect{ 0.0f, 0.0f, 100.0f, 30.0f };
@@ -1300,11 +3112,31 @@ namespace MUI {
 		std::string fontName = u8"siyuan.ttf";// 默认字体
         float fontSize = 12.0f;
 
+        UIElement* parentElement = nullptr;   // 所在容器(由 UIFrame::addChild 设置)，用于向上传播图层失效
+
         virtual ~UIElement() = default;
 
         // 渲染接口(即时模式)  
         virtual void render(tvg::Scene* parent) = 0;
 
+        // 容器统一通过 draw 渲染子元素：启用图层缓存时合成离屏位图，否则直接 render
+        void draw(tvg::Scene* parent);
+
+        // 图层缓存(可选): 适合边框、按钮背景、静态标签等很少变化的子树
+        void setCacheAsLayer(bool enable) {
+            cacheAsLayer = enable;
+            if (enable) layer.dirty = true;
+            else layer.release();
+        }
+        bool isCacheAsLayer() const { return cacheAsLayer; }
+
+        // 标记自身及所有祖先的缓存失效；缓存子树内的控件状态变化后需调用
+        void invalidateLayer() {
+            for (UIElement* e = this; e; e = e->parentElement) {
+                e->layer.dirty = true;
+            }
+        }
+
         // 事件处理(简化命名)  
         virtual bool hitTest(float px, float py) {
             return rect.contains(px, py);
@@ -1316,14 +3148,86 @@ namespace MUI {
         virtual void onKDown(int keyCode) {}
         virtual void onKUp(int keyCode) {}
         virtual void onChar(wchar_t character) {}
+        // 批量文本输入(粘贴等)，默认逐字符转发；文本控件可重写为一次性插入
+        virtual void onText(const std::wstring& str) {
+            for (wchar_t ch : str) onChar(ch);
+        }
         virtual void onFocus(bool focused) {}
         virtual void onSize(int w, int h) {}
 
         // 动画/定时器更新  
         virtual void update(float deltaTime) {}
+
+    protected:
+        bool cacheAsLayer = false;
+        LayerCache layer;
+
+        bool rebuildLayer();
     };
 
-    // UIElement 实现(无需额外实现,全部为虚函数)  
+    // UIElement 实现  
+    void UIElement::draw(tvg::Scene* parent) {
+        if (!cacheAsLayer || layer.unavailable) {
+            render(parent);
+            return;
+        }
+
+        const Rect& r = layer.cachedRect;
+        if (layer.dirty || layer.pixels.empty() ||
+            r.x != rect.x || r.y != rect.y || r.w != rect.w || r.h != rect.h) {
+            if (!rebuildLayer()) {
+                // 离屏光栅化不可用(如未编译软件渲染引擎)时退回直接渲染；
+                // rebuildLayer 失败前已渲染过一次子树，记下失败，之后不再每帧重复尝试
+                render(parent);
+                return;
+            }
+        }
+
+        auto pic = tvg::Picture::gen();
+        auto result = pic->load(layer.pixels.data(), layer.width, layer.height,
+            tvg::ColorSpace::ABGR8888S, false);  // 不复制,直接引用缓存像素
+
+        if (result == tvg::Result::Success) {
+            pic->translate(layer.originX, layer.originY);
+            parent->push(pic);
+        }
+        else {
+            pic->unref();
+            render(parent);
+        }
+    }
+
+    bool UIElement::rebuildLayer() {
+        if (rect.w <= 0.0f || rect.h <= 0.0f) return false;
+
+        // 四周预留边距，避免描边与抗锯齿像素被裁掉
+        const float margin = 2.0f;
+        float ox = std::floor(rect.x - margin);
+        float oy = std::floor(rect.y - margin);
+        uint32_t w = static_cast<uint32_t>(std::ceil(rect.x + rect.w + margin - ox));
+        uint32_t h = static_cast<uint32_t>(std::ceil(rect.y + rect.h + margin - oy));
+
+        auto sub = tvg::Scene::gen();
+        render(sub);
+        sub->translate(-ox, -oy);
+
+        std::vector<uint32_t> buffer;
+        if (!rasterizeOffscreen(sub, w, h, buffer)) {
+            layer.unavailable = true;
+            return false;
+        }
+
+        // 旧像素保留一代再释放(buffer 离开作用域时释放更早的一代)
+        layer.retired.swap(layer.pixels);
+        layer.pixels.swap(buffer);
+        layer.width = w;
+        layer.height = h;
+        layer.originX = ox;
+        layer.originY = oy;
+        layer.cachedRect = rect;
+        layer.dirty = false;
+        return true;
+    }
 
 } // namespace MUI  
 
@@ -1343,6 +3247,28 @@ namespace MUI {
         UIElement* hoveredElement = nullptr;
         UIElement* pressedElement = nullptr;
         UIElement* focusedElement = nullptr;
+        UIElement* overlay = nullptr;      // 不持有，绘制在所有元素之上且不参与事件分发
+
+    public:
+        // 每帧渲染统计
+        struct FrameStats {
+            uint32_t paintCount = 0;        // 场景树中的 Paint 总数(含嵌套 Scene)，仅 setCountPaints(true) 时统计
+            uint32_t batchedPrimitives = 0; // 经 ShapeBatch 合并的图元数
+            uint32_t batchedShapes = 0;     // 合并后生成的 Shape 数
+            float buildMs = 0.0f;           // 构建场景树耗时
+            float drawMs = 0.0f;            // update + draw + sync 耗时
+            uint32_t arenaAllocations = 0;  // 上一帧从 FrameArena 分配的次数
+            uint32_t arenaUpstreamBlocks = 0; // 上一帧 FrameArena 溢出到堆的块数
+            size_t arenaBytes = 0;          // 上一帧从 FrameArena 分配的字节数
+        };
+
+    private:
+        FrameStats frameStats;              // 构建部分，仅 UI 线程写入
+        std::atomic<float> lastDrawMs{ 0.0f };  // 光栅化部分，可能由渲染线程写入
+        bool deferCanvasResize = false;     // 渲染线程模式下画布尺寸由渲染线程调用 resizeCanvas 同步
+        bool countPaintsEnabled = false;    // 统计 Paint 数需要遍历整棵场景树，默认关闭
+
+        static uint32_t countPaints(const tvg::Scene* s);
 
     public:
         UIManager();
@@ -1351,13 +3277,28 @@ namespace MUI {
         bool init(void* glContext, int w, int h);
         void update(float deltaTime);
         void render();      
+
+        // 拆分渲染: UI 线程 buildFrame 生成场景快照，持有 GL 上下文的线程 present 光栅化。
+        // 快照与 UI 元素不共享 Paint；以 copy=false 引用像素的元素需保证像素多存活一帧。
+        tvg::Scene* buildFrame();
+        void present(tvg::Scene* frame);
+        void resizeCanvas(int w, int h);
+        void setDeferCanvasResize(bool defer) { deferCanvasResize = defer; }
+        // 开启后每帧遍历场景树填充 FrameStats::paintCount(调试/性能面板用)
+        void setCountPaints(bool enable) { countPaintsEnabled = enable; }
         void resize(int w, int h);
         void clear();
 
         void addElement(std::unique_ptr<UIElement> element);
         void removeElement(UIElement* element);
+        void setOverlay(UIElement* element) { overlay = element; }
         void setFocus(UIElement* element);
         UIElement* getFocus() const { return focusedElement; }
+        FrameStats getFrameStats() const {
+            FrameStats s = frameStats;
+            s.drawMs = lastDrawMs.load(std::memory_order_relaxed);
+            return s;
+        }
 
         void handleMDown(int x, int y);
         void handleMUp(int x, int y);
@@ -1366,6 +3307,7 @@ namespace MUI {
         void handleKDown(int keyCode);
         void handleKUp(int keyCode);
         void handleChar(wchar_t character);
+        void handleText(const std::wstring& str);
         void handleSize(int w, int h);
 
         tvg::GlCanvas* getCanvas() const { return canvas.get(); }
@@ -1416,20 +3358,92 @@ namespace MUI {
         }
     }
 
+    uint32_t UIManager::countPaints(const tvg::Scene* s) {
+        uint32_t n = 0;
+        for (auto* p : s->paints()) {
+            ++n;
+            if (p->type() == tvg::Type::Scene) {
+                n += countPaints(static_cast<const tvg::Scene*>(p));
+            }
+        }
+        return n;
+    }
+
     void UIManager::render() {
         if (!scene || !canvas) return;
+        present(buildFrame());
+    }
 
-        scene->remove(nullptr);
+    tvg::Scene* UIManager::buildFrame() {
+        auto t0 = std::chrono::steady_clock::now();
+        ShapeBatch::framePrimitives = 0;
+        ShapeBatch::frameShapes = 0;
+
+        // 上一帧的临时分配全部失效
+        FrameArena& arena = FrameArena::get();
+        arena.reset();
+        auto arenaStats = arena.lastFrame();
+        frameStats.arenaAllocations = arenaStats.allocations;
+        frameStats.arenaUpstreamBlocks = arenaStats.upstreamBlocks;
+        frameStats.arenaBytes = arenaStats.bytes;
+
+        auto frame = tvg::Scene::gen();
 
         for (auto& element : elements) {
             if (element->visible) {
-                element->render(scene);
+                element->draw(frame);
+            }
+        }
+        if (overlay && overlay->visible) overlay->draw(frame);
+
+        auto t1 = std::chrono::steady_clock::now();
+
+        frameStats.paintCount = countPaintsEnabled ? countPaints(frame) : 0;
+        frameStats.batchedPrimitives = ShapeBatch::framePrimitives;
+        frameStats.batchedShapes = ShapeBatch::frameShapes;
+        frameStats.buildMs = std::chrono::duration<float, std::milli>(t1 - t0).count();
+        return frame;
+    }
+
+    void UIManager::present(tvg::Scene* frame) {
+        if (!frame) return;
+        if (!canvas) {
+            frame->unref();
+            return;
+        }
+
+        auto t0 = std::chrono::steady_clock::now();
+
+        {
+            // 释放旧快照与 update(文本在此排版、构建字形)须与 UI 线程的字形测量串行
+            std::lock_guard<std::mutex> lock(textEngineMutex());
+
+            // 用新快照替换画布中的旧快照(旧快照随引用计数归零释放)
+            frame->ref();
+            if (scene) {
+                canvas->remove(scene);
+                scene->unref();
+            }
+            scene = frame;
+            canvas->push(scene);
+
+            canvas->update();
+        }
+        canvas->draw(false);
+        canvas->sync();
+
+        auto t1 = std::chrono::steady_clock::now();
+        lastDrawMs.store(std::chrono::duration<float, std::milli>(t1 - t0).count(),
+            std::memory_order_relaxed);
+    }
+
+    void UIManager::resizeCanvas(int w, int h) {
+        if (canvas && glctx && w > 0 && h > 0) {
+            auto r = canvas->target(glctx, 0, (uint32_t)w, (uint32_t)h, tvg::ColorSpace::ABGR8888S);
+            if (r != tvg::Result::Success) {
+                ODD(L"GlCanvas target 重设失败(resizeCanvas): %d\n", (int)r);
             }
         }
-
-        canvas->update();
-        canvas->draw(false);
-        canvas->sync();
     }
 
     void UIManager::resize(int w, int h) {
@@ -1554,16 +3568,19 @@ namespace MUI {
         }
     }
 
+    void UIManager::handleText(const std::wstring& str) {
+        if (focusedElement && !str.empty()) {
+            focusedElement->onText(str);
+        }
+    }
+
     void UIManager::handleSize(int w, int h) {
         width = w;
         height = h;
 
-        // ✅ 同步 ThorVG 画布尺寸
-        if (canvas && glctx && w > 0 && h > 0) {
-            auto r = canvas->target(glctx, 0, (uint32_t)w, (uint32_t)h, tvg::ColorSpace::ABGR8888S);
-            if (r != tvg::Result::Success) {
-                ODD(L"GlCanvas target 重设失败(handleSize): %d\n", (int)r);
-            }
+        // ✅ 同步 ThorVG 画布尺寸(渲染线程模式下由渲染线程同步)
+        if (!deferCanvasResize) {
+            resizeCanvas(w, h);
         }
         for (auto& element : elements) {
             element->onSize(w, h);
@@ -1575,6 +3592,12 @@ namespace MUI {
 // Renderer3D 类  
 namespace MUI {
 
+    // 实例化绘制的单个实例: 模型矩阵 + 颜色(与实例缓冲布局一致)
+    struct Instance3D {
+        glm::mat4 model = glm::mat4(1.0f);
+        glm::vec4 color = glm::vec4(1.0f);
+    };
+
     class Renderer3D {
     private:
         int width = 800;
@@ -1585,6 +3608,24 @@ namespace MUI {
         GLuint vao = 0;
         GLuint vbo = 0;
         GLuint ebo = 0;
+        GLint mvpLoc = -1;              // uniform 位置在链接后缓存，render() 不再查询
+
+        // 实例化批量绘制: 共用立方体网格，每实例矩阵/颜色放在流式实例缓冲中，一次 DrawElementsInstanced
+        GLuint instProgram = 0;
+        GLuint instVao = 0;
+        GLuint instVbo = 0;
+        GLint instViewProjLoc = -1;
+        size_t instCapacity = 0;        // 实例缓冲当前容量(实例数)
+        bool showDemoCube = true;
+
+        // 提交邮箱: 调用线程填 staging 后 commitInstances() 交换到 pending，render() 再交换到 drawing
+        std::vector<Instance3D> stagingInstances;
+        std::vector<Instance3D> pendingInstances;
+        std::vector<Instance3D> drawingInstances;
+        std::mutex instanceMutex;
+        bool instancesPending = false;
+        bool instancesDirty = false;    // drawing 尚未上传到 GPU
+        uint32_t lastInstanceDraws = 0;
 
         glm::mat4 projection = glm::mat4(1.0f);
         glm::mat4 view = glm::mat4(1.0f);
@@ -1599,10 +3640,14 @@ namespace MUI {
 
         static const char* vs_src;
         static const char* fs_src;
+        static const char* inst_vs_src;
 
         static GLuint compileShader(GLenum type, const char* src);
+        static GLuint linkProgram(const char* vsSrc, const char* fsSrc);
         bool createShaders();
         void createCube();
+        void createInstanceBuffer();
+        void renderInstances(const glm::mat4& viewProj);
 
     public:
         Renderer3D();
@@ -1619,6 +3664,36 @@ namespace MUI {
 
         glm::mat4 getView() const { return view; }
         glm::mat4 getProjection() const { return projection; }
+
+        // 实例化批量绘制(单位立方体 [-1,1]^3)。用法:
+        //   auto& v = r->beginInstances(); v.push_back(...); r->commitInstances();
+        // 可在任意单一线程提交；未再次提交时上一批实例保持显示且不重复上传。
+        std::vector<Instance3D>& beginInstances() {
+            stagingInstances.clear();
+            return stagingInstances;
+        }
+        void commitInstances() {
+            std::lock_guard<std::mutex> lock(instanceMutex);
+            pendingInstances.swap(stagingInstances);
+            instancesPending = true;
+        }
+        void clearInstances() {
+            beginInstances();
+            commitInstances();
+        }
+        // 便捷: 平移 + 缩放的实例(频谱柱等)，不做矩阵乘法
+        static Instance3D makeInstance(const glm::vec3& pos, const glm::vec3& scale, const glm::vec4& color) {
+            Instance3D inst;
+            inst.model[0][0] = scale.x;
+            inst.model[1][1] = scale.y;
+            inst.model[2][2] = scale.z;
+            inst.model[3] = glm::vec4(pos, 1.0f);
+            inst.color = color;
+            return inst;
+        }
+
+        void setDemoCubeVisible(bool v) { showDemoCube = v; }
+        uint32_t getLastInstanceCount() const { return lastInstanceDraws; }
     };
 
     // Renderer3D 静态成员  
@@ -1641,6 +3716,21 @@ out vec4 FragColor;
 void main() {  
     FragColor = vec4(vColor, 1.0);  
 }  
+)";
+
+    // 实例化顶点着色器: 位置 2..5 为实例模型矩阵各列，6 为实例颜色(除数 1)
+    const char* Renderer3D::inst_vs_src = R"(  
+#version 460 core  
+layout(location = 0) in vec3 aPos;  
+layout(location = 2) in mat4 iModel;  
+layout(location = 6) in vec4 iColor;  
+uniform mat4 uViewProj;  
+out vec3 vColor;  
+void main() {  
+    // 沿立方体高度做简单明暗，避免额外法线数据
+    vColor = iColor.rgb * mix(0.55, 1.0, aPos.y * 0.5 + 0.5);  
+    gl_Position = uViewProj * iModel * vec4(aPos, 1.0);  
+}  
 )";
 
     Renderer3D::Renderer3D() {}
@@ -1655,6 +3745,7 @@ void main() {
 
         if (!createShaders()) return false;
         createCube();
+        createInstanceBuffer();
 
         projection = glm::perspective(glm::radians(fov),
             (float)width / (float)height,
@@ -1680,18 +3771,58 @@ void main() {
     void Renderer3D::render() {
         if (!program || !vao) return;
 
-        glUseProgram(program);
+        glm::mat4 viewProj = projection * view;
 
-        model = glm::mat4(1.0f);
-        model = glm::rotate(model, glm::radians(angle), glm::vec3(0.5f, 1.0f, 0.0f));
+        if (showDemoCube) {
+            glUseProgram(program);
 
-        glm::mat4 mvp = projection * view * model;
-        GLint loc = glGetUniformLocation(program, "uMVP");
-        glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(mvp));
+            model = glm::mat4(1.0f);
+            model = glm::rotate(model, glm::radians(angle), glm::vec3(0.5f, 1.0f, 0.0f));
 
-        glBindVertexArray(vao);
-        glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
+            glm::mat4 mvp = viewProj * model;
+            glUniformMatrix4fv(mvpLoc, 1, GL_FALSE, glm::value_ptr(mvp));
+
+            glBindVertexArray(vao);
+            glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
+            glBindVertexArray(0);
+        }
+
+        renderInstances(viewProj);
+    }
+
+    void Renderer3D::renderInstances(const glm::mat4& viewProj) {
+        {
+            std::lock_guard<std::mutex> lock(instanceMutex);
+            if (instancesPending) {
+                drawingInstances.swap(pendingInstances);
+                instancesPending = false;
+                instancesDirty = true;
+            }
+        }
+
+        lastInstanceDraws = static_cast<uint32_t>(drawingInstances.size());
+        if (!instProgram || !instVao || drawingInstances.empty()) return;
+
+        glBindBuffer(GL_ARRAY_BUFFER, instVbo);
+        if (instancesDirty) {
+            size_t count = drawingInstances.size();
+            if (count > instCapacity) {
+                // 按 1.5 倍增长，减少重新分配
+                instCapacity = std::max(count, instCapacity + instCapacity / 2);
+            }
+            // 孤立旧存储(orphan)后整体写入，避免与 GPU 仍在读取的上一帧数据同步等待
+            glBufferData(GL_ARRAY_BUFFER, instCapacity * sizeof(Instance3D), nullptr, GL_STREAM_DRAW);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(Instance3D), drawingInstances.data());
+            instancesDirty = false;
+        }
+
+        glUseProgram(instProgram);
+        glUniformMatrix4fv(instViewProjLoc, 1, GL_FALSE, glm::value_ptr(viewProj));
+
+        glBindVertexArray(instVao);
+        glDrawElementsInstanced(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0, (GLsizei)drawingInstances.size());
         glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
     }
 
     void Renderer3D::shutdown() {
@@ -1699,6 +3830,12 @@ void main() {
         if (vbo) { glDeleteBuffers(1, &vbo); vbo = 0; }
         if (ebo) { glDeleteBuffers(1, &ebo); ebo = 0; }
         if (program) { glDeleteProgram(program); program = 0; }
+        if (instVao) { glDeleteVertexArrays(1, &instVao); instVao = 0; }
+        if (instVbo) { glDeleteBuffers(1, &instVbo); instVbo = 0; }
+        if (instProgram) { glDeleteProgram(instProgram); instProgram = 0; }
+        instCapacity = 0;
+        instancesDirty = true;
+        mvpLoc = instViewProjLoc = -1;
     }
 
     void Renderer3D::setCamera(const glm::vec3& pos, const glm::vec3& target, const glm::vec3& up) {
@@ -1725,35 +3862,47 @@ void main() {
         return s;
     }
 
-    bool Renderer3D::createShaders() {
-        GLuint vs = compileShader(GL_VERTEX_SHADER, vs_src);
-        if (!vs) return false;
+    GLuint Renderer3D::linkProgram(const char* vsSrc, const char* fsSrc) {
+        GLuint vs = compileShader(GL_VERTEX_SHADER, vsSrc);
+        if (!vs) return 0;
 
-        GLuint fs = compileShader(GL_FRAGMENT_SHADER, fs_src);
+        GLuint fs = compileShader(GL_FRAGMENT_SHADER, fsSrc);
         if (!fs) {
             glDeleteShader(vs);
-            return false;
+            return 0;
         }
 
-        program = glCreateProgram();
-        glAttachShader(program, vs);
-        glAttachShader(program, fs);
-        glLinkProgram(program);
+        GLuint prog = glCreateProgram();
+        glAttachShader(prog, vs);
+        glAttachShader(prog, fs);
+        glLinkProgram(prog);
 
         glDeleteShader(vs);
         glDeleteShader(fs);
 
         GLint linked = 0;
-        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        glGetProgramiv(prog, GL_LINK_STATUS, &linked);
         if (!linked) {
             char buf[512];
-            glGetProgramInfoLog(program, 512, nullptr, buf);
+            glGetProgramInfoLog(prog, 512, nullptr, buf);
             ODD(L"Shader link error: %s\n", buf);
-            glDeleteProgram(program);
-            program = 0;
-            return false;
+            glDeleteProgram(prog);
+            return 0;
         }
 
+        return prog;
+    }
+
+    bool Renderer3D::createShaders() {
+        program = linkProgram(vs_src, fs_src);
+        if (!program) return false;
+        mvpLoc = glGetUniformLocation(program, "uMVP");
+
+        // 实例化程序失败时仅禁用批量绘制，不影响演示立方体
+        instProgram = linkProgram(inst_vs_src, fs_src);
+        if (instProgram) instViewProjLoc = glGetUniformLocation(instProgram, "uViewProj");
+        else ODD(L"Renderer3D: 实例化着色器不可用，批量绘制已禁用\n");
+
         return true;
     }
 
@@ -1793,6 +3942,286 @@ void main() {
         glBindVertexArray(0);
     }
 
+    void Renderer3D::createInstanceBuffer() {
+        if (!instProgram || !vbo || !ebo) return;
+
+        // 第二个 VAO 共用立方体顶点/索引缓冲，另挂实例缓冲
+        glGenVertexArrays(1, &instVao);
+        glBindVertexArray(instVao);
+
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+
+        glGenBuffers(1, &instVbo);
+        glBindBuffer(GL_ARRAY_BUFFER, instVbo);
+        for (int c = 0; c < 4; ++c) {
+            glEnableVertexAttribArray(2 + c);
+            glVertexAttribPointer(2 + c, 4, GL_FLOAT, GL_FALSE, sizeof(Instance3D),
+                (void*)(offsetof(Instance3D, model) + sizeof(glm::vec4) * c));
+            glVertexAttribDivisor(2 + c, 1);
+        }
+        glEnableVertexAttribArray(6);
+        glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Instance3D), (void*)offsetof(Instance3D, color));
+        glVertexAttribDivisor(6, 1);
+
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        instCapacity = 0;
+        instancesDirty = true;
+    }
+
+} // namespace MUI
+
+// FrameProfiler 类  
+namespace MUI {
+
+    // 帧节奏/输入延迟剖析器: 记录输入、各阶段耗时与 SwapBuffers，
+    // 每个指标保留最近 SampleCount 个样本用于 p50/p95/p99，所有事件同时写入定长环形缓冲，
+    // 可导出为 Chrome trace JSON (chrome://tracing / Perfetto) 离线分析。
+    // 写入端无锁(UI 线程与渲染线程可同时记录)；关闭时每次记录只更新该指标的最近值，
+    // Application::getPacingStats 即读取这些最近值，不另行统计。
+    class FrameProfiler {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        enum class Metric : uint8_t {
+            Frame,          // UI 线程一帧(消息处理之后到快照发布/呈现完成)
+            Update,         // UIManager::update
+            Build,          // UIManager::buildFrame
+            Render3D,       // Renderer3D::render
+            Draw,           // UIManager::present (ThorVG 光栅化)
+            Swap,           // SwapBuffers
+            Queue,          // 快照发布到被渲染线程取走
+            InputLatency,   // 输入消息到包含它的帧呈现完成
+            FrameInterval,  // 相邻两次呈现的间隔
+            Input,          // 输入消息(瞬时事件，无样本)
+            Count
+        };
+
+        struct Percentiles {
+            float p50 = 0.0f;
+            float p95 = 0.0f;
+            float p99 = 0.0f;
+            float max = 0.0f;
+            uint32_t samples = 0;
+        };
+
+        static constexpr uint32_t SampleCount = 256;    // 每指标滚动窗口
+        static constexpr uint32_t RingSize = 8192;      // 追踪事件环(2 的幂)
+
+        FrameProfiler() : epoch(Clock::now()), ring(new Event[RingSize]) {}
+
+        void setEnabled(bool enable) { enabled.store(enable, std::memory_order_relaxed); }
+        bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+        static const char* metricName(Metric m) {
+            static const char* names[] = { "Frame", "Update", "Build", "Render3D", "Draw",
+                "Swap", "Queue", "InputLatency", "FrameInterval", "Input" };
+            return m < Metric::Count ? names[static_cast<int>(m)] : "?";
+        }
+
+        // 记录一个区间: 计入该指标的滚动样本并写入追踪环
+        void record(Metric m, Clock::time_point start, Clock::time_point end) {
+            if (m >= Metric::Count) return;
+            float ms = std::chrono::duration<float, std::milli>(end - start).count();
+            Series& s = series[static_cast<int>(m)];
+            s.last.store(ms, std::memory_order_relaxed);
+            if (!isEnabled()) return;
+            uint32_t i = s.written.fetch_add(1, std::memory_order_relaxed);
+            s.values[i % SampleCount].store(ms, std::memory_order_relaxed);
+            push(m, toUs(start), toUs(end) - toUs(start));
+        }
+
+        // 记录瞬时事件(输入消息等)
+        void mark(Metric m, Clock::time_point t) {
+            if (!isEnabled() || m >= Metric::Count) return;
+            push(m, toUs(t), -1);
+        }
+
+        // 作用域计时: FrameProfiler::Scope s(profiler, FrameProfiler::Metric::Update);
+        class Scope {
+        public:
+            Scope(FrameProfiler& p, Metric m) : profiler(p), metric(m), start(Clock::now()) {}
+            ~Scope() { profiler.record(metric, start, Clock::now()); }
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+        private:
+            FrameProfiler& profiler;
+            Metric metric;
+            Clock::time_point start;
+        };
+
+        // 最近一次记录的值(ms)，剖析关闭时同样更新
+        float lastValue(Metric m) const {
+            return m < Metric::Count ? series[static_cast<int>(m)].last.load(std::memory_order_relaxed) : 0.0f;
+        }
+
+        Percentiles getPercentiles(Metric m) const {
+            Percentiles r;
+            if (m >= Metric::Count) return r;
+            const Series& s = series[static_cast<int>(m)];
+            uint32_t n = std::min(s.written.load(std::memory_order_relaxed), SampleCount);
+            if (n == 0) return r;
+
+            float v[SampleCount];
+            for (uint32_t i = 0; i < n; ++i) v[i] = s.values[i].load(std::memory_order_relaxed);
+            std::sort(v, v + n);
+            auto at = [&](float q) { return v[static_cast<uint32_t>(q * (n - 1) + 0.5f)]; };
+            r.p50 = at(0.50f);
+            r.p95 = at(0.95f);
+            r.p99 = at(0.99f);
+            r.max = v[n - 1];
+            r.samples = n;
+            return r;
+        }
+
+        void reset() {
+            for (auto& s : series) s.written.store(0, std::memory_order_relaxed);
+            for (uint32_t i = 0; i < RingSize; ++i) ring[i].seq.store(0, std::memory_order_relaxed);
+            head.store(0, std::memory_order_relaxed);
+        }
+
+        // 导出环中现存事件为 Chrome trace JSON
+        bool exportChromeTrace(const std::wstring& path) const {
+            FILE* f = nullptr;
+            if (_wfopen_s(&f, path.c_str(), L"wb") != 0 || !f) {
+                ODD(L"[FrameProfiler] 无法写入: %ls\n", path.c_str());
+                return false;
+            }
+
+            fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", f);
+            fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"MUI\"}}");
+
+            uint64_t end = head.load(std::memory_order_acquire);
+            uint64_t begin = end > RingSize ? end - RingSize : 0;
+            uint32_t exported = 0;
+            for (uint64_t i = begin; i < end; ++i) {
+                const Event& e = ring[i & (RingSize - 1)];
+                uint64_t s1 = e.seq.load(std::memory_order_acquire);
+                if (s1 != (i + 1) * 2) continue;        // 已被覆盖或仍在写入
+                int metric = e.metric.load(std::memory_order_relaxed);
+                uint32_t tid = e.tid.load(std::memory_order_relaxed);
+                int64_t ts = e.startUs.load(std::memory_order_relaxed);
+                int64_t dur = e.durUs.load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (e.seq.load(std::memory_order_relaxed) != s1) continue;
+
+                const char* name = metricName(static_cast<Metric>(metric));
+                if (dur < 0) {
+                    fprintf(f, ",\n{\"name\":\"%s\",\"cat\":\"mui\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%lld,\"pid\":1,\"tid\":%u}",
+                        name, (long long)ts, tid);
+                }
+                else {
+                    fprintf(f, ",\n{\"name\":\"%s\",\"cat\":\"mui\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,\"pid\":1,\"tid\":%u}",
+                        name, (long long)ts, (long long)dur, tid);
+                }
+                ++exported;
+            }
+            fputs("\n]}\n", f);
+            bool ok = ferror(f) == 0;
+            fclose(f);
+            ODD(L"[FrameProfiler] 导出 %u 个事件: %ls\n", exported, path.c_str());
+            return ok;
+        }
+
+    private:
+        struct Series {
+            std::atomic<float> values[SampleCount] = {};
+            std::atomic<uint32_t> written{ 0 };
+            std::atomic<float> last{ 0.0f };
+        };
+
+        // 环形缓冲槽位: seq 为 0 表示空，奇数表示写入中，(序号+1)*2 表示序号对应事件已写完
+        struct Event {
+            std::atomic<uint64_t> seq{ 0 };
+            std::atomic<uint8_t> metric{ 0 };
+            std::atomic<uint32_t> tid{ 0 };
+            std::atomic<int64_t> startUs{ 0 };
+            std::atomic<int64_t> durUs{ 0 };    // < 0 表示瞬时事件
+        };
+
+        std::atomic<bool> enabled{ false };
+        Clock::time_point epoch;
+        Series series[static_cast<int>(Metric::Count)];
+        std::atomic<uint64_t> head{ 0 };
+        std::unique_ptr<Event[]> ring;     // 堆上分配，Application 常作为栈对象
+
+        int64_t toUs(Clock::time_point t) const {
+            return std::chrono::duration_cast<std::chrono::microseconds>(t - epoch).count();
+        }
+
+        void push(Metric m, int64_t startUs, int64_t durUs) {
+            uint64_t i = head.fetch_add(1, std::memory_order_relaxed);
+            Event& e = ring[i & (RingSize - 1)];
+            e.seq.store(i * 2 + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            e.metric.store(static_cast<uint8_t>(m), std::memory_order_relaxed);
+            e.tid.store(static_cast<uint32_t>(GetCurrentThreadId()), std::memory_order_relaxed);
+            e.startUs.store(startUs, std::memory_order_relaxed);
+            e.durUs.store(durUs, std::memory_order_relaxed);
+            e.seq.store((i + 1) * 2, std::memory_order_release);
+        }
+    };
+
+    // 剖析叠加层: 由 Application::setProfilerOverlay 挂到 UIManager，绘制在所有元素之上
+    class ProfilerOverlay : public UIElement {
+    public:
+        explicit ProfilerOverlay(const FrameProfiler& p) : profiler(p) {
+            rect = { 8.0f, 8.0f, 330.0f, 0.0f };
+        }
+
+        void render(tvg::Scene* parent) override {
+            if (!visible) return;
+
+            // 文本每 250ms 刷新一次，避免数字跳动且不必每帧排序样本
+            auto now = FrameProfiler::Clock::now();
+            if (lines.empty() || now - lastRefresh > std::chrono::milliseconds(250)) {
+                refresh();
+                lastRefresh = now;
+            }
+
+            float lineH = fontSize + 4.0f;
+            rect.h = lineH * lines.size() + 8.0f;
+
+            auto bg = tvg::Shape::gen();
+            bg->appendRect(rect.x, rect.y, rect.w, rect.h, 4.0f, 4.0f);
+            bg->fill(0, 0, 0, 170);
+            parent->push(bg);
+
+            float y = rect.y + 4.0f;
+            for (const auto& line : lines) {
+                auto t = tvg::Text::gen();
+                t->font(fontName.c_str());
+                t->size(fontSize);
+                t->text(line.c_str());
+                t->fill(200, 255, 200);
+                t->translate(rect.x + 6.0f, y);
+                parent->push(t);
+                y += lineH;
+            }
+        }
+
+    private:
+        const FrameProfiler& profiler;
+        std::vector<std::string> lines;
+        FrameProfiler::Clock::time_point lastRefresh;
+
+        void refresh() {
+            lines.clear();
+            lines.emplace_back("metric          p50     p95     p99 (ms)");
+            for (int i = 0; i < static_cast<int>(FrameProfiler::Metric::Input); ++i) {
+                auto m = static_cast<FrameProfiler::Metric>(i);
+                auto p = profiler.getPercentiles(m);
+                if (p.samples == 0) continue;
+                char buf[96];
+                snprintf(buf, sizeof(buf), "%-14s %6.2f  %6.2f  %6.2f", FrameProfiler::metricName(m), p.p50, p.p95, p.p99);
+                lines.emplace_back(buf);
+            }
+        }
+    };
+
 } // namespace MUI
 
 // Application 类  
@@ -1808,9 +4237,59 @@ namespace MUI {
         uint32_t height = 600;
         bool running = false;
 
+        // 定时器轮须先于 UI 声明(后析构)：UI 元素析构时 Timer 会从轮上注销
+        TimerWheel timerWheel;          // 全局定时器/动画时钟
+        bool idleWait = false;          // true: 无动画时阻塞到下一个定时器或消息
+
         std::unique_ptr<UIManager> uiManager;
         std::unique_ptr<Renderer3D> renderer3D;
 
+        // 渲染线程: UI 线程构建场景快照，渲染线程光栅化 + SwapBuffers
+        using Clock = std::chrono::steady_clock;
+
+        struct FrameSnapshot {
+            tvg::Scene* scene = nullptr;
+            Clock::time_point publishTime;
+            Clock::time_point inputTime;    // 该帧包含的最早输入时刻(无输入时为默认值)
+        };
+
+        bool threadedRendering = false;
+        std::thread renderThread;
+        std::atomic<bool> renderRunning{ false };
+        std::mutex frameMutex;
+        std::condition_variable frameCv;
+        FrameSnapshot pendingFrame;     // 单槽邮箱: UI 线程写入，渲染线程取走
+        HANDLE frameSlotEvent = nullptr;// 渲染线程取走快照后置位，UI 线程据此继续
+        std::atomic<uint32_t> pendingSize{ 0 };  // (w << 16) | h，0 表示无待处理的尺寸变化
+
+        // 输入延迟与帧节奏(与光栅化耗时分开统计)
+        bool inputPending = false;
+        Clock::time_point firstPendingInput;
+        Clock::time_point lastPresent;
+        std::atomic<float> statPresentMs{ 0.0f };   // 其余节奏指标取自 profiler 的最近值
+
+        // 内存映射加载的字体: ThorVG 以 copy=false 直接引用映射视图，卸载字体后才能解除映射
+        struct MappedFont {
+            std::string name;
+            HANDLE file = INVALID_HANDLE_VALUE;
+            HANDLE mapping = nullptr;
+            const void* view = nullptr;
+        };
+        std::vector<MappedFont> mappedFonts;
+
+        // 字形预热: 按块排队，主循环每帧在时间预算内处理，提前构建字形轮廓
+        struct GlyphPrewarmJob {
+            std::string font;
+            float size = 16.0f;
+            std::string text;           // 一块去重后的字符(UTF-8)
+        };
+        std::deque<GlyphPrewarmJob> prewarmJobs;
+        std::set<std::pair<std::string, uint32_t>> prewarmedGlyphs;   // (字体, 码点) 已排队过的字形
+        std::vector<tvg::Text::TextGlyphInfo> prewarmScratch;
+
+        FrameProfiler profiler;         // 可选的分阶段计时/追踪(默认关闭)
+        std::unique_ptr<ProfilerOverlay> profilerOverlay;
+
         static Application* instance;
 
         static LRESULT CALLBACK StaticWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
@@ -1819,28 +4298,80 @@ namespace MUI {
         bool createWindow(const wchar_t* title);
         bool createGLContext();
 
+        bool pumpMessages();
+        void renderFrame(float deltaTime);
+        void drawFrame(tvg::Scene* frame);
+        void startRenderThread();
+        void stopRenderThread();
+        void renderLoop();
+        bool waitForFrameSlot();
+        void recordPresent(Clock::time_point inputTime, Clock::time_point presentStart);
+        void processGlyphPrewarm(float budgetMs);
+        void unloadMappedFonts();
+
     public:
         Application();
         ~Application();
 
         bool init(const wchar_t* title, int w, int h, int canvasType = 1);
         bool loadFontFromResource(int resourceId, const char* fontName);
+        // 从磁盘内存映射加载字体(不复制到堆)，映射在程序退出前一直保留
+        bool loadFontFromFile(const std::wstring& path, const char* fontName);
+
+        // 字形预热: 把 chars 中尚未预热过的字符排队，主循环每帧用少量时间(默认 2ms)
+        // 构建其轮廓，避免首次显示大量新 CJK 字符的那一帧卡顿。例如传入整个播放列表的标题/艺术家。
+        void prewarmGlyphs(const char* fontName, float fontSize, const std::wstring& chars);
+        size_t pendingGlyphPrewarm() const { return prewarmJobs.size(); }
 
         void run();
         void quit();
 
+        // 空闲等待: 开启后主循环在没有活动动画时阻塞，直到有消息或下一个定时器到期。
+        // 持续变化的界面(播放进度、歌词滚动等)应通过 TimerWheel::beginAnimation 声明动画。
+        void setIdleWait(bool enable) { idleWait = enable; }
+
+        // 渲染线程模式: 需在 run() 之前设置。开启后 Renderer3D 的 update/render 均在渲染线程执行。
+        void setThreadedRendering(bool enable) { threadedRendering = enable; }
+
+        struct PacingStats {
+            float inputLatencyMs = 0.0f;   // 输入到包含它的帧 SwapBuffers 完成
+            float frameIntervalMs = 0.0f;  // 相邻两次呈现的间隔
+            float queueMs = 0.0f;          // 快照发布到被渲染线程取走
+            float presentMs = 0.0f;        // 光栅化 + SwapBuffers
+        };
+
+        PacingStats getPacingStats() const {
+            PacingStats s;
+            s.inputLatencyMs = profiler.lastValue(FrameProfiler::Metric::InputLatency);
+            s.frameIntervalMs = profiler.lastValue(FrameProfiler::Metric::FrameInterval);
+            s.queueMs = profiler.lastValue(FrameProfiler::Metric::Queue);
+            s.presentMs = statPresentMs.load(std::memory_order_relaxed);
+            return s;
+        }
+
+        // 分阶段剖析: 开启后记录输入、update/build/draw/SwapBuffers 等阶段，
+        // 通过 getProfiler().getPercentiles() 读取 p50/p95/p99，exportChromeTrace() 导出追踪
+        void setProfiling(bool enable) { profiler.setEnabled(enable); }
+        void setProfilerOverlay(bool show);
+        FrameProfiler& getProfiler() { return profiler; }
+
         HWND getHwnd() const { return hwnd; }
         UIManager* getUIManager() const { return uiManager.get(); }
         Renderer3D* getRenderer3D() const { return renderer3D.get(); }
+        TimerWheel& getTimerWheel() { return timerWheel; }
     };
 
     Application* Application::instance = nullptr;
 
     Application::Application() {
         instance = this;
+        TimerWheel::setDefault(&timerWheel);
     }
 
     Application::~Application() {
+        uiManager.reset();              // run() 未执行时同样须先于字体映射释放
+        profilerOverlay.reset();
+        unloadMappedFonts();
         if (hglrc) {
             wglMakeCurrent(nullptr, nullptr);
             wglDeleteContext(hglrc);
@@ -1848,6 +4379,7 @@ namespace MUI {
         if (hdc) ReleaseDC(hwnd, hdc);
         if (hwnd) DestroyWindow(hwnd);
 
+        if (TimerWheel::getDefault() == &timerWheel) TimerWheel::setDefault(nullptr);
         instance = nullptr;
     }
 
@@ -1867,6 +4399,7 @@ namespace MUI {
         }
 
         uiManager = std::make_unique<UIManager>();
+        if (profilerOverlay) uiManager->setOverlay(profilerOverlay.get());  // init 之前调用过 setProfilerOverlay(true)
 
         // ✅ 获取 OpenGL 上下文并传递  
         void* glContext = wglGetCurrentContext();
@@ -1875,116 +4408,430 @@ namespace MUI {
             return false;
         }
 
-        if (!uiManager->init(glContext, w, h)) {
-            ODD(L"UIManager 初始化失败\n");
-            return false;
-        }
+        if (!uiManager->init(glContext, w, h)) {
+            ODD(L"UIManager 初始化失败\n");
+            return false;
+        }
+
+        if (renderer3D) {
+            if (!renderer3D->initialize(w, h)) {
+                ODD(L"Renderer3D 初始化失败\n");
+                return false;
+            }
+        }
+
+        ODD(L"Application 初始化成功\n");
+        return true;
+    }
+
+    bool Application::loadFontFromResource(int resourceId, const char* fontName) {
+        HINSTANCE hInst = GetModuleHandleW(nullptr);
+        if (!hInst) {
+            ODD(L"loadFontFromResource: GetModuleHandleW 返回 NULL\n");
+            return false;
+        }
+
+        // ✅ 使用 RT_RCDATA 而不是 L"RCDATA"  
+        HRSRC hRes = FindResourceW(hInst, MAKEINTRESOURCE(resourceId), RT_RCDATA);
+        if (!hRes) {
+            ODD(L"字体资源未找到: %d\n", resourceId);
+            return false;
+        }
+
+        HGLOBAL hData = LoadResource(hInst, hRes);
+        if (!hData) {
+            ODD(L"LoadResource 失败: %d\n", resourceId);
+            return false;
+        }
+
+        void* pData = LockResource(hData);
+        DWORD size = SizeofResource(hInst, hRes);
+
+        if (!pData || size == 0) {
+            ODD(L"资源为空: %d\n", resourceId);
+            return false;
+        }
+
+        // ✅ 使用 "font/ttf" 作为 MIME 类型,copy=false
+        // RCDATA 资源映射在模块镜像中，进程存活期间始终有效，无需复制到堆
+        std::lock_guard<std::mutex> lock(textEngineMutex());
+        auto result = tvg::Text::load(fontName,
+            reinterpret_cast<const char*>(pData),
+            static_cast<uint32_t>(size),
+            "font/ttf",  // 不是 "ttf"  
+            false);      // copy=false  
+
+        std::wstring fontNameW = MUI::utf8ToWide(std::string(fontName ? fontName : ""));
+        if (result == tvg::Result::Success) {
+            ODD(L"字体加载成功: %ls (%u 字节)\n", fontNameW.c_str(), size);
+            return true;
+        }
+        else {
+            ODD(L"字体加载失败: %ls, 错误码: %d\n", fontNameW.c_str(), (int)result);
+            return false;
+        }
+    }
+
+    bool Application::loadFontFromFile(const std::wstring& path, const char* fontName) {
+        if (!fontName || !*fontName) return false;
+
+        HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            ODD(L"字体文件无法打开: %ls\n", path.c_str());
+            return false;
+        }
+
+        LARGE_INTEGER size = {};
+        if (!GetFileSizeEx(file, &size) || size.QuadPart == 0 || size.QuadPart > UINT32_MAX) {
+            ODD(L"字体文件大小无效: %ls\n", path.c_str());
+            CloseHandle(file);
+            return false;
+        }
+
+        HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        const void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (!view) {
+            ODD(L"字体文件映射失败: %ls\n", path.c_str());
+            if (mapping) CloseHandle(mapping);
+            CloseHandle(file);
+            return false;
+        }
+
+        tvg::Result result;
+        {
+            std::lock_guard<std::mutex> lock(textEngineMutex());
+            result = tvg::Text::load(fontName, static_cast<const char*>(view),
+                static_cast<uint32_t>(size.QuadPart), "font/ttf", false);
+        }
+        if (result != tvg::Result::Success) {
+            ODD(L"字体加载失败: %ls, 错误码: %d\n", path.c_str(), (int)result);
+            UnmapViewOfFile(view);
+            CloseHandle(mapping);
+            CloseHandle(file);
+            return false;
+        }
+
+        mappedFonts.push_back({ fontName, file, mapping, view });
+        ODD(L"字体映射加载成功: %ls (%lld 字节)\n", path.c_str(), (long long)size.QuadPart);
+        return true;
+    }
+
+    void Application::unloadMappedFonts() {
+        std::lock_guard<std::mutex> lock(textEngineMutex());
+        for (auto& f : mappedFonts) {
+            tvg::Text::load(f.name.c_str(), nullptr, 0);    // 先让 ThorVG 释放对视图的引用
+            UnmapViewOfFile(f.view);
+            CloseHandle(f.mapping);
+            CloseHandle(f.file);
+        }
+        mappedFonts.clear();
+    }
+
+    void Application::prewarmGlyphs(const char* fontName, float fontSize, const std::wstring& chars) {
+        if (!fontName || chars.empty()) return;
+
+        // 去重后按块排队，每块一次排版即可构建其中全部字形
+        const size_t ChunkChars = 32;
+        std::string font(fontName);
+        std::string utf8 = wideToUtf8(chars);
+        GlyphPrewarmJob job{ font, fontSize, std::string() };
+        size_t inChunk = 0;
+        for (size_t i = 0; i < utf8.size();) {
+            size_t len = std::min(UTF8::charLength(utf8.c_str() + i), utf8.size() - i);
+            uint32_t cp = UTF8::decode(utf8.c_str() + i);
+            if (cp > 0x20 && prewarmedGlyphs.insert({ font, cp }).second) {
+                job.text.append(utf8, i, len);
+                if (++inChunk == ChunkChars) {
+                    prewarmJobs.push_back(job);
+                    job.text.clear();
+                    inChunk = 0;
+                }
+            }
+            i += len;
+        }
+        if (!job.text.empty()) prewarmJobs.push_back(std::move(job));
+    }
+
+    // 在时间预算内处理预热队列(UI 线程，每块持有文本引擎锁，渲染线程 update 时让出)
+    void Application::processGlyphPrewarm(float budgetMs) {
+        if (prewarmJobs.empty()) return;
+
+        auto t0 = Clock::now();
+        do {
+            GlyphPrewarmJob& job = prewarmJobs.front();
+            {
+                std::lock_guard<std::mutex> lock(textEngineMutex());
+                auto text = tvg::Text::gen();
+                text->font(job.font.c_str());
+                text->size(job.size);
+                text->text(job.text.c_str());
+                prewarmScratch.clear();
+                text->getGlyphInfo(prewarmScratch);     // 排版即构建并缓存字形轮廓
+                text->unref();
+            }
+            prewarmJobs.pop_front();
+        } while (!prewarmJobs.empty() &&
+            std::chrono::duration<float, std::milli>(Clock::now() - t0).count() < budgetMs);
+    }
+
+    bool Application::pumpMessages() {
+        MSG msg = {};
+        while (PeekMessageW(&msg, nullptr, 0, 0, PM_REMOVE)) {
+            if (msg.message == WM_QUIT) {
+                running = false;
+                return false;
+            }
+            TranslateMessage(&msg);
+            DispatchMessageW(&msg);
+        }
+        return running;
+    }
+
+    void Application::run() {
+        running = true;
+
+        auto lastTime = std::chrono::steady_clock::now();
+        const auto runStart = lastTime;
+        bool firstFrame = true;
+
+        if (threadedRendering) startRenderThread();
+
+        while (running) {
+            if (!pumpMessages()) break;
+
+            // 计算 deltaTime  
+            auto currentTime = std::chrono::steady_clock::now();
+            auto frameStart = currentTime;
+            float deltaTime = std::chrono::duration<float>(currentTime - lastTime).count();
+            lastTime = currentTime;
+
+            // 派发到期定时器  
+            timerWheel.advance();
+
+            // 更新  
+            if (uiManager) {
+                FrameProfiler::Scope scope(profiler, FrameProfiler::Metric::Update);
+                uiManager->update(deltaTime);
+            }
+
+            // 字形预热(每帧最多约 2ms)
+            processGlyphPrewarm(2.0f);
+
+            if (threadedRendering) {
+                // 等上一份快照被取走后再构建，保证同时最多一帧在光栅化、一帧在构建
+                if (!waitForFrameSlot()) break;
+
+                FrameSnapshot snap;
+                auto buildStart = Clock::now();
+                snap.scene = uiManager ? uiManager->buildFrame() : nullptr;
+                snap.publishTime = Clock::now();
+                profiler.record(FrameProfiler::Metric::Build, buildStart, snap.publishTime);
+                if (inputPending) {
+                    snap.inputTime = firstPendingInput;
+                    inputPending = false;
+                }
+                {
+                    std::lock_guard<std::mutex> lock(frameMutex);
+                    pendingFrame = snap;
+                }
+                frameCv.notify_one();
+                profiler.record(FrameProfiler::Metric::Frame, frameStart, Clock::now());
+            }
+            else {
+                if (renderer3D) renderer3D->update(deltaTime);
+
+                auto presentStart = Clock::now();
+                renderFrame(deltaTime);
+
+                recordPresent(inputPending ? firstPendingInput : Clock::time_point(), presentStart);
+                inputPending = false;
+                profiler.record(FrameProfiler::Metric::Frame, frameStart, Clock::now());
+            }
+
+            if (firstFrame) {
+                // 首帧通常最慢(字形首次构建)，与 prewarmGlyphs 前后对比用
+                auto now = Clock::now();
+                ODD(L"首帧: %.2f ms (进入主循环后 %.2f ms)\n",
+                    std::chrono::duration<double, std::milli>(now - frameStart).count(),
+                    std::chrono::duration<double, std::milli>(now - runStart).count());
+                firstFrame = false;
+            }
 
-        if (renderer3D) {
-            if (!renderer3D->initialize(w, h)) {
-                ODD(L"Renderer3D 初始化失败\n");
-                return false;
+            if (idleWait && !timerWheel.isAnimating() && prewarmJobs.empty()) {
+                // 阻塞到下一个定时器到期或有新消息
+                uint32_t timeout = timerWheel.msUntilNext();
+                MsgWaitForMultipleObjects(0, nullptr, FALSE,
+                    timeout == TimerWheel::NoDeadline ? INFINITE : timeout, QS_ALLINPUT);
+            }
+            else {
+                Sleep(1);
             }
         }
 
-        ODD(L"Application 初始化成功\n");
-        return true;
+        if (threadedRendering) stopRenderThread();
+
+        // 先销毁 UI(元素中的 Text、场景与画布)，ThorVG 不再引用任何字体数据后才解除映射
+        uiManager.reset();
+        profilerOverlay.reset();
+        unloadMappedFonts();
+        TextureCache::getDefault().clear();
+        tvg::Initializer::term();
     }
 
-    bool Application::loadFontFromResource(int resourceId, const char* fontName) {
-        HINSTANCE hInst = GetModuleHandleW(nullptr);
-        if (!hInst) {
-            ODD(L"loadFontFromResource: GetModuleHandleW 返回 NULL\n");
-            return false;
+    // 渲染一帧(调用线程需持有 GL 上下文)
+    void Application::renderFrame(float deltaTime) {
+        tvg::Scene* frame = nullptr;
+        if (uiManager && uiManager->getCanvas()) {
+            FrameProfiler::Scope scope(profiler, FrameProfiler::Metric::Build);
+            frame = uiManager->buildFrame();
         }
+        drawFrame(frame);
+    }
 
-        // ✅ 使用 RT_RCDATA 而不是 L"RCDATA"  
-        HRSRC hRes = FindResourceW(hInst, MAKEINTRESOURCE(resourceId), RT_RCDATA);
-        if (!hRes) {
-            ODD(L"字体资源未找到: %d\n", resourceId);
-            return false;
-        }
+    // 3D + 2D 快照 + SwapBuffers(调用线程需持有 GL 上下文，frame 的所有权被接管)
+    void Application::drawFrame(tvg::Scene* frame) {
+        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        HGLOBAL hData = LoadResource(hInst, hRes);
-        if (!hData) {
-            ODD(L"LoadResource 失败: %d\n", resourceId);
-            return false;
+        // 先渲染 3D  
+        glEnable(GL_DEPTH_TEST);
+        if (renderer3D) {
+            FrameProfiler::Scope scope(profiler, FrameProfiler::Metric::Render3D);
+            renderer3D->render();
         }
 
-        void* pData = LockResource(hData);
-        DWORD size = SizeofResource(hInst, hRes);
+        // 再渲染 2D UI  
+        glDisable(GL_DEPTH_TEST);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-        if (!pData || size == 0) {
-            ODD(L"资源为空: %d\n", resourceId);
-            return false;
+        if (frame) {
+            FrameProfiler::Scope scope(profiler, FrameProfiler::Metric::Draw);
+            if (uiManager) uiManager->present(frame);
+            else frame->unref();
         }
 
-        // ✅ 使用 "font/ttf" 作为 MIME 类型,copy=true  
-        auto result = tvg::Text::load(fontName,
-            reinterpret_cast<const char*>(pData),
-            static_cast<uint32_t>(size),
-            "font/ttf",  // 不是 "ttf"  
-            true);       // copy=true  
+        FrameProfiler::Scope scope(profiler, FrameProfiler::Metric::Swap);
+        SwapBuffers(hdc);
+    }
 
-        std::wstring fontNameW = MUI::utf8ToWide(std::string(fontName ? fontName : ""));
-        if (result == tvg::Result::Success) {
-            ODD(L"字体加载成功: %ls (%u 字节)\n", fontNameW.c_str(), size);
-            return true;
+    void Application::recordPresent(Clock::time_point inputTime, Clock::time_point presentStart) {
+        auto now = Clock::now();
+        statPresentMs.store(std::chrono::duration<float, std::milli>(now - presentStart).count(),
+            std::memory_order_relaxed);
+        if (inputTime != Clock::time_point()) {
+            profiler.record(FrameProfiler::Metric::InputLatency, inputTime, now);
         }
-        else {
-            ODD(L"字体加载失败: %ls, 错误码: %d\n", fontNameW.c_str(), (int)result);
-            return false;
+        if (lastPresent != Clock::time_point()) {
+            profiler.record(FrameProfiler::Metric::FrameInterval, lastPresent, now);
         }
+        lastPresent = now;
     }
 
-    void Application::run() {
-        running = true;
+    void Application::startRenderThread() {
+        frameSlotEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);  // 自动复位
+        if (uiManager) uiManager->setDeferCanvasResize(true);
 
-        auto lastTime = std::chrono::steady_clock::now();
+        // GL 上下文同一时刻只能在一个线程上为当前，交给渲染线程
+        wglMakeCurrent(nullptr, nullptr);
 
-        MSG msg = {};
-        while (running) {
-            while (PeekMessageW(&msg, nullptr, 0, 0, PM_REMOVE)) {
-                if (msg.message == WM_QUIT) {
-                    running = false;
-                    break;
-                }
-                TranslateMessage(&msg);
-                DispatchMessageW(&msg);
-            }
+        renderRunning = true;
+        renderThread = std::thread(&Application::renderLoop, this);
+    }
 
-            if (!running) break;
+    void Application::stopRenderThread() {
+        {
+            std::lock_guard<std::mutex> lock(frameMutex);
+            renderRunning = false;
+        }
+        frameCv.notify_one();
+        if (renderThread.joinable()) renderThread.join();
 
-            // 计算 deltaTime  
-            auto currentTime = std::chrono::steady_clock::now();
-            float deltaTime = std::chrono::duration<float>(currentTime - lastTime).count();
-            lastTime = currentTime;
+        // 丢弃尚未被取走的快照
+        if (pendingFrame.scene) {
+            pendingFrame.scene->unref();
+            pendingFrame = FrameSnapshot();
+        }
 
-            // 更新  
-            if (uiManager) uiManager->update(deltaTime);
-            if (renderer3D) renderer3D->update(deltaTime);
+        // 收回 GL 上下文，保证后续资源释放在有效上下文中进行
+        wglMakeCurrent(hdc, hglrc);
+        if (uiManager) uiManager->setDeferCanvasResize(false);
+
+        if (frameSlotEvent) {
+            CloseHandle(frameSlotEvent);
+            frameSlotEvent = nullptr;
+        }
+    }
 
-            // 渲染  
-            glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    // UI 线程: 等待单槽邮箱空出，期间照常处理窗口消息
+    bool Application::waitForFrameSlot() {
+        while (running) {
+            {
+                std::lock_guard<std::mutex> lock(frameMutex);
+                if (!pendingFrame.scene) return true;
+            }
+            DWORD r = MsgWaitForMultipleObjects(1, &frameSlotEvent, FALSE, INFINITE, QS_ALLINPUT);
+            if (r == WAIT_OBJECT_0 + 1) {
+                if (!pumpMessages()) return false;
+            }
+        }
+        return false;
+    }
 
-            // 先渲染 3D  
-            glEnable(GL_DEPTH_TEST);
-            if (renderer3D) renderer3D->render();
+    void Application::renderLoop() {
+        if (!wglMakeCurrent(hdc, hglrc)) {
+            ODD(L"渲染线程无法获取 GL 上下文\n");
+            return;
+        }
 
-            // 再渲染 2D UI  
-            glDisable(GL_DEPTH_TEST);
-            glEnable(GL_BLEND);
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        auto lastTime = Clock::now();
 
-            if (uiManager) uiManager->render();
+        while (true) {
+            FrameSnapshot snap;
+            {
+                std::unique_lock<std::mutex> lock(frameMutex);
+                frameCv.wait(lock, [this]() { return pendingFrame.scene || !renderRunning; });
+                if (!renderRunning) break;
+                snap = pendingFrame;
+                pendingFrame = FrameSnapshot();
+            }
+            SetEvent(frameSlotEvent);
+
+            auto presentStart = Clock::now();
+            profiler.record(FrameProfiler::Metric::Queue, snap.publishTime, presentStart);
+
+            // 同步窗口尺寸变化
+            uint32_t size = pendingSize.exchange(0);
+            if (size) {
+                int w = static_cast<int>(size >> 16);
+                int h = static_cast<int>(size & 0xFFFF);
+                glViewport(0, 0, w, h);
+                if (renderer3D) renderer3D->resize(w, h);
+                if (uiManager) uiManager->resizeCanvas(w, h);
+            }
 
-            SwapBuffers(hdc);
+            float deltaTime = std::chrono::duration<float>(presentStart - lastTime).count();
+            lastTime = presentStart;
+            if (renderer3D) renderer3D->update(deltaTime);
 
-            Sleep(1);
+            drawFrame(snap.scene);
+            recordPresent(snap.inputTime, presentStart);
         }
 
-        tvg::Initializer::term();
+        wglMakeCurrent(nullptr, nullptr);
+    }
+
+    void Application::setProfilerOverlay(bool show) {
+        if (show) {
+            profiler.setEnabled(true);
+            if (!profilerOverlay) profilerOverlay = std::make_unique<ProfilerOverlay>(profiler);
+            if (uiManager) uiManager->setOverlay(profilerOverlay.get());
+        }
+        else if (profilerOverlay) {
+            if (uiManager) uiManager->setOverlay(nullptr);
+            profilerOverlay.reset();
+        }
     }
 
     void Application::quit() {
@@ -2115,6 +4962,16 @@ namespace MUI {
     }
 
     LRESULT Application::WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
+        // 记录尚未呈现的最早输入时刻，用于统计输入延迟
+        if ((msg >= WM_MOUSEFIRST && msg <= WM_MOUSELAST) || (msg >= WM_KEYFIRST && msg <= WM_KEYLAST)) {
+            auto now = Clock::now();
+            if (!inputPending) {
+                inputPending = true;
+                firstPendingInput = now;
+            }
+            profiler.mark(FrameProfiler::Metric::Input, now);
+        }
+
         switch (msg) {
         case WM_SIZE: {
             int w = LOWORD(lParam);
@@ -2125,6 +4982,15 @@ namespace MUI {
             instance->width = (uint32_t)w;
             instance->height = (uint32_t)h;
 
+            // 渲染线程模式: GL 相关的尺寸同步交给渲染线程，这里只更新布局
+            if (instance->renderRunning) {
+                if (w > 0 && h > 0) {
+                    instance->pendingSize = (static_cast<uint32_t>(w) << 16) | static_cast<uint32_t>(h & 0xFFFF);
+                }
+                if (instance->uiManager) instance->uiManager->handleSize(w, h);
+                return 0;
+            }
+
             // 同步 OpenGL 视口（仅在尺寸有效且当前有上下文时）
             if (w > 0 && h > 0 && instance->hglrc && wglGetCurrentContext()) {
                 if (w > 0 && h > 0) {
@@ -2245,6 +5111,7 @@ namespace MUI {
 
         // 添加子元素  
         void addChild(std::unique_ptr<UIElement> child) {
+            child->parentElement = this;
             children.push_back(std::move(child));
             updateLayout();
         }
@@ -2292,15 +5159,18 @@ namespace MUI {
             strokeColor = stroke;
             strokeWidth = strokeW;
             cornerRadius = corner;
+            invalidateLayer();
         }
 
         // 启用/禁用裁剪  
         void setClipsContent(bool clips) {
             clipsContent = clips;
+            invalidateLayer();
         }
 
         // 更新布局  
         void updateLayout() {
+            invalidateLayer();
             if (children.empty()) return;
 
             float contentX = rect.x + padding.left;
@@ -2392,7 +5262,7 @@ namespace MUI {
                 // 添加子元素 (clipScene 已经是原始指针,直接使用)  
                 for (auto& child : children) {
                     if (child->visible) {
-                        child->render(clipScene);  // 不需要 .get()  
+                        child->draw(clipScene);  // 不需要 .get()  
                     }
                 }
 
@@ -2402,7 +5272,7 @@ namespace MUI {
             else {
                 for (auto& child : children) {
                     if (child->visible) {
-                        child->render(parent);
+                        child->draw(parent);
                     }
                 }
             }
@@ -2485,6 +5355,7 @@ namespace MUI {
 
         void onMDown(float px, float py) override {
             isPressed = true;
+            invalidateLayer();
         }
 
         void onMUp(float px, float py) override {
@@ -2492,14 +5363,20 @@ namespace MUI {
                 if (onClick) onClick();
             }
             isPressed = false;
+            invalidateLayer();
         }
 
         void onMMove(float px, float py) override {
-            isHovered = hitTest(px, py);
+            bool now = hitTest(px, py);
+            if (now != isHovered) {
+                isHovered = now;
+                invalidateLayer();
+            }
         }
 
         void setLabel(const char* text) {
             label = text ? text : "";
+            invalidateLayer();
         }
 
         const std::string& getLabel() const {
@@ -2515,8 +5392,10 @@ namespace MUI {
     class UITextInput : public UIElement {
     private:
         std::string text;
-        std::vector<tvg::Text::TextGlyphInfo> glyphInfo;
-        std::vector<float> caretPositions;
+        std::vector<tvg::Text::TextGlyphInfo> glyphInfo;   // 测量用临时缓冲
+        std::vector<size_t> charOffsets;    // 第 i 个字符的起始字节，末尾为 text.size() 哨兵
+        std::vector<float> advances;        // 第 i 个字符的水平步进
+        std::vector<float> caretPositions;  // advances 的前缀和，size = 字符数 + 1
 
         Color bgColor = Color(255, 255, 255);
         Color textColor = Color(0, 0, 0);
@@ -2546,6 +5425,7 @@ namespace MUI {
             cursorBlinkTimer.setInterval(0.5f);
             cursorBlinkTimer.setCallback([this]() {
                 isCursorVisible = !isCursorVisible;
+                invalidateLayer();
                 });
         }
 
@@ -2615,10 +5495,12 @@ namespace MUI {
             isCursorVisible = true;
             cursorBlinkTimer.reset();
             ensureCaretVisible();
+            invalidateLayer();
         }
 
         void onKDown(int keyCode) override {
             bool textChanged = false;
+            ensureLayout();
 
             switch (keyCode) {
             case VK_LEFT:
@@ -2647,49 +5529,121 @@ namespace MUI {
 
             case VK_BACK:
                 if (caretIndex > 0 && !text.empty()) {
-                    size_t byteIndex = UTF8::charToByteIndex(text, caretIndex - 1);
-                    size_t charLen = UTF8::charLength(text.c_str() + byteIndex);
-                    text.erase(byteIndex, charLen);
-                    caretIndex--;
+                    replaceRange(caretIndex - 1, caretIndex, std::string());
                     textChanged = true;
                 }
                 break;
 
             case VK_DELETE:
                 if (caretIndex < caretPositions.size() - 1 && !text.empty()) {
-                    size_t byteIndex = UTF8::charToByteIndex(text, caretIndex);
-                    size_t charLen = UTF8::charLength(text.c_str() + byteIndex);
-                    text.erase(byteIndex, charLen);
+                    replaceRange(caretIndex, caretIndex + 1, std::string());
                     textChanged = true;
                 }
                 break;
+
+            case 'V':
+                if (GetKeyState(VK_CONTROL) & 0x8000) {
+                    pasteFromClipboard();   // 经 insertText 插入，onTextChanged 已在其中触发
+                }
+                break;
             }
 
             if (textChanged) {
-                layoutDirty = true;
                 if (onTextChanged) onTextChanged(text);
+                ensureCaretVisible();
             }
 
             isCursorVisible = true;
             cursorBlinkTimer.reset();
+            invalidateLayer();  // 光标移动/滚动同样改变外观
         }
 
         void onChar(wchar_t character) override {
             if (character < 32 || character == 127) return;
 
             std::wstring wstr(1, character);
-            std::string utf8 = wideToUtf8(wstr);
+            insertText(wideToUtf8(wstr));
+        }
 
-            size_t byteIndex = UTF8::charToByteIndex(text, caretIndex);
-            text.insert(byteIndex, utf8);
-            caretIndex++;
+        // 一次性插入整段文本(控制字符与换行被过滤)，只触发一次测量与回调
+        void onText(const std::wstring& str) override {
+            std::wstring filtered;
+            filtered.reserve(str.size());
+            for (wchar_t ch : str) {
+                if (ch >= 32 && ch != 127) filtered.push_back(ch);
+            }
+            if (!filtered.empty()) insertText(wideToUtf8(filtered));
+        }
+
+        // 在光标处插入 UTF-8 文本
+        void insertText(const std::string& utf8) {
+            if (utf8.empty()) return;
+            ensureLayout();
+            replaceRange(caretIndex, caretIndex, utf8);
 
-            layoutDirty = true;
             if (onTextChanged) onTextChanged(text);
 
             isCursorVisible = true;
             cursorBlinkTimer.reset();
             ensureCaretVisible();
+            invalidateLayer();
+        }
+
+        // 用 utf8 替换字符区间 [charBegin, charEnd)，光标移到新文本之后
+        // 只测量新插入的片段，偏移表与光标位置在编辑点之后做平移
+        // (片段边界处的字距调整被忽略，setText 会做完整重排)
+        void replaceRange(size_t charBegin, size_t charEnd, const std::string& utf8) {
+            ensureLayout();
+
+            size_t count = advances.size();
+            charBegin = std::min(charBegin, count);
+            charEnd = std::clamp(charEnd, charBegin, count);
+
+            size_t byteBegin = charOffsets[charBegin];
+            size_t byteEnd = charOffsets[charEnd];
+            text.replace(byteBegin, byteEnd - byteBegin, utf8);
+
+            std::vector<size_t> newOffsets;
+            UTF8::appendCharOffsets(utf8, byteBegin, newOffsets);
+            std::vector<float> newAdvances;
+            measureSpan(utf8, newOffsets.size(), newAdvances);
+
+            size_t inserted = newOffsets.size();
+            std::ptrdiff_t delta = static_cast<std::ptrdiff_t>(utf8.size()) -
+                static_cast<std::ptrdiff_t>(byteEnd - byteBegin);
+
+            charOffsets.erase(charOffsets.begin() + charBegin, charOffsets.begin() + charEnd);
+            charOffsets.insert(charOffsets.begin() + charBegin, newOffsets.begin(), newOffsets.end());
+            for (size_t i = charBegin + inserted; i < charOffsets.size(); ++i) {
+                charOffsets[i] += delta;
+            }
+
+            advances.erase(advances.begin() + charBegin, advances.begin() + charEnd);
+            advances.insert(advances.begin() + charBegin, newAdvances.begin(), newAdvances.end());
+
+            rebuildCaretPositions(charBegin);
+            caretIndex = charBegin + inserted;
+            invalidateLayer();
+        }
+
+        // 粘贴剪贴板中的 Unicode 文本(经 onText 插入并触发 onTextChanged)，返回文本是否改变
+        bool pasteFromClipboard() {
+            if (!OpenClipboard(nullptr)) return false;
+
+            std::wstring clip;
+            HANDLE h = GetClipboardData(CF_UNICODETEXT);
+            if (h) {
+                const wchar_t* wstr = static_cast<const wchar_t*>(GlobalLock(h));
+                if (wstr) {
+                    clip = wstr;
+                    GlobalUnlock(h);
+                }
+            }
+            CloseClipboard();
+
+            size_t before = text.size();
+            onText(clip);
+            return text.size() != before;
         }
 
         void onFocus(bool focused) override {
@@ -2701,13 +5655,32 @@ namespace MUI {
             else {
                 cursorBlinkTimer.stop();
             }
+            invalidateLayer();  // 边框颜色与光标随焦点变化
         }
 
         void setText(const std::string& str) {
             text = str;
-            caretIndex = UTF8::charCount(text);
-            layoutDirty = true;
+            updateLayout();
+            caretIndex = advances.size();
             ensureCaretVisible();
+            invalidateLayer();
+        }
+
+        size_t getCharCount() {
+            ensureLayout();
+            return advances.size();
+        }
+
+        // 字符索引 ↔ 字节偏移(查表，O(1) / O(log n))
+        size_t charToByte(size_t charIndex) {
+            ensureLayout();
+            return charOffsets[std::min(charIndex, charOffsets.size() - 1)];
+        }
+
+        size_t byteToChar(size_t byteOffset) {
+            ensureLayout();
+            auto it = std::upper_bound(charOffsets.begin(), charOffsets.end(), byteOffset);
+            return static_cast<size_t>(it - charOffsets.begin()) - 1;
         }
 
         const std::string& getText() const {
@@ -2715,42 +5688,65 @@ namespace MUI {
         }
 
 private:
+    // 完整重排: 重建偏移表并测量整串
     void updateLayout() {
-        if (text.empty()) {
-            glyphInfo.clear();
-            caretPositions.clear();
-            caretPositions.push_back(0.0f);
-            textWidth = 0.0f;
-            return;
-        }
+        charOffsets.clear();
+        UTF8::appendCharOffsets(text, 0, charOffsets);
+        measureSpan(text, charOffsets.size(), advances);
+        charOffsets.push_back(text.size());
 
-        auto tempText = tvg::Text::gen();
-        tempText->font(fontName.c_str());
-        tempText->text(text.c_str());
-        tempText->size(fontSize);
+        rebuildCaretPositions(0);
+        layoutDirty = false;
+    }
 
-        auto result = tempText->getGlyphInfo(glyphInfo);
-        if (result == tvg::Result::Success && !glyphInfo.empty()) {
-            caretPositions.clear();
-            caretPositions.push_back(0.0f);
+    void ensureLayout() {
+        if (layoutDirty) updateLayout();
+    }
 
-            for (const auto& glyph : glyphInfo) {
-                float nextPos = caretPositions.back() + glyph.advance;
-                caretPositions.push_back(nextPos);
+    // 测量一段文本中每个字符的步进；字形按码点与字符对齐，缺字形的字符宽度为 0
+    void measureSpan(const std::string& span, size_t charCount, std::vector<float>& out) {
+        const float FIXED_CHAR_WIDTH = 8.0f;
+        out.assign(charCount, FIXED_CHAR_WIDTH);
+        if (span.empty()) return;
+
+        tvg::Result result;
+        {
+            std::lock_guard<std::mutex> lock(textEngineMutex());
+            auto tempText = tvg::Text::gen();
+            tempText->font(fontName.c_str());
+            tempText->text(span.c_str());
+            tempText->size(fontSize);
+
+            result = tempText->getGlyphInfo(glyphInfo);
+            tempText->unref();
+        }
+
+        if (result != tvg::Result::Success || glyphInfo.empty()) return;
+
+        size_t g = 0;
+        const char* p = span.c_str();
+        const char* end = p + span.size();
+        for (size_t i = 0; i < charCount && p < end; ++i) {
+            uint32_t cp = UTF8::decode(p);
+            if (g < glyphInfo.size() && glyphInfo[g].codepoint == cp) {
+                out[i] = glyphInfo[g].advance;
+                ++g;
             }
-
-            textWidth = caretPositions.back();
+            else {
+                out[i] = 0.0f;
+            }
+            p += UTF8::charLength(p);
         }
-        else {
-            const float FIXED_CHAR_WIDTH = 8.0f;
-            size_t charCount = UTF8::charCount(text);
+    }
 
-            caretPositions.clear();
-            for (size_t i = 0; i <= charCount; ++i) {
-                caretPositions.push_back(i * FIXED_CHAR_WIDTH);
-            }
-            textWidth = charCount * FIXED_CHAR_WIDTH;
+    // 从第 from 个字符起重算光标位置
+    void rebuildCaretPositions(size_t from) {
+        caretPositions.resize(advances.size() + 1);
+        caretPositions[0] = 0.0f;
+        for (size_t i = from; i < advances.size(); ++i) {
+            caretPositions[i + 1] = caretPositions[i] + advances[i];
         }
+        textWidth = caretPositions.back();
     }
 
     void ensureCaretVisible() {
@@ -2782,18 +5778,13 @@ private:
     size_t getCaretIndexFromX(float localX) const {
         if (caretPositions.empty()) return 0;
 
-        size_t bestIndex = 0;
-        float minDistance = std::abs(localX - caretPositions[0]);
+        // caretPositions 单调递增，二分后比较相邻两点
+        auto it = std::lower_bound(caretPositions.begin(), caretPositions.end(), localX);
+        if (it == caretPositions.begin()) return 0;
+        if (it == caretPositions.end()) return caretPositions.size() - 1;
 
-        for (size_t i = 1; i < caretPositions.size(); ++i) {
-            float distance = std::abs(localX - caretPositions[i]);
-            if (distance < minDistance) {
-                minDistance = distance;
-                bestIndex = i;
-            }
-        }
-
-        return bestIndex;
+        size_t i = static_cast<size_t>(it - caretPositions.begin());
+        return (localX - caretPositions[i - 1] <= caretPositions[i] - localX) ? i - 1 : i;
     }
 };
 
@@ -2820,13 +5811,14 @@ namespace MUI {
             fontSize = 14.0f;
         }
 
-        void setText(const char* txt) { text = txt ? txt : ""; }
+        void setText(const char* txt) { text = txt ? txt : ""; invalidateLayer(); }
         const std::string& getText() const { return text; }
 
-        void setTextColor(Color c) { textColor = c; }
+        void setTextColor(Color c) { textColor = c; invalidateLayer(); }
         void setAlign(float h, float v) {
             hAlign = std::clamp(h, 0.0f, 1.0f);
             vAlign = std::clamp(v, 0.0f, 1.0f);
+            invalidateLayer();
         }
 
         void render(tvg::Scene* parent) override {
@@ -2874,11 +5866,17 @@ namespace MUI {
         float measureTextWidth(const std::string& s) const {
             if (s.empty()) return 0.0f;
             std::vector<tvg::Text::TextGlyphInfo> glyphs;
-            auto tmp = tvg::Text::gen();
-            tmp->font(fontName.c_str());
-            tmp->size(fontSize);
-            tmp->text(s.c_str());
-            if (tmp->getGlyphInfo(glyphs) == tvg::Result::Success && !glyphs.empty()) {
+            tvg::Result result;
+            {
+                std::lock_guard<std::mutex> lock(textEngineMutex());
+                auto tmp = tvg::Text::gen();
+                tmp->font(fontName.c_str());
+                tmp->size(fontSize);
+                tmp->text(s.c_str());
+                result = tmp->getGlyphInfo(glyphs);
+                tmp->unref();
+            }
+            if (result == tvg::Result::Success && !glyphs.empty()) {
                 float w = 0.0f;
                 for (auto& g : glyphs) w += g.advance;
                 return w;
@@ -2993,6 +5991,7 @@ namespace MUI {
 
         void setRange(float minVal, float maxVal) {
             minV = minVal; maxV = maxVal;
+            invalidateLayer();  // 值不变时比例也可能变化
             setValue(value); // 重新夹紧
         }
 
@@ -3000,6 +5999,7 @@ namespace MUI {
             float nv = clampValue(v);
             if (std::abs(nv - value) > 1e-6f) {
                 value = nv;
+                invalidateLayer();
                 if (onValueChanged) onValueChanged(value);
             }
         }
@@ -3094,12 +6094,14 @@ namespace MUI {
 
         void setValue(float v) {
             value = std::clamp(v, minV, maxV);
+            invalidateLayer();
         }
 
         float getValue() const { return value; }
 
         void setColors(Color background, Color foreground, Color borderColor) {
             bg = background; fg = foreground; border = borderColor;
+            invalidateLayer();
         }
 
         bool hitTest(float, float) override { return false; } // 非交互
@@ -3168,7 +6170,7 @@ namespace MUI {
     
     class PlayList : public UIElement {
     private:
-        std::vector<Song> songs;
+        SongLibrary::Ptr songs = SongLibrary::makeEmpty();  // 与播放器共享的快照，items 指向其中的歌曲
         std::vector<PlayListItem> items;
 
         // 简化的滚动状态  
@@ -3237,20 +6239,61 @@ namespace MUI {
         // ========================================================================  
 
         void setSongs(const std::vector<Song>& s) {
-            songs = s;
+            setSongs(SongLibrary::create(s));
+        }
+
+        // 切换到新快照: 同一版本直接忽略；保留按路径仍存在的收藏与选中状态
+        void setSongs(SongLibrary::Ptr library) {
+            if (!library) library = SongLibrary::makeEmpty();
+            if (library == songs) return;
+
+            std::wstring selectedPath;
+            std::vector<const std::wstring*> favorites;     // 指向旧快照中的路径，old 保证其存活
+            SongLibrary::Ptr old = songs;
+            if (selectedIndex >= 0 && selectedIndex < static_cast<int>(items.size())) {
+                selectedPath = items[selectedIndex].song->filePath;
+            }
+            for (const auto& item : items) {
+                if (item.isFavorite) favorites.push_back(&item.song->filePath);
+            }
+            bool refresh = !items.empty();   // 刷新(而非首次设置)时保持滚动位置
+
+            songs = std::move(library);
             items.clear();
-            for (const auto& song : songs) {
-                items.emplace_back(&song);
+            items.reserve(songs->size());
+            for (const auto& song : *songs) items.emplace_back(&song);
+            for (const std::wstring* path : favorites) {
+                int32_t i = songs->indexOf(*path);
+                if (i >= 0) items[i].isFavorite = true;
             }
-            firstVisibleIndex = 0;
+
+            selectedIndex = selectedPath.empty() ? -1 : songs->indexOf(selectedPath);
+            hoveredIndex = -1;
+            if (!refresh) firstVisibleIndex = 0;
+            int maxFirstIndex = std::max(0, static_cast<int>(items.size()) - VISIBLE_COUNT);
+            firstVisibleIndex = std::clamp(firstVisibleIndex, 0, maxFirstIndex);
         }
 
         void setItems(const std::vector<Song>& s) {
             setSongs(s);
         }
 
-        const std::vector<Song>& getSongs() const {
-            return songs;
+        void setItems(SongLibrary::Ptr library) {
+            setSongs(std::move(library));
+        }
+
+        const SongLibrary& getSongs() const {
+            return *songs;
+        }
+
+        // 列表会显示的全部文本(标题 + 艺术家)，供 Application::prewarmGlyphs 预热字形
+        std::wstring getDisplayText() const {
+            std::wstring all;
+            for (const auto& song : *songs) {
+                all += song.title;
+                all += song.artist;
+            }
+            return all;
         }
 
         void setSelectedIndex(int index) {
@@ -3339,19 +6382,53 @@ namespace MUI {
             float contentX = rect.x + leftPadding;
             float contentY = rect.y + topPadding;
 
-            // 渲染可见条目  
+            // 条目背景先合批推入，位于封面/文字之下
+            for (int i = firstVisibleIndex; i < lastVisibleIndex; ++i) {
+                int relativeIndex = i - firstVisibleIndex;
+                float itemY = contentY + relativeIndex * (items[i].style.itemH + vspacing);
+
+                renderItemBackground(items[i], i, contentX, itemY);
+            }
+            backgroundBatch.flush(parent);
+
+            // 封面层：封面图直接推入，占位图合批后紧随其后，仍位于文字之下
+            for (int i = firstVisibleIndex; i < lastVisibleIndex; ++i) {
+                int relativeIndex = i - firstVisibleIndex;
+                float itemY = contentY + relativeIndex * (items[i].style.itemH + vspacing);
+
+                const auto& layout = items[i].layout;
+                renderCover(parent, items[i], contentX + layout.cover.x, itemY + layout.cover.y,
+                    layout.cover.w, layout.cover.h);
+            }
+            coverBatch.flush(parent);
+
+            // 文字层
             for (int i = firstVisibleIndex; i < lastVisibleIndex; ++i) {
                 int relativeIndex = i - firstVisibleIndex;
                 float itemY = contentY + relativeIndex * (items[i].style.itemH + vspacing);
 
-                renderItem(parent, i, contentX, itemY);
+                renderItemText(parent, i, contentX, itemY);
             }
 
-            // 渲染滚动条  
-            renderScrollbar(parent);
+            // 前景层：收藏按钮与滚动条位于文字之上
+            for (int i = firstVisibleIndex; i < lastVisibleIndex; ++i) {
+                int relativeIndex = i - firstVisibleIndex;
+                float itemY = contentY + relativeIndex * (items[i].style.itemH + vspacing);
+
+                const auto& layout = items[i].layout;
+                renderFavorite(parent, items[i], contentX + layout.favorite.x, itemY + layout.favorite.y,
+                    layout.favorite.w, layout.favorite.h);
+            }
+            renderScrollbar();
+            foregroundBatch.flush(parent);
         }
 
     private:
+        // 同样式矩形合批，每个层级一个批次，保持与逐个绘制相同的上下次序
+        ShapeBatch backgroundBatch;     // 条目背景
+        ShapeBatch coverBatch;          // 封面占位图
+        ShapeBatch foregroundBatch;     // 收藏按钮、滚动条
+
         void renderContainer(tvg::Scene* parent) {
             auto bg = tvg::Shape::gen();
             bg->appendRect(rect.x, rect.y, rect.w, rect.h,
@@ -3362,16 +6439,9 @@ namespace MUI {
             parent->push(std::move(bg));
         }
 
-        void renderItem(tvg::Scene* parent, int index, float x, float y) {
+        void renderItemText(tvg::Scene* parent, int index, float x, float y) {
             const auto& item = items[index];
-
-            // 渲染背景  
-            renderItemBackground(parent, item, index, x, y);
-
-            // 渲染封面  
             const auto& layout = item.layout;
-            renderCover(parent, item, x + layout.cover.x, y + layout.cover.y,
-                layout.cover.w, layout.cover.h);
 
             // 渲染标题  
             if (item.song) {
@@ -3384,17 +6454,9 @@ namespace MUI {
                 renderArtist(parent, item, x + layout.artist.x, y + layout.artist.y,
                     layout.artist.w, layout.artist.h, layout.artist.fontSize);
             }
-
-            // 渲染收藏按钮  
-            renderFavorite(parent, item, x + layout.favorite.x, y + layout.favorite.y,
-                layout.favorite.w, layout.favorite.h);
         }
 
-        void renderItemBackground(tvg::Scene* parent, const PlayListItem& item,
-            int index, float x, float y) {
-            auto bg = tvg::Shape::gen();
-            bg->appendRect(x, y, item.style.itemW, item.style.itemH, 3, 3);
-
+        void renderItemBackground(const PlayListItem& item, int index, float x, float y) {
             Color bgColor = item.style.fillColor;
             if (index == selectedIndex) {
                 bgColor = item.style.selectedColor;
@@ -3403,15 +6465,13 @@ namespace MUI {
                 bgColor = item.style.hoverColor;
             }
 
-            bg->fill(bgColor.r, bgColor.g, bgColor.b, bgColor.a);
-
             if (item.style.enableStroke) {
-                bg->strokeFill(item.style.strokeColor.r, item.style.strokeColor.g,
-                    item.style.strokeColor.b, item.style.strokeColor.a);
-                bg->strokeWidth(item.style.strokeWidth);
+                backgroundBatch.addRect(x, y, item.style.itemW, item.style.itemH, 3,
+                    bgColor, item.style.strokeColor, item.style.strokeWidth);
+            }
+            else {
+                backgroundBatch.addRect(x, y, item.style.itemW, item.style.itemH, 3, bgColor);
             }
-
-            parent->push(std::move(bg));
         }
 
         void renderCover(tvg::Scene* parent, const PlayListItem& item,
@@ -3449,17 +6509,14 @@ namespace MUI {
         }
 
         void renderPlaceholder(tvg::Scene* parent, float x, float y, float w, float h) {
-            auto placeholder = tvg::Shape::gen();
-            placeholder->appendRect(x, y, w, h, 2, 2);
-            placeholder->fill(200, 200, 200, 255);
-            parent->push(std::move(placeholder));
+            coverBatch.addRect(x, y, w, h, 2, Color(200, 200, 200, 255));
         }
 
         void renderTitle(tvg::Scene* parent, const PlayListItem& item,
             float x, float y, float w, float h, float fontSize) {
             if (!item.song) return;
 
-            std::string title = wideToUtf8(item.song->title);
+            FrameString title = wideToUtf8(item.song->title, &FrameArena::get());
 
             auto text = tvg::Text::gen();
             text->font(fontName.c_str());
@@ -3480,7 +6537,7 @@ namespace MUI {
             float x, float y, float w, float h, float fontSize) {
             if (!item.song) return;
 
-            std::string artist = wideToUtf8(item.song->artist);
+            FrameString artist = wideToUtf8(item.song->artist, &FrameArena::get());
 
             auto text = tvg::Text::gen();
             text->font(fontName.c_str());
@@ -3496,20 +6553,11 @@ namespace MUI {
 
         void renderFavorite(tvg::Scene* parent, const PlayListItem& item,
             float x, float y, float w, float h) {
-            auto heart = tvg::Shape::gen();
-            heart->appendRect(x, y, w, h, 2, 2);
-
-            if (item.isFavorite) {
-                heart->fill(255, 100, 100, 255);
-            }
-            else {
-                heart->fill(200, 200, 200, 255);
-            }
-
-            parent->push(std::move(heart));
+            foregroundBatch.addRect(x, y, w, h, 2,
+                item.isFavorite ? Color(255, 100, 100, 255) : Color(200, 200, 200, 255));
         }
 
-        void renderScrollbar(tvg::Scene* parent) {
+        void renderScrollbar() {
             if (items.size() <= VISIBLE_COUNT) return;
 
             float trackX = rect.x + rect.w - 8.0f;
@@ -3523,10 +6571,7 @@ namespace MUI {
             int maxFirstIndex = items.size() - VISIBLE_COUNT;
             float thumbY = trackY + (firstVisibleIndex / (float)maxFirstIndex) * thumbSpan;
 
-            auto scrollbar = tvg::Shape::gen();
-            scrollbar->appendRect(trackX, thumbY, trackW, thumbH, 3, 3);
-            scrollbar->fill(100, 100, 100, 200);
-            parent->push(std::move(scrollbar));
+            foregroundBatch.addRect(trackX, thumbY, trackW, thumbH, 3, Color(100, 100, 100, 200));
         }
 
 
@@ -3793,7 +6838,7 @@ namespace MUI {
     class LyricView : public UIElement {
     private:
         std::function<float()> timeProvider;
-        std::vector<LyricLine> lyrics;
+        mlrc::Document lyrics;
 
         float currentTime = 0.0f;
         int curIndex = -1;
@@ -3809,30 +6854,157 @@ namespace MUI {
         Color otherColor{ 180, 180, 180, 200 };
         const char* fontName = nullptr;
 
+        // 预光栅化行缓存: 每行文本只排版/光栅化一次(普通色与高亮色两份)，
+        // 之后滚动、衰减与卡拉OK擦除都只是对缓存位图做平移、透明度与裁剪合成
+        // 每份位图配一小池持有引用的 Picture，逐帧复用同一 Picture 以保留其渲染数据(GL 纹理不重复上传)；
+        // 一个 Picture 同时只能挂在一个场景下，故池中留出上一帧快照仍占用的份额
+        struct LineBitmap {
+            std::vector<uint32_t> normal;
+            std::vector<uint32_t> highlight;
+            std::vector<tvg::Picture*> normalPics;
+            std::vector<tvg::Picture*> highlightPics;
+            uint64_t lastUsed = 0;
+        };
+        std::unordered_map<uint32_t, LineBitmap> lineCache;   // 键: 行文本在文档中的偏移(重复行共用)
+        std::vector<std::vector<uint32_t>> retiredNow, retiredPrev;  // 淘汰的像素延后一帧释放(渲染线程可能仍在使用)
+        uint32_t cacheW = 0, cacheH = 0;
+        uint64_t frameCounter = 0;
+        bool cacheEnabled = true;
+        static constexpr size_t LINE_CACHE_CAPACITY = 48;
+        static constexpr size_t PICTURES_PER_BITMAP = 3;   // 构建中 + 渲染线程持有 + 画布中尚未替换的帧
+
+        // 释放缓存项: Picture 仅放弃本地引用(仍在场景中的随场景销毁)，像素延后释放
+        void retireBitmap(LineBitmap& bmp) {
+            {
+                std::lock_guard<std::mutex> lock(textEngineMutex());   // 引用计数与渲染线程释放旧场景互斥
+                for (auto* pic : bmp.normalPics) pic->unref();
+                for (auto* pic : bmp.highlightPics) pic->unref();
+            }
+            bmp.normalPics.clear();
+            bmp.highlightPics.clear();
+            retiredNow.push_back(std::move(bmp.normal));
+            retiredNow.push_back(std::move(bmp.highlight));
+        }
+
+        void invalidateLineCache() {
+            for (auto& kv : lineCache) retireBitmap(kv.second);
+            lineCache.clear();
+        }
+
+        LineBitmap* getLineBitmap(const mlrc::Line& line, uint32_t w, uint32_t h) {
+            auto it = lineCache.find(line.off);
+            if (it != lineCache.end()) {
+                it->second.lastUsed = frameCounter;
+                return &it->second;
+            }
+
+            if (lineCache.size() >= LINE_CACHE_CAPACITY) {
+                auto oldest = lineCache.begin();
+                for (auto i = lineCache.begin(); i != lineCache.end(); ++i) {
+                    if (i->second.lastUsed < oldest->second.lastUsed) oldest = i;
+                }
+                retireBitmap(oldest->second);
+                lineCache.erase(oldest);
+            }
+
+            auto makeText = [&](Color c) {
+                auto t = tvg::Text::gen();
+                if (fontName) t->font(fontName);
+                t->size(fontSize);
+                t->text(lyrics.c_str(line));
+                t->layout(static_cast<float>(w), static_cast<float>(h));
+                t->align(0.5f, 0.5f);
+                t->fill(c.r, c.g, c.b);
+                return t;
+            };
+
+            LineBitmap bmp;
+            bmp.lastUsed = frameCounter;
+            if (!rasterizeOffscreen(makeText(otherColor), w, h, bmp.normal) ||
+                !rasterizeOffscreen(makeText(curColor), w, h, bmp.highlight)) {
+                cacheEnabled = false;   // 软件光栅化不可用，退回逐帧文本渲染
+                return nullptr;
+            }
+            return &lineCache.emplace(line.off, std::move(bmp)).first->second;
+        }
+
+        // 取池中未挂在任何场景下的 Picture(旧场景销毁后 parent 复位)；池满且都被占用时生成一次性的
+        tvg::Picture* acquirePicture(std::vector<tvg::Picture*>& pool, const std::vector<uint32_t>& pixels,
+            uint32_t w, uint32_t h) {
+            std::lock_guard<std::mutex> lock(textEngineMutex());
+            for (auto* pic : pool) {
+                if (!pic->parent()) return pic;
+            }
+            auto pic = tvg::Picture::gen();
+            if (pic->load(pixels.data(), w, h, tvg::ColorSpace::ABGR8888S, false) != tvg::Result::Success) {
+                pic->unref();
+                return nullptr;
+            }
+            if (pool.size() < PICTURES_PER_BITMAP) {
+                pic->ref();
+                pool.push_back(pic);
+            }
+            return pic;
+        }
+
+        bool pushCachedLine(tvg::Scene* parent, std::vector<tvg::Picture*>& pool, const std::vector<uint32_t>& pixels,
+            uint32_t w, uint32_t h, float x, float y, uint8_t alpha, tvg::Shape* clip) {
+            auto pic = acquirePicture(pool, pixels, w, h);
+            if (!pic) {
+                if (clip) clip->unref();
+                return false;
+            }
+            pic->translate(x, y);
+            pic->opacity(alpha);
+            if (clip) pic->clip(clip);
+            parent->push(pic);
+            return true;
+        }
+
     public:
+        ~LyricView() override {
+            invalidateLineCache();
+        }
+
         void setTimeProvider(std::function<float()> fn) {
             timeProvider = std::move(fn);
         }
 
-        void setLyrics(std::vector<LyricLine> lrc) {
-            if (lrc.empty()) {
-                lrc.push_back({ 0.0f, std::string(u8"(无歌词)") });
+        void setLyrics(mlrc::Document doc) {
+            if (doc.empty()) {
+                doc.addLine(0.0f, u8"(无歌词)");
             }
-            lyrics = std::move(lrc);
+            lyrics = std::move(doc);
+            invalidateLineCache();
             curIndex = -1;
             prevIndex = -1;
             baseIndexF = 0.0f;
             animTime = animDur;
         }
 
+        // 兼容旧接口: 逐行文本复制进文档存储
+        void setLyrics(const std::vector<LyricLine>& lrc) {
+            mlrc::Document doc;
+            for (const auto& line : lrc) doc.addLine(line.t, line.text);
+            setLyrics(std::move(doc));
+        }
+
         void setStyle(float fs, Color cur, Color other) {
             fontSize = fs;
             curColor = cur;
             otherColor = other;
+            invalidateLineCache();
         }
 
         void setFontName(const char* name) {
             fontName = name;
+            invalidateLineCache();
+        }
+
+        // 关闭后逐帧排版文本(对比基准用)；重新开启时从空缓存开始
+        void setLineCacheEnabled(bool enable) {
+            invalidateLineCache();
+            cacheEnabled = enable;
         }
 
         void update(float dt) override {
@@ -3842,16 +7014,7 @@ namespace MUI {
             currentTime = timeProvider();
 
             // 二分查找当前时间对应的歌词索引  
-            int lo = 0, hi = (int)lyrics.size() - 1, ans = -1;
-            while (lo <= hi) {
-                int mid = (lo + hi) / 2;
-                if (lyrics[mid].t <= currentTime) {
-                    ans = mid;
-                    lo = mid + 1;
-                }
-                else hi = mid - 1;
-            }
-            curIndex = ans;
+            curIndex = lyrics.indexAt(currentTime);
 
             // 触发滚动动画  
             if (curIndex != prevIndex) {
@@ -3893,6 +7056,20 @@ namespace MUI {
             int start = std::max(0, (int)std::floor(baseIndexF) - half);
             int end = std::min((int)lyrics.size() - 1, (int)std::floor(baseIndexF) + half);
 
+            // 上上帧淘汰的像素此时已不再被引用
+            retiredPrev.clear();
+            retiredPrev.swap(retiredNow);
+            ++frameCounter;
+
+            const float textW = std::max(0.0f, rect.w - 16.0f);
+            uint32_t bw = static_cast<uint32_t>(std::ceil(textW));
+            uint32_t bh = static_cast<uint32_t>(std::ceil(lineH));
+            if (bw != cacheW || bh != cacheH) {
+                invalidateLineCache();
+                cacheW = bw;
+                cacheH = bh;
+            }
+
             // 渲染可见歌词行  
             for (int i = start; i <= end; ++i) {
                 const float y = centerY + ((float)i - baseIndexF) * lineH;
@@ -3901,11 +7078,30 @@ namespace MUI {
 
                 bool isCur = (i == idx);
 
+                // 缓存路径: 合成预光栅化的位图
+                LineBitmap* bmp = (cacheEnabled && bw > 0 && bh > 0) ?
+                    getLineBitmap(lyrics[i], bw, bh) : nullptr;
+                if (bmp) {
+                    // 与直接渲染一致: 文本排版框左上角位于 (rect.x + 8, y)
+                    float bx = rect.x + 8.0f;
+                    float by = y;
+                    uint8_t a = (uint8_t)std::clamp((int)std::round(otherColor.a * fall), 0, 255);
+                    pushCachedLine(parent, bmp->normalPics, bmp->normal, bw, bh, bx, by, a, nullptr);
+
+                    if (isCur && karaokeP > 0.01f) {
+                        auto clipShape = tvg::Shape::gen();
+                        clipShape->appendRect(bx, by, textW * karaokeP, lineH, 0, 0);
+                        uint8_t fa = (uint8_t)std::clamp((int)std::round(curColor.a * fall), 0, 255);
+                        pushCachedLine(parent, bmp->highlightPics, bmp->highlight, bw, bh, bx, by, fa, clipShape);
+                    }
+                    continue;
+                }
+
                 // 背景文本(未高亮部分)  
                 auto backText = tvg::Text::gen();
                 if (fontName) backText->font(fontName);
                 backText->size(fontSize);
-                backText->text(lyrics[i].text.c_str());
+                backText->text(lyrics.c_str(lyrics[i]));
                 backText->translate(rect.x + 8.0f, y);
                 backText->layout(std::max(0.0f, rect.w - 16.0f), lineH);
                 backText->align(0.5f, 0.5f);
@@ -3921,7 +7117,7 @@ namespace MUI {
                     auto frontText = tvg::Text::gen();
                     if (fontName) frontText->font(fontName);
                     frontText->size(fontSize);
-                    frontText->text(lyrics[i].text.c_str());
+                    frontText->text(lyrics.c_str(lyrics[i]));
                     frontText->translate(rect.x + 8.0f, y);
                     frontText->layout(std::max(0.0f, rect.w - 16.0f), lineH);
                     frontText->align(0.5f, 0.5f);
@@ -3961,113 +7157,25 @@ namespace MUI {
 // misc
 namespace MUI {
 
-    // 辅助函数:字符串转整数  
-    static inline int _toInt(const std::wstring& s, size_t i, size_t len) {
-        int v = 0;
-        for (size_t k = 0; k < len && i + k < s.size(); ++k) {
-            wchar_t c = s[i + k];
-            if (c < L'0' || c > L'9') return v;
-            v = v * 10 + (int)(c - L'0');
-        }
-        return v;
-    }
-
-    // 解析单行 LRC  
-    static void parseLrcLine(const std::wstring& wline, std::vector<LyricLine>& out) {
-        size_t i = 0;
-        std::vector<float> times;
-
-        // 提取所有时间标签  
-        while (i < wline.size()) {
-            if (wline[i] != L'[') break;
-            size_t j = wline.find(L']', i + 1);
-            if (j == std::wstring::npos) break;
-
-            size_t colon = wline.find(L':', i + 1);
-            if (colon != std::wstring::npos && colon < j) {
-                int mm = _toInt(wline, i + 1, colon - (i + 1));
-                size_t secStart = colon + 1;
-                size_t dot = wline.find(L'.', secStart);
-                int ss = 0, cs = 0;
-
-                if (dot != std::wstring::npos && dot < j) {
-                    ss = _toInt(wline, secStart, dot - secStart);
-                    int frac = _toInt(wline, dot + 1, j - (dot + 1));
-                    if (j - (dot + 1) >= 3) cs = (int)std::round(frac / 10.0);
-                    else cs = frac;
-                }
-                else {
-                    ss = _toInt(wline, secStart, j - secStart);
-                }
-
-                float t = (float)mm * 60.0f + (float)ss + (float)cs / 100.0f;
-                times.push_back(t);
-            }
-            i = j + 1;
-        }
-
-        // 提取文本  
-        std::wstring wtext;
-        if (!times.empty()) {
-            size_t last = wline.rfind(L']');
-            if (last != std::wstring::npos && last + 1 < wline.size())
-                wtext = wline.substr(last + 1);
-        }
-        else {
-            wtext = wline;
-        }
-
-        std::string text = wideToUtf8(wtext);
-        while (!text.empty() && (text.back() == '\r' || text.back() == '\n' ||
-            text.back() == ' ' || text.back() == '\t'))
-            text.pop_back();
-
-        if (times.empty()) {
-            if (!text.empty()) out.push_back({ 0.0f, text });
-            return;
-        }
-
-        for (float t : times) {
-            out.push_back({ t, text });
-        }
-    }
-
-    // 解析完整 LRC 文件  
-    static std::vector<LyricLine> parseLrc(const std::wstring& content) {
-        std::vector<LyricLine> lines;
-        size_t start = 0;
-
-        while (start < content.size()) {
-            size_t end = content.find_first_of(L"\r\n", start);
-            std::wstring line = (end == std::wstring::npos) ?
-                content.substr(start) : content.substr(start, end - start);
-            parseLrcLine(line, lines);
-
-            if (end == std::wstring::npos) break;
-            start = end + 1;
-            if (start < content.size() && content[start] == L'\n' && content[end] == L'\r')
-                ++start;
-        }
-
-        std::sort(lines.begin(), lines.end(),
-            [](const LyricLine& a, const LyricLine& b) { return a.t < b.t; });
-        return lines;
+    // 解析 LRC 文本(UTF-8，可带 BOM)，无时间标签的行按 0 秒保留  
+    static mlrc::Document parseLrc(std::string_view utf8) {
+        mlrc::Document doc;
+        doc.parse(utf8, true);
+        return doc;
     }
 
     // 从音频文件读取嵌入歌词  
-    static std::vector<LyricLine> loadLyricsFromFile(const std::wstring& wpath) {
-        std::vector<LyricLine> none;
+    static mlrc::Document loadLyricsFromFile(const std::wstring& wpath) {
+        mlrc::Document none;
         TagLib::FileRef f(wpath.c_str());
         if (f.isNull()) return none;
 
         TagLib::PropertyMap props = f.properties();
         if (props.contains("LYRICS")) {
-            auto w = props["LYRICS"].toString("\n").toWString();
-            return parseLrc(w);
+            return parseLrc(props["LYRICS"].toString("\n").to8Bit(true));
         }
         if (props.contains("UNSYNCEDLYRICS")) {
-            auto w = props["UNSYNCEDLYRICS"].toString("\n").toWString();
-            return parseLrc(w);
+            return parseLrc(props["UNSYNCEDLYRICS"].toString("\n").to8Bit(true));
         }
         return none;
     }
@@ -0,0 +1,349 @@
+﻿/****************************************************************************
+ * 标题: mvfs.h - miniaudio 内存映射 VFS
+ * 文件: mvfs.h
+ * 版本: 0.1
+ * 作者: AEGLOVE
+ * 日期: 2026-10-19
+ * 功能: ma_vfs 实现。本地文件整体只读映射，读/跳转只是指针运算与 memcpy，
+ *       不再有 stdio 的小块 read 与跳转后的整块重读；网络路径(UNC/映射网络盘/NFS/SMB)
+ *       或映射失败时改用预读窗口(单次 pread 读入一大块，窗口内跳转不触发系统调用)。
+ *       自带计数: 打开/读/跳转次数、实际系统调用次数与字节数，可换算为每秒播放的开销。
+ *       用法: ma_engine_config.pResourceManagerVFS = vfs.get()，或 ma_decoder_init_vfs(_w)。
+ * 依赖: C++17, miniaudio(须在本文件之前包含 miniaudio.h)
+ * 环境: Windows11 x64, VS2022, C++17, Unicode字符集；Linux(POSIX mmap)用于基准测试
+ * 编码: UTF-8 (BOM)
+ ****************************************************************************/
+
+#pragma once
+
+#ifndef miniaudio_h
+#error "mvfs.h: include miniaudio.h first"
+#endif
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <new>
+#include <vector>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/vfs.h>
+#include <unistd.h>
+#endif
+
+namespace mvfs {
+
+struct Stats {
+    uint64_t opens = 0;
+    uint64_t mappedOpens = 0;       // 以内存映射打开
+    uint64_t windowOpens = 0;       // 以预读窗口打开(网络路径或映射失败)
+    uint64_t readCalls = 0;         // 解码器发起的读请求
+    uint64_t seekCalls = 0;
+    uint64_t syscalls = 0;          // 实际发出的系统调用(打开/映射/读取/关闭)
+    uint64_t bytesRead = 0;         // 交给解码器的字节数
+    uint64_t osBytes = 0;           // 预读窗口从系统读取的字节数(映射方式由缺页载入，不计入)
+
+    // 按播放时长换算(playbackSeconds 由调用者提供，例如 PlaybackClock 累计)
+    double syscallsPerSecond(double playbackSeconds) const { return playbackSeconds > 0 ? syscalls / playbackSeconds : 0.0; }
+    double bytesPerSecond(double playbackSeconds) const { return playbackSeconds > 0 ? bytesRead / playbackSeconds : 0.0; }
+};
+
+class MappedVfs {
+public:
+    MappedVfs() {
+        callbacks.onOpen = &MappedVfs::onOpen;
+        callbacks.onOpenW = &MappedVfs::onOpenW;
+        callbacks.onClose = &MappedVfs::onClose;
+        callbacks.onRead = &MappedVfs::onRead;
+        callbacks.onWrite = &MappedVfs::onWrite;
+        callbacks.onSeek = &MappedVfs::onSeek;
+        callbacks.onTell = &MappedVfs::onTell;
+        callbacks.onInfo = &MappedVfs::onInfo;
+    }
+    MappedVfs(const MappedVfs&) = delete;
+    MappedVfs& operator=(const MappedVfs&) = delete;
+
+    ma_vfs* get() { return this; }
+
+    // 预读窗口大小(默认 1MB)，只影响之后打开的文件
+    void setWindowSize(size_t bytes) { windowSize.store(std::max<size_t>(bytes, 64 * 1024), std::memory_order_relaxed); }
+    // 强制所有文件走预读窗口(对比测试用)
+    void setMappingEnabled(bool enable) { mappingEnabled.store(enable, std::memory_order_relaxed); }
+
+    Stats getStats() const {
+        Stats s;
+        s.opens = opens.load(std::memory_order_relaxed);
+        s.mappedOpens = mappedOpens.load(std::memory_order_relaxed);
+        s.windowOpens = windowOpens.load(std::memory_order_relaxed);
+        s.readCalls = readCalls.load(std::memory_order_relaxed);
+        s.seekCalls = seekCalls.load(std::memory_order_relaxed);
+        s.syscalls = syscalls.load(std::memory_order_relaxed);
+        s.bytesRead = bytesRead.load(std::memory_order_relaxed);
+        s.osBytes = osBytes.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    void resetStats() {
+        for (auto* c : { &opens, &mappedOpens, &windowOpens, &readCalls, &seekCalls, &syscalls, &bytesRead, &osBytes }) {
+            c->store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // 网络路径不做映射: 缺页时在解码线程上同步等待网络，连接中断还会变成访问异常
+    static bool isNetworkPath(const std::filesystem::path& path) {
+#ifdef _WIN32
+        std::wstring p = path.native();
+        if (p.rfind(L"\\\\?\\", 0) == 0) {         // 长路径前缀 \\?\C:\... 或 \\?\UNC\server\...
+            if (p.rfind(L"\\\\?\\UNC\\", 0) == 0) return true;
+            p.erase(0, 4);
+        }
+        else if (p.size() >= 2 && (p[0] == L'\\' || p[0] == L'/') && (p[1] == L'\\' || p[1] == L'/')) {
+            return true;                                // \\server\share
+        }
+        if (p.size() >= 2 && p[1] == L':') {
+            wchar_t root[4] = { p[0], L':', L'\\', 0 };
+            return GetDriveTypeW(root) == DRIVE_REMOTE;
+        }
+        return false;
+#else
+        struct statfs fs;
+        if (statfs(path.c_str(), &fs) != 0) return false;
+        switch (static_cast<unsigned long>(fs.f_type)) {
+        case 0x6969UL:      // NFS
+        case 0x517BUL:      // SMB
+        case 0xFF534D42UL:  // CIFS
+        case 0xFE534D42UL:  // SMB2
+        case 0x65735546UL:  // FUSE(sshfs 等)
+            return true;
+        default:
+            return false;
+        }
+#endif
+    }
+
+private:
+    ma_vfs_callbacks callbacks;     // 必须为首成员: miniaudio 把 ma_vfs* 当作 ma_vfs_callbacks* 使用
+
+    std::atomic<size_t> windowSize{ 1u << 20 };
+    std::atomic<bool> mappingEnabled{ true };
+    std::atomic<uint64_t> opens{ 0 }, mappedOpens{ 0 }, windowOpens{ 0 }, readCalls{ 0 }, seekCalls{ 0 },
+        syscalls{ 0 }, bytesRead{ 0 }, osBytes{ 0 };
+
+    struct File {
+        uint64_t size = 0;
+        uint64_t cursor = 0;
+        const uint8_t* data = nullptr;      // 映射方式: 整个文件
+#ifdef _WIN32
+        HANDLE handle = INVALID_HANDLE_VALUE;
+        HANDLE mapping = NULL;
+#else
+        int fd = -1;
+#endif
+        // 预读窗口方式
+        std::vector<uint8_t> window;
+        uint64_t windowStart = 0;
+        size_t windowLength = 0;
+        size_t fillSize = 0;                // 自适应填充量: 顺序读翻倍增长，跳转后回到最小值
+    };
+
+    static constexpr size_t MinFill = 64 * 1024;
+
+    static MappedVfs* self(ma_vfs* vfs) { return static_cast<MappedVfs*>(vfs); }
+
+    void count(std::atomic<uint64_t>& c, uint64_t n = 1) { c.fetch_add(n, std::memory_order_relaxed); }
+
+    static ma_result onOpen(ma_vfs* vfs, const char* path, ma_uint32 mode, ma_vfs_file* out) {
+        if (!path) return MA_INVALID_ARGS;
+        return self(vfs)->open(std::filesystem::u8path(path), mode, out);
+    }
+
+    static ma_result onOpenW(ma_vfs* vfs, const wchar_t* path, ma_uint32 mode, ma_vfs_file* out) {
+        if (!path) return MA_INVALID_ARGS;
+        return self(vfs)->open(std::filesystem::path(path), mode, out);
+    }
+
+    ma_result open(const std::filesystem::path& path, ma_uint32 mode, ma_vfs_file* out) {
+        if (!out) return MA_INVALID_ARGS;
+        *out = NULL;
+        if ((mode & MA_OPEN_MODE_READ) == 0 || (mode & ~static_cast<ma_uint32>(MA_OPEN_MODE_READ)) != 0) {
+            return MA_INVALID_OPERATION;    // 只读
+        }
+        File* f = new (std::nothrow) File();
+        if (!f) return MA_OUT_OF_MEMORY;
+        count(opens);
+
+#ifdef _WIN32
+        count(syscalls, 2);
+        f->handle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        LARGE_INTEGER size{};
+        if (f->handle == INVALID_HANDLE_VALUE || !GetFileSizeEx(f->handle, &size)) {
+            closeFile(f);
+            return MA_DOES_NOT_EXIST;
+        }
+        f->size = static_cast<uint64_t>(size.QuadPart);
+        if (f->size > 0 && f->size <= SIZE_MAX && mappingEnabled.load(std::memory_order_relaxed) && !isNetworkPath(path)) {
+            count(syscalls, 2);
+            f->mapping = CreateFileMappingW(f->handle, NULL, PAGE_READONLY, 0, 0, NULL);
+            if (f->mapping) f->data = static_cast<const uint8_t*>(MapViewOfFile(f->mapping, FILE_MAP_READ, 0, 0, 0));
+        }
+#else
+        count(syscalls, 2);
+        f->fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat st;
+        if (f->fd < 0 || fstat(f->fd, &st) != 0) {
+            closeFile(f);
+            return MA_DOES_NOT_EXIST;
+        }
+        f->size = static_cast<uint64_t>(st.st_size);
+        if (f->size > 0 && f->size <= SIZE_MAX && mappingEnabled.load(std::memory_order_relaxed) && !isNetworkPath(path)) {
+            count(syscalls, 2);
+            void* p = mmap(NULL, static_cast<size_t>(f->size), PROT_READ, MAP_PRIVATE, f->fd, 0);
+            if (p != MAP_FAILED) {
+                f->data = static_cast<const uint8_t*>(p);
+                madvise(p, static_cast<size_t>(f->size), MADV_SEQUENTIAL);
+            }
+        }
+#endif
+        if (f->data) {
+            count(mappedOpens);
+        }
+        else {
+            count(windowOpens);
+            f->window.resize(windowSize.load(std::memory_order_relaxed));
+        }
+        *out = f;
+        return MA_SUCCESS;
+    }
+
+    void closeFile(File* f) {
+#ifdef _WIN32
+        if (f->data) { UnmapViewOfFile(f->data); count(syscalls); }
+        if (f->mapping) { CloseHandle(f->mapping); count(syscalls); }
+        if (f->handle != INVALID_HANDLE_VALUE) { CloseHandle(f->handle); count(syscalls); }
+#else
+        if (f->data) { munmap(const_cast<uint8_t*>(f->data), static_cast<size_t>(f->size)); count(syscalls); }
+        if (f->fd >= 0) { ::close(f->fd); count(syscalls); }
+#endif
+        delete f;
+    }
+
+    static ma_result onClose(ma_vfs* vfs, ma_vfs_file file) {
+        if (!file) return MA_INVALID_ARGS;
+        self(vfs)->closeFile(static_cast<File*>(file));
+        return MA_SUCCESS;
+    }
+
+    static ma_result onRead(ma_vfs* vfs, ma_vfs_file file, void* dst, size_t bytes, size_t* bytesRead) {
+        if (!file || (!dst && bytes > 0)) return MA_INVALID_ARGS;
+        MappedVfs* v = self(vfs);
+        File* f = static_cast<File*>(file);
+        v->count(v->readCalls);
+        size_t n = 0;
+        ma_result result = f->data ? readMapped(f, dst, bytes, n) : v->readWindowed(f, dst, bytes, n);
+        if (bytesRead) *bytesRead = n;
+        v->count(v->bytesRead, n);
+        return result;
+    }
+
+    static ma_result readMapped(File* f, void* dst, size_t bytes, size_t& n) {
+        if (f->cursor >= f->size) return MA_SUCCESS;
+        n = static_cast<size_t>(std::min<uint64_t>(bytes, f->size - f->cursor));
+        std::memcpy(dst, f->data + f->cursor, n);
+        f->cursor += n;
+        return MA_SUCCESS;
+    }
+
+    // 窗口内命中直接复制；大块读绕过窗口；否则从游标处重新填充窗口。
+    // 紧接上一窗口的顺序读把填充量翻倍直到窗口大小，跳转后只读 MinFill，避免为一次跳转读入整个窗口
+    ma_result readWindowed(File* f, void* dst, size_t bytes, size_t& n) {
+        uint8_t* out = static_cast<uint8_t*>(dst);
+        while (n < bytes && f->cursor < f->size) {
+            if (f->cursor >= f->windowStart && f->cursor < f->windowStart + f->windowLength) {
+                size_t offset = static_cast<size_t>(f->cursor - f->windowStart);
+                size_t chunk = std::min(bytes - n, f->windowLength - offset);
+                std::memcpy(out + n, f->window.data() + offset, chunk);
+                n += chunk;
+                f->cursor += chunk;
+                continue;
+            }
+            size_t remaining = bytes - n;
+            if (remaining >= MinFill) {
+                size_t got = 0;
+                if (!readAt(f, f->cursor, out + n, remaining, got)) return n ? MA_SUCCESS : MA_ERROR;
+                if (got == 0) break;
+                n += got;
+                f->cursor += got;
+                continue;
+            }
+            const bool sequential = f->windowLength > 0 && f->cursor == f->windowStart + f->windowLength;
+            f->fillSize = sequential ? std::min(f->fillSize * 2, f->window.size()) : std::min(MinFill, f->window.size());
+            size_t got = 0;
+            if (!readAt(f, f->cursor, f->window.data(), f->fillSize, got)) return n ? MA_SUCCESS : MA_ERROR;
+            f->windowStart = f->cursor;
+            f->windowLength = got;
+            if (got == 0) break;
+        }
+        return MA_SUCCESS;
+    }
+
+    bool readAt(File* f, uint64_t offset, void* dst, size_t bytes, size_t& got) {
+        count(syscalls);
+#ifdef _WIN32
+        OVERLAPPED ov{};
+        ov.Offset = static_cast<DWORD>(offset & 0xFFFFFFFFu);
+        ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        DWORD read = 0;
+        DWORD request = static_cast<DWORD>(std::min<size_t>(bytes, 0x7FFFFFFF));
+        if (!ReadFile(f->handle, dst, request, &read, &ov) && GetLastError() != ERROR_HANDLE_EOF) return false;
+        got = read;
+#else
+        ssize_t r = pread(f->fd, dst, bytes, static_cast<off_t>(offset));
+        if (r < 0) return false;
+        got = static_cast<size_t>(r);
+#endif
+        count(osBytes, got);
+        return true;
+    }
+
+    static ma_result onWrite(ma_vfs*, ma_vfs_file, const void*, size_t, size_t* written) {
+        if (written) *written = 0;
+        return MA_INVALID_OPERATION;
+    }
+
+    // 跳转只改游标，不发系统调用
+    static ma_result onSeek(ma_vfs* vfs, ma_vfs_file file, ma_int64 offset, ma_seek_origin origin) {
+        if (!file) return MA_INVALID_ARGS;
+        MappedVfs* v = self(vfs);
+        File* f = static_cast<File*>(file);
+        v->count(v->seekCalls);
+        int64_t base = 0;
+        if (origin == ma_seek_origin_current) base = static_cast<int64_t>(f->cursor);
+        else if (origin == ma_seek_origin_end) base = static_cast<int64_t>(f->size);
+        int64_t target = base + offset;
+        if (target < 0) return MA_BAD_SEEK;
+        f->cursor = static_cast<uint64_t>(target);
+        return MA_SUCCESS;
+    }
+
+    static ma_result onTell(ma_vfs*, ma_vfs_file file, ma_int64* cursor) {
+        if (!file || !cursor) return MA_INVALID_ARGS;
+        *cursor = static_cast<ma_int64>(static_cast<File*>(file)->cursor);
+        return MA_SUCCESS;
+    }
+
+    static ma_result onInfo(ma_vfs*, ma_vfs_file file, ma_file_info* info) {
+        if (!file || !info) return MA_INVALID_ARGS;
+        info->sizeInBytes = static_cast<File*>(file)->size;
+        return MA_SUCCESS;
+    }
+};
+
+} // namespace mvfs